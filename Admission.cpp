@@ -0,0 +1,299 @@
+#include "headers.h"
+#include <vector>
+#include <set>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Admission control - ban/allow checks for new connections without going through python:
+
+	OnConnect - the players ip is looked up in a binary radix tree of ipv4 prefixes (longest prefix wins,
+		so an allow range can punch a hole in a ban range), then the per ip connection rate is checked
+		(at most iRateMax connections per iRateWindow ms, tracked in a small direct mapped table)
+	Login - the account id is checked against the account ban set, with a bloom filter in front so the
+		usual case (not banned) never touches the set
+
+Allowed ips skip the rate check. A rejected client is kicked by FLHooks kick timer and python gets an
+AdmissionRejected event instead of the OnConnect/Login callbacks, and none of its other per client
+callbacks (ADMISSION_CHECK) until it is gone; a flagged client (rate action
+ADM_FLAG) is let in and reported with AdmissionFlagged. Rules come from FLHook.AdmissionAddIP(),
+FLHook.AdmissionBanAccount() or a file loaded with FLHook.AdmissionLoad().
+*/
+ADMISSION_STATS AdmissionStats;
+
+#define ADM_BLOOM_BITS (1 << 16)
+#define ADM_RATE_SLOTS 1024
+#define ADM_KICK_DELAY 1000 // ms, lets the kick timer pick it up
+
+struct ADM_NODE
+{
+	uint iChild[2]; // index into vAdmNodes, 0 for none (the root is never a child)
+	ADM_VERDICT verdict; // for the prefix ending here
+};
+
+struct ADM_RATE
+{
+	uint iIP;
+	mstime tmWindowStart;
+	uint iCount;
+};
+
+static vector<ADM_NODE> vAdmNodes(1);
+static set<wstring> setBannedAccounts;
+static unsigned char BloomBits[ADM_BLOOM_BITS / 8];
+static ADM_RATE RateTable[ADM_RATE_SLOTS];
+static uint iRateMax = 0; // 0 for no rate check
+static uint iRateWindow = 10000;
+static ADM_VERDICT rateAction = ADM_REJECT;
+static bool bRejected[MAX_CLIENT_ID + 1]; // dont send this clients callbacks to python
+
+static bool ParseIP(const wstring &wscIP, uint &iIP)
+{
+	uint a, b, c, d;
+	if (swscanf(wscIP.c_str(), L"%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255)
+		return false;
+	iIP = (a << 24) | (b << 16) | (c << 8) | d;
+	return true;
+}
+
+static bool ParseCIDR(const wstring &wscCIDR, uint &iIP, uint &iBits)
+{
+	iBits = 32;
+	size_t iSlash = wscCIDR.find(L'/');
+	if (iSlash != wstring::npos) {
+		// wcstoul gives 0 for '1.2.3.4/' or '1.2.3.4/x', that must not turn into a /0 rule
+		const wchar_t *wszBits = wscCIDR.c_str() + iSlash + 1;
+		wchar_t *wszEnd;
+		if (*wszBits < L'0' || *wszBits > L'9')
+			return false;
+		iBits = wcstoul(wszBits, &wszEnd, 10);
+		if (*wszEnd || iBits > 32)
+			return false;
+	}
+	if (!ParseIP(wscCIDR.substr(0, iSlash), iIP))
+		return false;
+	if (iBits < 32)
+		iIP &= ~(0xFFFFFFFFu >> iBits);
+	return true;
+}
+
+// 2 hashes from one FNV-1a run, the k probes are combined from them
+static void BloomHashes(const wstring &wscAccount, uint &h1, uint &h2)
+{
+	h1 = 2166136261u;
+	for (uint i = 0; i < wscAccount.length(); i++)
+		h1 = (h1 ^ (ushort)wscAccount[i]) * 16777619u;
+	h2 = (h1 >> 16) | (h1 << 16);
+	h2 = h2 * 0x85EBCA6Bu + 1;
+}
+
+static void BloomAdd(const wstring &wscAccount)
+{
+	uint h1, h2;
+	BloomHashes(wscAccount, h1, h2);
+	for (uint k = 0; k < ADM_BLOOM_K; k++) {
+		uint iBit = (h1 + k * h2) % ADM_BLOOM_BITS;
+		BloomBits[iBit / 8] |= 1 << (iBit % 8);
+	}
+}
+
+static bool BloomMaybe(const wstring &wscAccount)
+{
+	uint h1, h2;
+	BloomHashes(wscAccount, h1, h2);
+	for (uint k = 0; k < ADM_BLOOM_K; k++) {
+		uint iBit = (h1 + k * h2) % ADM_BLOOM_BITS;
+		if (!(BloomBits[iBit / 8] & (1 << (iBit % 8))))
+			return false;
+	}
+	return true;
+}
+
+static ADM_VERDICT LookupIP(uint iIP)
+{
+	ADM_VERDICT verdict = vAdmNodes[0].verdict;
+	uint iNode = 0;
+	for (uint i = 0; i < 32; i++) {
+		iNode = vAdmNodes[iNode].iChild[(iIP >> (31 - i)) & 1];
+		if (!iNode)
+			break;
+		if (vAdmNodes[iNode].verdict != ADM_NONE)
+			verdict = vAdmNodes[iNode].verdict;
+	}
+	return verdict;
+}
+
+static bool RateExceeded(uint iIP)
+{
+	if (!iRateMax)
+		return false;
+	mstime tmNow = timeInMS();
+	ADM_RATE &rate = RateTable[(iIP * 2654435761u) >> 22];
+	if (rate.iIP != iIP || tmNow - rate.tmWindowStart > iRateWindow) {
+		rate.iIP = iIP;
+		rate.tmWindowStart = tmNow;
+		rate.iCount = 0;
+	}
+	return ++rate.iCount > iRateMax;
+}
+
+static void Reject(uint iClientID, const wstring &wscIP, const char *szReason)
+{
+	bRejected[iClientID] = true;
+	ClientInfo[iClientID].tmKickTime = timeInMS() + ADM_KICK_DELAY;
+	pyCallback("AdmissionRejected", Py_BuildValue("INs", iClientID, ToPython(wscIP), szReason));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool AdmissionAddIP(const wstring &wscCIDR, ADM_VERDICT verdict)
+{
+	uint iIP, iBits;
+	if (!ParseCIDR(wscCIDR, iIP, iBits))
+		return false;
+
+	uint iNode = 0;
+	for (uint i = 0; i < iBits; i++) {
+		uint iBit = (iIP >> (31 - i)) & 1;
+		if (!vAdmNodes[iNode].iChild[iBit]) {
+			ADM_NODE node = { { 0, 0 }, ADM_NONE };
+			vAdmNodes.push_back(node);
+			vAdmNodes[iNode].iChild[iBit] = vAdmNodes.size() - 1;
+		}
+		iNode = vAdmNodes[iNode].iChild[iBit];
+	}
+	if (vAdmNodes[iNode].verdict == ADM_NONE && verdict != ADM_NONE)
+		AdmissionStats.iIPRules++;
+	else if (vAdmNodes[iNode].verdict != ADM_NONE && verdict == ADM_NONE)
+		AdmissionStats.iIPRules--;
+	vAdmNodes[iNode].verdict = verdict; // ADM_NONE removes the rule, the nodes stay
+	return true;
+}
+
+void AdmissionBanAccount(const wstring &wscAccount, bool bBanned)
+{
+	if (bBanned) {
+		setBannedAccounts.insert(wscAccount);
+		BloomAdd(wscAccount);
+	}
+	else if (setBannedAccounts.erase(wscAccount)) { // bloom filters cant remove, rebuild it
+		memset(BloomBits, 0, sizeof(BloomBits));
+		for (set<wstring>::iterator it = setBannedAccounts.begin(); it != setBannedAccounts.end(); ++it)
+			BloomAdd(*it);
+	}
+	AdmissionStats.iAccounts = setBannedAccounts.size();
+}
+
+void AdmissionSetRate(uint iMax, uint iWindow, ADM_VERDICT action)
+{
+	iRateMax = iMax;
+	iRateWindow = iWindow;
+	rateAction = action;
+	memset(RateTable, 0, sizeof(RateTable));
+}
+
+void AdmissionClear()
+{
+	vAdmNodes.clear();
+	vAdmNodes.resize(1);
+	vAdmNodes[0].iChild[0] = vAdmNodes[0].iChild[1] = 0;
+	vAdmNodes[0].verdict = ADM_NONE;
+	setBannedAccounts.clear();
+	memset(BloomBits, 0, sizeof(BloomBits));
+	AdmissionStats.iIPRules = AdmissionStats.iAccounts = 0;
+}
+
+/*
+File format, one rule per line, # for comments:
+	ban 10.0.0.0/8
+	allow 10.1.2.3
+	account 1a2b3c4d-...
+*/
+int AdmissionLoad(const string &scPath)
+{
+	FILE *f = fopen(scPath.c_str(), "r");
+	if (!f)
+		return -1;
+	int iRules = 0;
+	char szLine[256];
+	while (fgets(szLine, sizeof(szLine), f)) {
+		char szType[16], szValue[128];
+		if (szLine[0] == '#' || sscanf(szLine, "%15s %127s", szType, szValue) != 2)
+			continue;
+		wstring wscValue = stows(szValue);
+		if (!strcmp(szType, "ban"))
+			iRules += AdmissionAddIP(wscValue, ADM_REJECT) ? 1 : 0;
+		else if (!strcmp(szType, "allow"))
+			iRules += AdmissionAddIP(wscValue, ADM_ALLOW) ? 1 : 0;
+		else if (!strcmp(szType, "account")) {
+			AdmissionBanAccount(wscValue, true);
+			iRules++;
+		}
+	}
+	fclose(f);
+	return iRules;
+}
+
+bool AdmissionConnect(uint iClientID)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return true;
+	bRejected[iClientID] = false;
+
+	wstring wscIP;
+	uint iIP;
+	HkGetPlayerIP(iClientID, wscIP);
+	if (!ParseIP(wscIP, iIP)) {
+		AdmissionStats.iAdmitted++;
+		return true;
+	}
+
+	ADM_VERDICT verdict = LookupIP(iIP);
+	if (verdict == ADM_REJECT) {
+		AdmissionStats.iRejectedIP++;
+		Reject(iClientID, wscIP, "ip");
+		return false;
+	}
+	if (verdict != ADM_ALLOW && RateExceeded(iIP)) {
+		if (rateAction == ADM_REJECT) {
+			AdmissionStats.iRejectedRate++;
+			Reject(iClientID, wscIP, "rate");
+			return false;
+		}
+		AdmissionStats.iFlagged++;
+		pyCallback("AdmissionFlagged", Py_BuildValue("INs", iClientID, ToPython(wscIP), "rate"));
+	}
+	AdmissionStats.iAdmitted++;
+	return true;
+}
+
+bool AdmissionLogin(const wstring &wscAccount, uint iClientID)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return true;
+	if (bRejected[iClientID])
+		return false;
+	if (!BloomMaybe(wscAccount))
+		return true;
+
+	AdmissionStats.iBloomHits++;
+	if (setBannedAccounts.find(wscAccount) == setBannedAccounts.end()) {
+		AdmissionStats.iBloomFalsePositives++;
+		return true;
+	}
+	wstring wscIP;
+	HkGetPlayerIP(iClientID, wscIP);
+	AdmissionStats.iRejectedAccount++;
+	Reject(iClientID, wscIP, "account");
+	return false;
+}
+
+bool AdmissionRejected(uint iClientID)
+{
+	return iClientID <= MAX_CLIENT_ID && bRejected[iClientID];
+}
+
+void AdmissionDisconnect(uint iClientID)
+{
+	if (iClientID <= MAX_CLIENT_ID)
+		bRejected[iClientID] = false;
+}
@@ -0,0 +1,283 @@
+#include "headers.h"
+#include <map>
+#include <stdio.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Async file jobs - keeps disk writes scripts ask for out of the hook that asked.
+
+FLHook.SaveCharAsync() queues a character save instead of doing it right away. Saving goes through FL's own
+pub::Save (live game state) so it still runs on the game thread, but at the end of the tick, and every save of
+the same character asked for within the window collapses into one: a script saving on every transaction
+makes one save per window. A queued save runs early when the player disconnects.
+
+FLHook.WriteFileAsync() hands a file write to the I/O thread, which does the actual disk work. A whole file
+write replaces anything still queued for the same path, and appends to a path are joined with the one
+queued before them, so a file rewritten 10 times in a tick is written once. Whole files are written to a
+.tmp file and renamed over the old one, a crash mid write leaves the old file.
+
+Both report back on the game thread at the end of a tick, with the AsyncSaveChar (charname, error, merged)
+and AsyncWriteFile (path, ok, merged) events.
+*/
+ASYNC_STATS AsyncStats;
+
+struct SAVE_JOB
+{
+	wstring wscCharname;
+	mstime tmDue;
+	uint iMerged; // requests after the first
+};
+
+struct SAVE_RESULT
+{
+	wstring wscCharname;
+	HK_ERROR hkErr;
+	uint iMerged;
+};
+
+struct WRITE_JOB
+{
+	string scPath;
+	string scData;
+	bool bAppend;
+	uint iMerged;
+};
+
+struct WRITE_RESULT
+{
+	string scPath;
+	bool bOK;
+	uint iMerged;
+};
+
+static map<wstring, SAVE_JOB> mapSaveJobs; // by lower case charname
+static list<SAVE_RESULT> lstSaveResults;
+
+static HANDLE hIOThread = NULL;
+static HANDLE hIOEvent = NULL;
+static CRITICAL_SECTION csIO; // guards lstWriteJobs, lstWriteResults and bIOStop
+static list<WRITE_JOB> lstWriteJobs;
+static list<WRITE_RESULT> lstWriteResults;
+static bool bIOStop = false;
+
+static bool WriteJob(const WRITE_JOB &job)
+{
+	if (job.bAppend) {
+		FILE *f = fopen(job.scPath.c_str(), "ab");
+		if (!f)
+			return false;
+		bool bOK = fwrite(job.scData.data(), 1, job.scData.size(), f) == job.scData.size();
+		return fclose(f) == 0 && bOK;
+	}
+	string scTemp = job.scPath + ".tmp";
+	FILE *f = fopen(scTemp.c_str(), "wb");
+	if (!f)
+		return false;
+	bool bOK = fwrite(job.scData.data(), 1, job.scData.size(), f) == job.scData.size();
+	if (fclose(f) != 0 || !bOK) {
+		DeleteFile(scTemp.c_str());
+		return false;
+	}
+	return MoveFileEx(scTemp.c_str(), job.scPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+static DWORD WINAPI AsyncIOThread(LPVOID lpParam)
+{
+	for (;;) {
+		WaitForSingleObject(hIOEvent, INFINITE);
+		for (;;) {
+			EnterCriticalSection(&csIO);
+			if (lstWriteJobs.empty()) {
+				bool bStop = bIOStop;
+				LeaveCriticalSection(&csIO);
+				if (bStop)
+					return 0;
+				break;
+			}
+			WRITE_JOB job = lstWriteJobs.front(); // copied so the queue can take new jobs while this writes
+			lstWriteJobs.pop_front();
+			LeaveCriticalSection(&csIO);
+
+			WRITE_RESULT result;
+			result.scPath = job.scPath;
+			result.iMerged = job.iMerged;
+			result.bOK = WriteJob(job);
+
+			EnterCriticalSection(&csIO);
+			lstWriteResults.push_back(result);
+			LeaveCriticalSection(&csIO);
+		}
+	}
+}
+
+static void StartIOThread()
+{
+	InitializeCriticalSection(&csIO);
+	hIOEvent = CreateEvent(NULL, FALSE, FALSE, NULL); // auto reset
+	bIOStop = false;
+	hIOThread = CreateThread(NULL, 0, AsyncIOThread, NULL, 0, NULL);
+}
+
+static void RunSave(const SAVE_JOB &job)
+{
+	SAVE_RESULT result;
+	result.wscCharname = job.wscCharname;
+	result.hkErr = HkSaveChar(job.wscCharname);
+	IniCacheInvalidateChar(job.wscCharname);
+	result.iMerged = job.iMerged;
+	lstSaveResults.push_back(result);
+	if (result.hkErr == HKE_OK)
+		AsyncStats.iSaves++;
+	else
+		AsyncStats.iFailed++;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SaveCharAsync(const wstring &wscCharname, uint iWindow)
+{
+	AsyncStats.iSavesQueued++;
+	wstring wscKey = ToLower(wscCharname);
+	map<wstring, SAVE_JOB>::iterator it = mapSaveJobs.find(wscKey);
+	if (it != mapSaveJobs.end()) {
+		it->second.iMerged++;
+		AsyncStats.iMerged++;
+		return;
+	}
+	SAVE_JOB &job = mapSaveJobs[wscKey];
+	job.wscCharname = wscCharname;
+	job.tmDue = timeInMS() + iWindow;
+	job.iMerged = 0;
+}
+
+// called from the DisConnect hook, the save has to happen while the player is still there
+void SaveCharAsyncFlushClient(uint iClientID)
+{
+	if (mapSaveJobs.empty())
+		return;
+	const wchar_t *wszCharname = Players.GetActiveCharacterName(iClientID);
+	if (!wszCharname)
+		return;
+	map<wstring, SAVE_JOB>::iterator it = mapSaveJobs.find(ToLower(wszCharname));
+	if (it == mapSaveJobs.end())
+		return;
+	RunSave(it->second); // the event goes out with the next tick's results
+	mapSaveJobs.erase(it);
+}
+
+void WriteFileAsync(const string &scPath, const string &scData, bool bAppend)
+{
+	if (!hIOThread)
+		StartIOThread();
+	AsyncStats.iWritesQueued++;
+	EnterCriticalSection(&csIO);
+	bool bMerged = false;
+	uint iReplaced = 0;
+	if (!bAppend) { // replaces anything not yet written to the path
+		for (list<WRITE_JOB>::iterator it = lstWriteJobs.begin(); it != lstWriteJobs.end(); ) {
+			if (it->scPath == scPath) {
+				iReplaced += it->iMerged + 1;
+				it = lstWriteJobs.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+	else {
+		for (list<WRITE_JOB>::reverse_iterator it = lstWriteJobs.rbegin(); it != lstWriteJobs.rend(); ++it) {
+			if (it->scPath != scPath)
+				continue;
+			it->scData += scData; // a write or append of the path still queued, this goes after it either way
+			it->iMerged++;
+			AsyncStats.iMerged++;
+			bMerged = true;
+			break;
+		}
+	}
+	if (!bMerged) {
+		WRITE_JOB job;
+		job.scPath = scPath;
+		job.scData = scData;
+		job.bAppend = bAppend;
+		job.iMerged = iReplaced;
+		lstWriteJobs.push_back(job);
+		AsyncStats.iMerged += iReplaced;
+	}
+	LeaveCriticalSection(&csIO);
+	SetEvent(hIOEvent);
+}
+
+// runs the due saves and reports finished writes, from HkCb_Update_Time_AFTER
+void AsyncTick()
+{
+	if (!mapSaveJobs.empty()) {
+		mstime tmNow = timeInMS();
+		for (map<wstring, SAVE_JOB>::iterator it = mapSaveJobs.begin(); it != mapSaveJobs.end(); ) {
+			if (it->second.tmDue > tmNow) {
+				++it;
+				continue;
+			}
+			RunSave(it->second);
+			mapSaveJobs.erase(it++);
+		}
+	}
+	while (!lstSaveResults.empty()) {
+		SAVE_RESULT &result = lstSaveResults.front();
+		pyCallback("AsyncSaveChar", Py_BuildValue("sII", wstos(result.wscCharname).c_str(), result.hkErr, result.iMerged));
+		lstSaveResults.pop_front();
+	}
+
+	if (!hIOThread)
+		return;
+	list<WRITE_RESULT> lstResults;
+	EnterCriticalSection(&csIO);
+	lstResults.swap(lstWriteResults);
+	LeaveCriticalSection(&csIO);
+	for (list<WRITE_RESULT>::iterator it = lstResults.begin(); it != lstResults.end(); ++it) {
+		if (it->bOK)
+			AsyncStats.iWrites++;
+		else
+			AsyncStats.iFailed++;
+		pyCallback("AsyncWriteFile", Py_BuildValue("sOI", it->scPath.c_str(), PY_BOOL(it->bOK), it->iMerged));
+	}
+}
+
+// runs every queued save and waits for the I/O thread to finish writing, at server shutdown
+void AsyncShutdown()
+{
+	while (!mapSaveJobs.empty()) {
+		HkSaveChar(mapSaveJobs.begin()->second.wscCharname);
+		IniCacheInvalidateChar(mapSaveJobs.begin()->second.wscCharname);
+		mapSaveJobs.erase(mapSaveJobs.begin());
+	}
+	lstSaveResults.clear();
+	if (!hIOThread)
+		return;
+	EnterCriticalSection(&csIO);
+	bIOStop = true;
+	LeaveCriticalSection(&csIO);
+	SetEvent(hIOEvent);
+	if (WaitForSingleObject(hIOThread, 10000) != WAIT_OBJECT_0) {
+		// still writing (or stuck), it keeps using csIO, hIOEvent and the lists, so they're leaked rather then
+		// pulled from under it. hIOThread stays set, nothing may start a second thread on the same csIO
+		ERRMSG(L"WARNING async I/O thread did not stop, leaving it running");
+		return;
+	}
+	CloseHandle(hIOThread);
+	CloseHandle(hIOEvent);
+	DeleteCriticalSection(&csIO);
+	hIOThread = NULL;
+	lstWriteJobs.clear();
+	lstWriteResults.clear();
+}
+
+uint AsyncPending()
+{
+	uint iPending = mapSaveJobs.size();
+	if (hIOThread) {
+		EnterCriticalSection(&csIO);
+		iPending += lstWriteJobs.size();
+		LeaveCriticalSection(&csIO);
+	}
+	return iPending;
+}
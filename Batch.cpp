@@ -0,0 +1,208 @@
+#include "headers.h"
+#include <map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Batch mutations - FLHook.AddCashBatch(), SetRepBatch(), AddCargoBatch() and MsgBatch() take a sequence of
+tuples, the first item of each the target (a charname or a client id), and apply them all in one call. All
+the tuples are parsed and their targets resolved before anything is applied, so a malformed one raises
+without half the batch done. Failures of the operation itself don't raise, each item gets its HK_ERROR
+(HKE_OK for success) in the tuple returned.
+
+A target that's online is passed on to HkAddCash/HkSetRep/HkAddCargo as "id <client id>", so FLHook doesn't look
+the charname up again (and the client resolved here is the one changed); offline targets go by charname.
+
+MsgBatch encodes each distinct text once and sends the encoded message to every target with it, rather than
+HkMsg encoding it again per player.
+*/
+struct BATCH_TARGET
+{
+	wstring wscCharname;
+	wstring wscHkTarget; // what the Hk functions get, "id <client id>" if online
+	uint iClientID; // 0 if not online
+	HK_ERROR hkErr; // HKE_OK if the target resolved
+};
+
+static BATCH_TARGET BatchTarget(PyObject *pTarget)
+{
+	BATCH_TARGET target;
+	target.iClientID = 0;
+	target.hkErr = HKE_OK;
+	if (PyInt_Check(pTarget) || PyLong_Check(pTarget)) {
+		uint iClientID = (uint)PyInt_AsUnsignedLongMask(pTarget);
+		const wchar_t *wszCharname = HkIsValidClientID(iClientID) ? Players.GetActiveCharacterName(iClientID) : NULL;
+		if (!wszCharname) {
+			target.hkErr = HKE_INVALID_CLIENT_ID;
+			return target;
+		}
+		target.wscCharname = wszCharname;
+		target.iClientID = iClientID;
+		target.wscHkTarget = L"id " + to_wstring(iClientID);
+		return target;
+	}
+	target.wscCharname = pyunitows(pTarget);
+	target.wscHkTarget = target.wscCharname;
+	uint iClientID = HkGetClientIdFromCharname(target.wscCharname);
+	if (HkIsValidClientID(iClientID)) {
+		target.iClientID = iClientID;
+		target.wscHkTarget = L"id " + to_wstring(iClientID);
+	}
+	return target;
+}
+
+static PyObject* BatchResult(const vector<HK_ERROR> &vErrors)
+{
+	PyObject *pResult = PyTuple_New(vErrors.size());
+	for (uint i = 0; i < vErrors.size(); i++)
+		PyTuple_SET_ITEM(pResult, i, PyInt_FromLong(vErrors[i]));
+	return pResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// items: (target, int amount)
+PyObject* BatchAddCash(PyObject *pItems)
+{
+	PyObject *pSeq = PySequence_Fast(pItems, "expected a sequence of (target, amount) tuples");
+	if (!pSeq)
+		return NULL;
+	Py_ssize_t iCount = PySequence_Fast_GET_SIZE(pSeq);
+	vector<BATCH_TARGET> vTargets(iCount);
+	vector<int> vAmounts(iCount);
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		PyObject *pTarget;
+		if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(pSeq, i), "Oi", &pTarget, &vAmounts[i])) {
+			Py_DECREF(pSeq);
+			return NULL;
+		}
+		vTargets[i] = BatchTarget(pTarget);
+	}
+	Py_DECREF(pSeq);
+
+	vector<HK_ERROR> vErrors(iCount);
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		if ((vErrors[i] = vTargets[i].hkErr) != HKE_OK)
+			continue;
+		vErrors[i] = HkAddCash(vTargets[i].wscHkTarget, vAmounts[i]);
+		if (vErrors[i] == HKE_OK && bChangeFeed)
+			ChangeFeedDirty(vTargets[i].iClientID, CHG_CASH);
+	}
+	return BatchResult(vErrors);
+}
+
+// items: (target, str faction, float value)
+PyObject* BatchSetRep(PyObject *pItems)
+{
+	PyObject *pSeq = PySequence_Fast(pItems, "expected a sequence of (target, faction, value) tuples");
+	if (!pSeq)
+		return NULL;
+	Py_ssize_t iCount = PySequence_Fast_GET_SIZE(pSeq);
+	vector<BATCH_TARGET> vTargets(iCount);
+	vector<wstring> vFactions(iCount);
+	vector<float> vValues(iCount);
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		PyObject *pTarget, *pFaction;
+		if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(pSeq, i), "OOf", &pTarget, &pFaction, &vValues[i])) {
+			Py_DECREF(pSeq);
+			return NULL;
+		}
+		vTargets[i] = BatchTarget(pTarget);
+		vFactions[i] = pytows(pFaction);
+	}
+	Py_DECREF(pSeq);
+
+	vector<HK_ERROR> vErrors(iCount);
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		if ((vErrors[i] = vTargets[i].hkErr) == HKE_OK)
+			vErrors[i] = HkSetRep(vTargets[i].wscHkTarget, vFactions[i], vValues[i]);
+	}
+	return BatchResult(vErrors);
+}
+
+// items: (target, good, int count[, bool mission]), good is a nickname or an archetype id
+PyObject* BatchAddCargo(PyObject *pItems)
+{
+	PyObject *pSeq = PySequence_Fast(pItems, "expected a sequence of (target, good, count, mission) tuples");
+	if (!pSeq)
+		return NULL;
+	Py_ssize_t iCount = PySequence_Fast_GET_SIZE(pSeq);
+	vector<BATCH_TARGET> vTargets(iCount);
+	vector<wstring> vGoods(iCount);
+	vector<uint> vGoodIDs(iCount);
+	vector<int> vCounts(iCount);
+	vector<bool> vMission(iCount);
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		PyObject *pTarget, *pGood, *pMission = Py_False;
+		if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(pSeq, i), "OOi|O", &pTarget, &pGood, &vCounts[i], &pMission)) {
+			Py_DECREF(pSeq);
+			return NULL;
+		}
+		vTargets[i] = BatchTarget(pTarget);
+		if (PyInt_Check(pGood) || PyLong_Check(pGood))
+			vGoodIDs[i] = (uint)PyInt_AsUnsignedLongMask(pGood);
+		else
+			vGoods[i] = pytows(pGood);
+		vMission[i] = PyObject_IsTrue(pMission) == 1;
+	}
+	Py_DECREF(pSeq);
+
+	vector<HK_ERROR> vErrors(iCount);
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		if ((vErrors[i] = vTargets[i].hkErr) != HKE_OK)
+			continue;
+		if (vGoodIDs[i])
+			vErrors[i] = HkAddCargo(vTargets[i].wscHkTarget, vGoodIDs[i], vCounts[i], vMission[i]);
+		else
+			vErrors[i] = HkAddCargo(vTargets[i].wscHkTarget, vGoods[i], vCounts[i], vMission[i]);
+	}
+	return BatchResult(vErrors);
+}
+
+// items: (target, str text), sent like HkMsg
+PyObject* BatchMsg(PyObject *pItems)
+{
+	PyObject *pSeq = PySequence_Fast(pItems, "expected a sequence of (target, text) tuples");
+	if (!pSeq)
+		return NULL;
+	Py_ssize_t iCount = PySequence_Fast_GET_SIZE(pSeq);
+	vector<BATCH_TARGET> vTargets(iCount);
+	vector<wstring> vTexts(iCount);
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		PyObject *pTarget, *pText;
+		if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(pSeq, i), "OO", &pTarget, &pText)) {
+			Py_DECREF(pSeq);
+			return NULL;
+		}
+		vTargets[i] = BatchTarget(pTarget);
+		vTexts[i] = pyunitows(pText);
+	}
+	Py_DECREF(pSeq);
+
+	map<wstring, string> mapEncoded; // text to the encoded message
+	vector<HK_ERROR> vErrors(iCount);
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		if ((vErrors[i] = vTargets[i].hkErr) != HKE_OK)
+			continue;
+		uint iClientID = vTargets[i].iClientID;
+		if (!iClientID) {
+			vErrors[i] = HKE_PLAYER_NOT_LOGGED_IN;
+			continue;
+		}
+		if (bOutbox) {
+			vErrors[i] = OutboxQueueText(iClientID, vTexts[i], false); // encoded (and checked) once per item then
+			continue;
+		}
+		map<wstring, string>::iterator it = mapEncoded.find(vTexts[i]);
+		if (it == mapEncoded.end()) {
+			char szBuf[0xFFFF];
+			uint iRet = 0;
+			wstring wscXML = L"<TRA data=\"0x19BD3A00\" mask=\"-1\"/><TEXT>" + XMLText(vTexts[i]) + L"</TEXT>"; // HkMsg's style
+			if ((vErrors[i] = HkFMsgEncodeXML(wscXML, szBuf, sizeof(szBuf), iRet)) != HKE_OK)
+				continue;
+			it = mapEncoded.insert(make_pair(vTexts[i], string(szBuf, iRet))).first;
+		}
+		vErrors[i] = HkFMsgSendChat(iClientID, (char*)it->second.data(), it->second.size());
+	}
+	return BatchResult(vErrors);
+}
@@ -0,0 +1,188 @@
+#include "headers.h"
+#include <math.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Change feed - with FLHook.SetChangeFeed(True) the plugin keeps the last known system, base, ship, position
+bucket, cash and connection status of every client, and every time one of them changes appends a record
+(seq, client_id, field, value) to a ring buffer. FLHook.ReadChanges(cursor) returns the records after the
+cursor, so a script syncing a web map or stats database only handles what changed since its last read
+instead of polling and diffing every player every tick.
+
+The hooks only mark a field dirty and store the new value, the compare (and reading the cash) is done once
+per client at the end of the tick, so a ship sending 10 position updates in a tick that stay in the same
+bucket costs nothing in the feed. Position is bucketed to fBucket sized cubes, the value is the bucket
+(x, y, z).
+
+The ring holds CHANGE_RING_SIZE records, a reader that falls further behind then that is told so
+(complete is False) and should resync with GetAllPlayers().
+*/
+bool bChangeFeed = false;
+
+#define CHANGE_RING_SIZE 8192 // records
+
+struct CHANGE_STATE
+{
+	uint iDirty; // 1 << CHANGE_FIELD
+	uint iKnown; // fields with a value in iLast
+	int iPending[CHG_COUNT][3];
+	int iLast[CHG_COUNT][3];
+};
+
+struct CHANGE_RECORD
+{
+	unsigned __int64 iSeq;
+	uint iClientID;
+	uint iField;
+	int iValue[3];
+};
+
+static CHANGE_STATE ChangeState[MAX_CLIENT_ID + 1];
+static list<uint> lstChangeDirty;
+static CHANGE_RECORD ChangeRing[CHANGE_RING_SIZE];
+static unsigned __int64 iChangeSeq = 0; // last record appended
+static float fChangeBucket = 1000.0f;
+
+static void ChangeAppend(uint iClientID, uint iField, const int *iValue)
+{
+	CHANGE_RECORD &rec = ChangeRing[++iChangeSeq % CHANGE_RING_SIZE];
+	rec.iSeq = iChangeSeq;
+	rec.iClientID = iClientID;
+	rec.iField = iField;
+	rec.iValue[0] = iValue[0];
+	rec.iValue[1] = iValue[1];
+	rec.iValue[2] = iValue[2];
+}
+
+static void ChangeMark(uint iClientID, uint iField)
+{
+	CHANGE_STATE &state = ChangeState[iClientID];
+	if (!state.iDirty)
+		lstChangeDirty.push_back(iClientID);
+	state.iDirty |= 1 << iField;
+}
+
+static void ChangeFlushClient(uint iClientID)
+{
+	CHANGE_STATE &state = ChangeState[iClientID];
+	if (!state.iDirty)
+		return;
+	if (state.iDirty & (1 << CHG_CASH)) {
+		int iCash = 0;
+		pub::Player::InspectCash(iClientID, iCash);
+		state.iPending[CHG_CASH][0] = iCash;
+	}
+	for (uint i = 0; i < CHG_COUNT; i++) {
+		if (!(state.iDirty & (1 << i)))
+			continue;
+		if ((state.iKnown & (1 << i)) && !memcmp(state.iPending[i], state.iLast[i], sizeof(state.iLast[i])))
+			continue;
+		memcpy(state.iLast[i], state.iPending[i], sizeof(state.iLast[i]));
+		state.iKnown |= 1 << i;
+		ChangeAppend(iClientID, i, state.iLast[i]);
+	}
+	state.iDirty = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChangeFeedSet(uint iClientID, CHANGE_FIELD field, uint iValue)
+{
+	if (!iClientID || iClientID > MAX_CLIENT_ID)
+		return;
+	int *iPending = ChangeState[iClientID].iPending[field];
+	iPending[0] = iValue;
+	iPending[1] = iPending[2] = 0;
+	ChangeMark(iClientID, field);
+}
+
+void ChangeFeedDirty(uint iClientID, CHANGE_FIELD field)
+{
+	if (iClientID && iClientID <= MAX_CLIENT_ID)
+		ChangeMark(iClientID, field);
+}
+
+void ChangeFeedPosition(uint iClientID, const Vector &vPos)
+{
+	if (!iClientID || iClientID > MAX_CLIENT_ID)
+		return;
+	int *iPending = ChangeState[iClientID].iPending[CHG_POSITION];
+	iPending[0] = (int)floorf(vPos.x / fChangeBucket);
+	iPending[1] = (int)floorf(vPos.y / fChangeBucket);
+	iPending[2] = (int)floorf(vPos.z / fChangeBucket);
+	ChangeMark(iClientID, CHG_POSITION);
+}
+
+// the client's pending changes go out before the disconnect, then it starts over with nothing known
+void ChangeFeedDisconnect(uint iClientID)
+{
+	if (!iClientID || iClientID > MAX_CLIENT_ID)
+		return;
+	ChangeFlushClient(iClientID);
+	static const int iZero[3] = { 0, 0, 0 };
+	ChangeAppend(iClientID, CHG_CONNECTED, iZero);
+	memset(&ChangeState[iClientID], 0, sizeof(CHANGE_STATE)); // its entry on lstChangeDirty is skipped now
+}
+
+void ChangeFeedFlush()
+{
+	while (!lstChangeDirty.empty()) {
+		ChangeFlushClient(lstChangeDirty.front());
+		lstChangeDirty.pop_front();
+	}
+}
+
+// enabling records the current state of everyone connected, so a reader starting at 0 has a baseline
+void SetChangeFeed(bool bEnabled, float fBucket)
+{
+	if (fBucket > 0)
+		fChangeBucket = fBucket;
+	if (bEnabled == bChangeFeed)
+		return;
+	bChangeFeed = bEnabled;
+	lstChangeDirty.clear();
+	memset(ChangeState, 0, sizeof(ChangeState));
+	if (!bEnabled)
+		return;
+	for (uint iClientID = 1; iClientID <= MAX_CLIENT_ID; iClientID++) {
+		if (!HkIsValidClientID(iClientID))
+			continue;
+		ChangeFeedSet(iClientID, CHG_CONNECTED, 1);
+		if (HkIsInCharSelectMenu(iClientID))
+			continue;
+		uint iSystem = 0, iBase = 0, iShip = 0;
+		pub::Player::GetSystem(iClientID, iSystem);
+		pub::Player::GetBase(iClientID, iBase);
+		pub::Player::GetShip(iClientID, iShip);
+		ChangeFeedSet(iClientID, CHG_SYSTEM, iSystem);
+		ChangeFeedSet(iClientID, CHG_BASE, iBase);
+		ChangeFeedSet(iClientID, CHG_SHIP, iShip);
+		ChangeFeedDirty(iClientID, CHG_CASH);
+	}
+}
+
+// (cursor, records, complete), cursor is the seq of the last record returned, pass it back next time
+PyObject* ChangeFeedRead(unsigned __int64 iCursor, uint iMax)
+{
+	unsigned __int64 iOldest = iChangeSeq > CHANGE_RING_SIZE ? iChangeSeq - CHANGE_RING_SIZE + 1 : 1;
+	// a cursor that fell out of the ring, or one from before a restart (ahead of us), lost records: resync
+	bool bComplete = iCursor + 1 >= iOldest && iCursor <= iChangeSeq;
+	unsigned __int64 iFrom = bComplete ? iCursor + 1 : iOldest;
+	unsigned __int64 iCount = iChangeSeq + 1 - iFrom;
+	if (iMax && iCount > iMax)
+		iCount = iMax;
+
+	PyObject *pRecords = PyTuple_New((Py_ssize_t)iCount);
+	for (uint i = 0; i < iCount; i++) {
+		const CHANGE_RECORD &rec = ChangeRing[(iFrom + i) % CHANGE_RING_SIZE];
+		PyObject *pValue;
+		if (rec.iField == CHG_POSITION)
+			pValue = Py_BuildValue("(iii)", rec.iValue[0], rec.iValue[1], rec.iValue[2]);
+		else if (rec.iField == CHG_CASH)
+			pValue = PyInt_FromLong(rec.iValue[0]);
+		else
+			pValue = PyInt_FromSize_t((uint)rec.iValue[0]); // ids
+		PyTuple_SET_ITEM(pRecords, i, Py_BuildValue("(KIIN)", rec.iSeq, rec.iClientID, rec.iField, pValue));
+	}
+	return Py_BuildValue("(KNO)", iFrom + iCount - 1, pRecords, PY_BOOL(bComplete));
+}
@@ -0,0 +1,141 @@
+#include "headers.h"
+#include <map>
+#include <set>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Chat channels - one FLHook.ChannelSend() per message instead of a HkMsg call per recipient. A channel has
+explicit members (FLHook.ChannelJoin/ChannelLeave) and optionally a filter matched against every player in
+game at send time:
+
+	CHF_MEMBERS - no filter, only the explicit members
+	CHF_ALL - everyone
+	CHF_SYSTEM - players in system value
+	CHF_AFFILIATION - players affiliated with reputation group value
+
+The message is encoded once and sent to each recipient with HkFMsgSendChat. Recipients that have the sender
+on their ignore list (IGNORE_INFO, 'p' flag for partial names, same as FLHook's own chat) are skipped.
+*/
+struct CHAT_CHANNEL
+{
+	CH_FILTER filter;
+	uint iFilterValue;
+	set<uint> setMembers; // client ids
+};
+
+static map<string, CHAT_CHANNEL> mapChannels;
+
+static bool IsIgnored(uint iClientID, const wstring &wscSenderLower)
+{
+	for (list<IGNORE_INFO>::iterator it = ClientInfo[iClientID].lstIgnore.begin(); it != ClientInfo[iClientID].lstIgnore.end(); ++it) {
+		wstring wscIgnored = ToLower(it->wscCharname);
+		if (it->wscFlags.find(L"p") != wstring::npos) {
+			if (wscSenderLower.find(wscIgnored) != wstring::npos)
+				return true;
+		}
+		else if (wscSenderLower == wscIgnored) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool MatchesFilter(const CHAT_CHANNEL &channel, uint iClientID)
+{
+	switch (channel.filter) {
+	case CHF_MEMBERS: // the explicit members only, checked by the caller
+		return false;
+	case CHF_ALL:
+		return true;
+	case CHF_SYSTEM: {
+		uint iSystem = 0;
+		pub::Player::GetSystem(iClientID, iSystem);
+		return iSystem == channel.iFilterValue;
+	}
+	case CHF_AFFILIATION: {
+		int iRep;
+		uint iAffiliation = 0;
+		pub::Player::GetRep(iClientID, iRep);
+		Reputation::Vibe::GetAffiliation(iRep, iAffiliation, false);
+		return iAffiliation == channel.iFilterValue;
+	}
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChannelCreate(const string &scName, CH_FILTER filter, uint iFilterValue)
+{
+	CHAT_CHANNEL &channel = mapChannels[scName]; // recreating keeps the members
+	channel.filter = filter;
+	channel.iFilterValue = iFilterValue;
+}
+
+bool ChannelDelete(const string &scName)
+{
+	return mapChannels.erase(scName) > 0;
+}
+
+bool ChannelJoin(const string &scName, uint iClientID, bool bJoin)
+{
+	map<string, CHAT_CHANNEL>::iterator it = mapChannels.find(scName);
+	if (it == mapChannels.end())
+		return false;
+	if (bJoin)
+		it->second.setMembers.insert(iClientID);
+	else
+		it->second.setMembers.erase(iClientID);
+	return true;
+}
+
+bool ChannelRecipients(const string &scName, list<uint> &lstRecipients)
+{
+	map<string, CHAT_CHANNEL>::iterator it = mapChannels.find(scName);
+	if (it == mapChannels.end())
+		return false;
+	CHAT_CHANNEL &channel = it->second;
+	for (uint iClientID = 1; iClientID <= MAX_CLIENT_ID; iClientID++) {
+		if (!HkIsValidClientID(iClientID) || HkIsInCharSelectMenu(iClientID))
+			continue;
+		if (channel.setMembers.count(iClientID) || (channel.filter != CHF_MEMBERS && MatchesFilter(channel, iClientID)))
+			lstRecipients.push_back(iClientID);
+	}
+	return true;
+}
+
+int ChannelSend(const string &scName, uint iSenderID, const wstring &wscText, bool bXML)
+{
+	list<uint> lstRecipients;
+	if (!ChannelRecipients(scName, lstRecipients))
+		return -1;
+	if (lstRecipients.empty())
+		return 0;
+
+	char szBuf[0xFFFF];
+	uint iRet;
+	if (HkFMsgEncodeXML(bXML ? wscText : L"<TRA data=\"0xFFFFFF00\" mask=\"-1\"/><TEXT>" + XMLText(wscText) + L"</TEXT>", szBuf, sizeof(szBuf), iRet) != HKE_OK)
+		return -1;
+
+	wstring wscSenderLower;
+	if (iSenderID && iSenderID <= MAX_CLIENT_ID && HkIsValidClientID(iSenderID)) {
+		const wchar_t *wszSender = (const wchar_t*)Players.GetActiveCharacterName(iSenderID);
+		if (wszSender)
+			wscSenderLower = ToLower(wszSender);
+	}
+
+	int iSent = 0;
+	for (list<uint>::iterator it = lstRecipients.begin(); it != lstRecipients.end(); ++it) {
+		if (!wscSenderLower.empty() && IsIgnored(*it, wscSenderLower))
+			continue;
+		HkFMsgSendChat(*it, szBuf, iRet);
+		iSent++;
+	}
+	return iSent;
+}
+
+void ChannelClearClient(uint iClientID)
+{
+	for (map<string, CHAT_CHANNEL>::iterator it = mapChannels.begin(); it != mapChannels.end(); ++it)
+		it->second.setMembers.erase(iClientID);
+}
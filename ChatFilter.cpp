@@ -0,0 +1,241 @@
+#include "headers.h"
+#include <vector>
+#include <map>
+#include <wctype.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Chat filter - word and phrase lists matched against every chat line before it's sent to python. The patterns
+from FLHook.ChatFilterAdd() are case folded (CharLowerBuffW, so not just ascii) and compiled into an
+Aho-Corasick automaton the first time a line is checked after a change, which then finds all of them in one
+pass over the extracted UTF-16 text. A pattern has one of these actions:
+
+	CFA_BLOCK - the line is dropped (NOFUNCTIONCALL) and not sent to python
+	CFA_MASK - the matched characters are replaced with '*', in the chat packet itself so the server sends
+		out the masked line, and the callbacks get the masked text
+	CFA_FLAG - the line goes through unchanged
+
+Lines with any match are reported with a ChatFiltered event, clean lines never touch python for this.
+*/
+CHAT_FILTER_STATS ChatFilterStats;
+
+struct CF_PATTERN
+{
+	wstring wscPattern; // folded
+	CF_ACTION action;
+	bool bWholeWord;
+};
+
+struct CF_EDGE
+{
+	wchar_t wc;
+	uint iNode;
+};
+
+struct CF_NODE
+{
+	uint iFirstEdge; // into vEdges, sorted by wc
+	uint iEdges;
+	uint iFail;
+	uint iOutput; // nearest node on the fail chain that ends a pattern, 0 for none
+	int iPattern; // ending here, -1 for none
+	uint iDepth;
+};
+
+static vector<CF_PATTERN> vPatterns;
+static vector<CF_NODE> vNodes;
+static vector<CF_EDGE> vEdges;
+static bool bDirty = false;
+static bool bBlocked[MAX_CLIENT_ID + 1]; // skip the AFTER callback too
+
+static void FoldText(wstring &wscText)
+{
+	if (!wscText.empty())
+		CharLowerBuffW(&wscText[0], wscText.length());
+}
+
+static uint FindEdge(uint iNode, wchar_t wc)
+{
+	const CF_NODE &node = vNodes[iNode];
+	uint iLo = node.iFirstEdge, iHi = node.iFirstEdge + node.iEdges;
+	while (iLo < iHi) {
+		uint iMid = (iLo + iHi) / 2;
+		if (vEdges[iMid].wc < wc)
+			iLo = iMid + 1;
+		else
+			iHi = iMid;
+	}
+	return (iLo < node.iFirstEdge + node.iEdges && vEdges[iLo].wc == wc) ? vEdges[iLo].iNode : 0;
+}
+
+static void Compile()
+{
+	// trie with map children first, then flattened into sorted edge runs
+	vector<map<wchar_t, uint> > vChildren(1);
+	vector<int> vEnds(1, -1);
+	vector<uint> vDepth(1, 0);
+	for (uint i = 0; i < vPatterns.size(); i++) {
+		uint iNode = 0;
+		const wstring &wscPattern = vPatterns[i].wscPattern;
+		for (uint c = 0; c < wscPattern.length(); c++) {
+			map<wchar_t, uint>::iterator it = vChildren[iNode].find(wscPattern[c]);
+			if (it != vChildren[iNode].end()) {
+				iNode = it->second;
+				continue;
+			}
+			vChildren.push_back(map<wchar_t, uint>());
+			vEnds.push_back(-1);
+			vDepth.push_back(c + 1);
+			vChildren[iNode][wscPattern[c]] = vChildren.size() - 1;
+			iNode = vChildren.size() - 1;
+		}
+		vEnds[iNode] = i; // a duplicate pattern replaces the earlier one
+	}
+
+	vNodes.assign(vChildren.size(), CF_NODE());
+	vEdges.clear();
+	for (uint i = 0; i < vChildren.size(); i++) {
+		CF_NODE &node = vNodes[i];
+		node.iFirstEdge = vEdges.size();
+		node.iEdges = vChildren[i].size();
+		node.iFail = node.iOutput = 0;
+		node.iPattern = vEnds[i];
+		node.iDepth = vDepth[i];
+		for (map<wchar_t, uint>::iterator it = vChildren[i].begin(); it != vChildren[i].end(); ++it) {
+			CF_EDGE edge = { it->first, it->second };
+			vEdges.push_back(edge);
+		}
+	}
+
+	// fail and output links, breadth first so the fail target is always done
+	vector<uint> vQueue;
+	for (uint e = 0; e < vNodes[0].iEdges; e++)
+		vQueue.push_back(vEdges[e].iNode);
+	for (uint q = 0; q < vQueue.size(); q++) {
+		uint iNode = vQueue[q];
+		const CF_NODE &node = vNodes[iNode];
+		for (uint e = node.iFirstEdge; e < node.iFirstEdge + node.iEdges; e++) {
+			uint iChild = vEdges[e].iNode;
+			uint iFail = node.iFail;
+			uint iNext;
+			while (!(iNext = FindEdge(iFail, vEdges[e].wc)) && iFail)
+				iFail = vNodes[iFail].iFail;
+			vNodes[iChild].iFail = iNext;
+			vNodes[iChild].iOutput = vNodes[iNext].iPattern >= 0 ? iNext : vNodes[iNext].iOutput;
+			vQueue.push_back(iChild);
+		}
+	}
+
+	ChatFilterStats.iPatterns = vPatterns.size();
+	ChatFilterStats.iNodes = vNodes.size();
+	bDirty = false;
+}
+
+// swap the line in the chat packet for the masked one, same length so nothing else moves
+static bool MaskPacket(const void *rdlReader, ulong lSize, const wchar_t *wszOrig, const wstring &wscMasked)
+{
+	size_t iBytes = wscMasked.length() * sizeof(wchar_t);
+	char *szData = (char*)rdlReader;
+	for (ulong i = 0; i + iBytes <= lSize; i++) {
+		if (!memcmp(szData + i, wszOrig, iBytes)) {
+			memcpy(szData + i, wscMasked.c_str(), iBytes);
+			return true;
+		}
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChatFilterAdd(const wstring &wscPattern, CF_ACTION action, bool bWholeWord)
+{
+	if (wscPattern.empty())
+		return;
+	CF_PATTERN pattern = { wscPattern, action, bWholeWord };
+	FoldText(pattern.wscPattern);
+	vPatterns.push_back(pattern);
+	bDirty = true;
+}
+
+void ChatFilterClear()
+{
+	vPatterns.clear();
+	vNodes.clear();
+	vEdges.clear();
+	bDirty = false;
+	ChatFilterStats.iPatterns = ChatFilterStats.iNodes = 0;
+}
+
+bool ChatFilterApply(uint iClientID, wchar_t *wszText, const void *rdlReader, ulong lSize)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return true;
+	bBlocked[iClientID] = false;
+	if (vPatterns.empty())
+		return true;
+	if (bDirty)
+		Compile();
+	ChatFilterStats.iChecked++;
+
+	wstring wscText = wszText;
+	wstring wscFolded = wscText;
+	FoldText(wscFolded);
+
+	int iAction = -1; // most severe so far, CF_ACTION is ordered that way
+	wstring wscMasked = wscText;
+	list<int> lstMatched;
+	uint iNode = 0;
+	for (uint i = 0; i < wscFolded.length(); i++) {
+		uint iNext;
+		while (!(iNext = FindEdge(iNode, wscFolded[i])) && iNode)
+			iNode = vNodes[iNode].iFail;
+		iNode = iNext;
+
+		for (uint iOut = vNodes[iNode].iPattern >= 0 ? iNode : vNodes[iNode].iOutput; iOut; iOut = vNodes[iOut].iOutput) {
+			const CF_PATTERN &pattern = vPatterns[vNodes[iOut].iPattern];
+			uint iStart = i + 1 - vNodes[iOut].iDepth;
+			if (pattern.bWholeWord && ((iStart > 0 && iswalnum(wscFolded[iStart - 1])) ||
+				(i + 1 < wscFolded.length() && iswalnum(wscFolded[i + 1]))))
+				continue;
+			if (iAction < 0 || pattern.action < iAction)
+				iAction = pattern.action;
+			if (pattern.action == CFA_MASK)
+				wscMasked.replace(iStart, vNodes[iOut].iDepth, vNodes[iOut].iDepth, L'*');
+			lstMatched.push_back(vNodes[iOut].iPattern);
+		}
+	}
+	if (iAction < 0)
+		return true;
+
+	if (iAction == CFA_MASK && !MaskPacket(rdlReader, lSize, wszText, wscMasked))
+		iAction = CFA_BLOCK; // the line isnt where we expect it in the packet, dont let it through unmasked
+
+	PyObject *pMatched = PyTuple_New(lstMatched.size());
+	uint iItem = 0;
+	for (list<int>::iterator it = lstMatched.begin(); it != lstMatched.end(); ++it, ++iItem)
+		PyTuple_SET_ITEM(pMatched, iItem, ToPython(vPatterns[*it].wscPattern));
+	PLUGIN_RETURNCODE returncodeHook = returncode;
+	pyCallback("ChatFiltered", Py_BuildValue("INiN", iClientID, ToPython(wscText), iAction, pMatched));
+	returncode = returncodeHook;
+
+	switch (iAction) {
+	case CFA_BLOCK:
+		ChatFilterStats.iBlocked++;
+		bBlocked[iClientID] = true;
+		returncode = NOFUNCTIONCALL;
+		return false;
+	case CFA_MASK:
+		ChatFilterStats.iMasked++;
+		wcscpy(wszText, wscMasked.c_str());
+		break;
+	case CFA_FLAG:
+		ChatFilterStats.iFlagged++;
+		break;
+	}
+	return true;
+}
+
+bool ChatFilterBlocked(uint iClientID)
+{
+	return iClientID <= MAX_CLIENT_ID && bBlocked[iClientID];
+}
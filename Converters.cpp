@@ -1,22 +1,184 @@
 #include "headers.h"
 //#include <Python.h>
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Marshalling caches - hot hooks are called thousands of times a second, so we try not to allocate new python
+objects for every call:
+	pyTupleAcquire - hands back the same tuple every call, as long as python let go of it (ref count is back to 1)
+	pyTupleRelease - empties a reused tuple after the call, so the tuples it held get back to 1 and are reused too
+	pyString - interned strings for event and struct names
+	pyID - a small cache of int objects for ship, object and archetype ids (python only caches ints up to 256)
+MarshalStats counts hits and misses, FLHook.GetMarshalStats() returns them.
+*/
+MARSHAL_STATS MarshalStats;
+
+#define PY_STRING_CACHE_SIZE 512
+#define PY_ID_CACHE_SIZE 1024
+#define PY_ID_CACHE_SHIFT 22 // 32 - log2(PY_ID_CACHE_SIZE)
+
+struct PY_STRING_ENTRY
+{
+	const char *szKey;
+	PyObject *pString;
+};
+struct PY_ID_ENTRY
+{
+	uint iID;
+	PyObject *pID;
+};
+static PY_STRING_ENTRY StringCache[PY_STRING_CACHE_SIZE];
+static PY_ID_ENTRY IDCache[PY_ID_CACHE_SIZE];
+
+PyObject* pyTupleAcquire(PY_ARGS &args, Py_ssize_t iSize)
+{
+	PyObject *pTuple = args.pTuple;
+	if (pTuple != NULL && Py_REFCNT(pTuple) == 1 && PyTuple_GET_SIZE(pTuple) == iSize) {
+		// nobody else holds it, so its safe to replace the items from the last call
+		for (Py_ssize_t i = 0; i < iSize; i++) {
+			PyObject *pOld = PyTuple_GET_ITEM(pTuple, i);
+			PyTuple_SET_ITEM(pTuple, i, NULL);
+			Py_XDECREF(pOld);
+		}
+		MarshalStats.iTuplesReused++;
+		Py_INCREF(pTuple);
+		return pTuple;
+	}
+	// still in use (a script kept it, or we're nested inside our own callback)
+	Py_XDECREF(pTuple);
+	pTuple = PyTuple_New(iSize);
+	Py_XINCREF(pTuple); // one for args, one for the caller
+	args.pTuple = pTuple;
+	MarshalStats.iTuplesAllocated++;
+	return pTuple;
+}
+
+void pyTupleRelease(PY_ARGS &args)
+{
+	PyObject *pTuple = args.pTuple;
+	if (pTuple == NULL || Py_REFCNT(pTuple) != 1)
+		return; // python kept it, the next pyTupleAcquire makes a new one
+	for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(pTuple); i++) {
+		PyObject *pOld = PyTuple_GET_ITEM(pTuple, i);
+		PyTuple_SET_ITEM(pTuple, i, NULL);
+		Py_XDECREF(pOld);
+	}
+}
+
+PyObject* pyString(const char *szString)
+{
+	// hash on the pointer (nearly always a string literal), but confirm with strcmp incase it isn't
+	uint iSlot = (uint)(((size_t)szString >> 3) % PY_STRING_CACHE_SIZE);
+	PY_STRING_ENTRY &entry = StringCache[iSlot];
+	if (entry.szKey == szString && strcmp(PyString_AS_STRING(entry.pString), szString) == 0) {
+		MarshalStats.iStringHits++;
+		Py_INCREF(entry.pString);
+		return entry.pString;
+	}
+	PyObject *pString = PyString_InternFromString(szString);
+	if (pString == NULL)
+		return NULL;
+	MarshalStats.iStringMisses++;
+	Py_XDECREF(entry.pString);
+	Py_INCREF(pString); // one for the cache, one for the caller
+	entry.szKey = szString;
+	entry.pString = pString;
+	return pString;
+}
+
+PyObject* pyID(uint iID)
+{
+	if (iID <= 256)
+		return PyInt_FromLong(iID); // python already caches these
+	PY_ID_ENTRY &entry = IDCache[(iID * 2654435761u) >> PY_ID_CACHE_SHIFT];
+	if (entry.pID != NULL && entry.iID == iID) {
+		MarshalStats.iIDHits++;
+		Py_INCREF(entry.pID);
+		return entry.pID;
+	}
+	PyObject *pID = PyInt_FromSize_t(iID); // same as Py_BuildValue("I"), a long if it doesnt fit in a int
+	if (pID == NULL)
+		return NULL;
+	MarshalStats.iIDMisses++;
+	Py_XDECREF(entry.pID);
+	Py_INCREF(pID);
+	entry.iID = iID;
+	entry.pID = pID;
+	return pID;
+}
+
+static PyObject* TupleReuseSink(PyObject *self, PyObject *pArgs)
+{
+	Py_RETURN_NONE;
+}
+static PyMethodDef TupleReuseSinkDef = { "sink", TupleReuseSink, METH_VARARGS, NULL };
+
+// runs iEvents events shaped like a hook's (an id and a Vector namedtuple inside the (event, data) tuple) through
+// the same tuples pyCallback uses, into a do nothing function. Returns a dict of the argument tuples that had to
+// be allocated after the first event, ok is True if that's 0. This only counts our argument tuples, the Vector
+// namedtuple and its floats are still new objects every event
+PyObject* TupleReuseCheck(uint iEvents)
+{
+	static PY_ARGS argsData, argsOuter;
+	PyObject *pSink = PyCFunction_New(&TupleReuseSinkDef, NULL);
+	if (pSink == NULL)
+		return NULL;
+	Vector vPos = { 1.0f, 2.0f, 3.0f };
+	uint iAllocatedBefore = 0, iReusedBefore = 0;
+	for (uint i = 0; i <= iEvents; i++) {
+		if (i == 1) { // the first event allocates the tuples, the steady state starts after it
+			iAllocatedBefore = MarshalStats.iTuplesAllocated;
+			iReusedBefore = MarshalStats.iTuplesReused;
+		}
+		PyObject *pData = pyTuple(argsData, pyID(0x12345678), ToPython(vPos));
+		PyObject *pArgs = pyTuple(argsOuter, pyString("TupleReuseCheck"), pData);
+		if (pArgs == NULL) {
+			Py_DECREF(pSink);
+			return NULL;
+		}
+		PyObject *pResult = PyObject_CallObject(pSink, pArgs);
+		Py_XDECREF(pResult);
+		Py_DECREF(pArgs);
+		pyTupleRelease(argsOuter);
+	}
+	Py_DECREF(pSink);
+	uint iAllocated = MarshalStats.iTuplesAllocated - iAllocatedBefore;
+	return Py_BuildValue("{s:I,s:I,s:I,s:O}", "events", iEvents, "tuples_allocated", iAllocated,
+		"tuples_reused", MarshalStats.iTuplesReused - iReusedBefore, "ok", PY_BOOL(iAllocated == 0));
+}
+
+void ClearMarshalCache()
+{
+	for (uint i = 0; i < PY_STRING_CACHE_SIZE; i++) {
+		Py_XDECREF(StringCache[i].pString);
+		StringCache[i].szKey = NULL;
+		StringCache[i].pString = NULL;
+	}
+	for (uint i = 0; i < PY_ID_CACHE_SIZE; i++) {
+		Py_XDECREF(IDCache[i].pID);
+		IDCache[i].pID = NULL;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*
 pyConstConverter - takes a struct's name, and a python tuple of that structs data and converts it to a
 collections.namedtuple python object.
 */
-PyObject* pyConstConverter(string scStructName, PyObject *pData)
+PyObject* pyConstConverter(const char *szStructName, PyObject *pData)
 {
-	PyObject *pResult;
+	static PY_ARGS args;
+	PyObject *pResult = NULL;
 	try {
-		PyObject *pName = PyString_FromString(scStructName.c_str());
-		PyObject *pArgs = Py_BuildValue("(NN)", pName, pData);
+		PyObject *pArgs = pyTuple(args, pyString(szStructName), pData);
+		if (pArgs == NULL) // bad struct data
+			return NULL;
 
 		pResult = PyObject_CallObject(pConstConverter, pArgs);
 		Py_XDECREF(pArgs);
+		pyTupleRelease(args);
 		if (pResult == NULL) { // function call error?
-			ERRMSG(L"ERROR convertConst returned NULL: " + stows(scStructName));
+			ERRMSG(L"ERROR convertConst returned NULL: " + stows(szStructName));
 		}
 	}
 	catch (...) { AddLog("Exception in pyConverter"); }
@@ -27,17 +189,19 @@ PyObject* pyConstConverter(string scStructName, PyObject *pData)
 /*
 pyClassConverter
 */
-PyObject* pyClassConverter(string scClassName, void *ptr)
+PyObject* pyClassConverter(const char *szClassName, void *ptr)
 {
-	PyObject *pResult;
+	static PY_ARGS args;
+	PyObject *pResult = NULL;
 	try {
-		PyObject *pName = PyString_FromString(scClassName.c_str());
-		PyObject *pCapsule = PyCapsule_New(ptr, NULL, NULL);
-		PyObject *pArgs = Py_BuildValue("(NN)", pName, pCapsule);
+		PyObject *pArgs = pyTuple(args, pyString(szClassName), PyCapsule_New(ptr, NULL, NULL));
+		if (pArgs == NULL)
+			return NULL;
 		pResult = PyObject_CallObject(pClassConverter, pArgs);
 		Py_XDECREF(pArgs);
+		pyTupleRelease(args);
 		if (pResult == NULL) { // function call error?
-			ERRMSG(L"ERROR convertClass returned NULL: " + stows(scClassName));
+			ERRMSG(L"ERROR convertClass returned NULL: " + stows(szClassName));
 		}
 	}
 	catch (...) { AddLog("Exception in pyClassConverter"); }
@@ -59,6 +223,17 @@ wstring pytows(PyObject *pObj)
 }
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*
+pyunitows - like pytows, but unicode objects are copied as they are instead of going through str(), so
+	characters outside the local codepage survive
+*/
+wstring pyunitows(PyObject *pObj)
+{
+	if (!PyUnicode_Check(pObj))
+		return pytows(pObj);
+	return wstring((const wchar_t*)PyUnicode_AS_UNICODE(pObj), PyUnicode_GET_SIZE(pObj));
+}
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
 pytos - python string to string. this works on any python object (not just strings) by getting a string
 repersentation of it. Basically calling python's str() function
 */
@@ -82,11 +257,12 @@ PyObject* ToPython(wstring wscString)
 
 PyObject* ToPython(Vector hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("Vector", 
-		Py_BuildValue("(fff)", 
-			hkInfo.x, 
-			hkInfo.y, 
-			hkInfo.z));
+		pyTuple(args, 
+			pyFloat(hkInfo.x), 
+			pyFloat(hkInfo.y), 
+			pyFloat(hkInfo.z)));
 }
 PyObject* ToPython(Vector* hkInfo)
 {
@@ -95,12 +271,13 @@ PyObject* ToPython(Vector* hkInfo)
 
 PyObject* ToPython(Quaternion hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("Quaternion", 
-		Py_BuildValue("(ffff)", 
-			hkInfo.w, 
-			hkInfo.x, 
-			hkInfo.y, 
-			hkInfo.z));
+		pyTuple(args, 
+			pyFloat(hkInfo.w), 
+			pyFloat(hkInfo.x), 
+			pyFloat(hkInfo.y), 
+			pyFloat(hkInfo.z)));
 }
 PyObject* ToPython(Quaternion* hkInfo)
 {
@@ -110,27 +287,29 @@ PyObject* ToPython(Quaternion* hkInfo)
 
 PyObject* ToPython(SSPObjUpdateInfo hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("SSPObjUpdateInfo", 
-		Py_BuildValue("(INNfffb)", 
-			hkInfo.iShip,
+		pyTuple(args, 
+			pyID(hkInfo.iShip),
 			ToPython(hkInfo.vDir), 
 			ToPython(hkInfo.vPos), 
-			hkInfo.fTimestamp, 
-			hkInfo.fDunno, 
-			hkInfo.throttle, 
-			hkInfo.cState
+			pyFloat(hkInfo.fTimestamp), 
+			pyFloat(hkInfo.fDunno), 
+			pyFloat(hkInfo.throttle), 
+			pyInt(hkInfo.cState)
 		));
 }
 
 PyObject* ToPython(SSPObjCollisionInfo hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("SSPObjCollisionInfo", 
-		Py_BuildValue("(IIIIf)", 
-			hkInfo.iColliderObjectID,
-			hkInfo.iColliderSubObjID, 
-			hkInfo.iDamagedObjectID, 
-			hkInfo.iDamagedSubObjID, 
-			hkInfo.fDamage
+		pyTuple(args, 
+			pyID(hkInfo.iColliderObjectID),
+			pyID(hkInfo.iColliderSubObjID), 
+			pyID(hkInfo.iDamagedObjectID), 
+			pyID(hkInfo.iDamagedSubObjID), 
+			pyFloat(hkInfo.fDamage)
 		));
 }
 
@@ -186,43 +365,47 @@ PyObject* ToPython(XFireWeaponInfo hkInfo)
 
 PyObject* ToPython(XActivateEquip hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("XActivateEquip", 
-		Py_BuildValue("(IHO)", 
-			hkInfo.iSpaceID, 
-			hkInfo.sID, 
-			PY_BOOL(hkInfo.bActivate)
+		pyTuple(args, 
+			pyID(hkInfo.iSpaceID), 
+			pyInt(hkInfo.sID), 
+			pyBool(hkInfo.bActivate)
 		));
 }
 
 
 PyObject* ToPython(XActivateCruise hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("XActivateCruise", 
-		Py_BuildValue("(IO)", 
-			hkInfo.iShip, 
-			PY_BOOL(hkInfo.bActivate)
+		pyTuple(args, 
+			pyID(hkInfo.iShip), 
+			pyBool(hkInfo.bActivate)
 		));
 }
 
 
 PyObject* ToPython(XActivateThrusters hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("XActivateThrusters", 
-		Py_BuildValue("(IO)", 
-			hkInfo.iShip, 
-			PY_BOOL(hkInfo.bActivate)
+		pyTuple(args, 
+			pyID(hkInfo.iShip), 
+			pyBool(hkInfo.bActivate)
 		));
 }
 
 
 PyObject* ToPython(XSetTarget hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("XSetTarget", 
-		Py_BuildValue("(IIII)", 
-			hkInfo.iShip, 
-			hkInfo.iSlot, 
-			hkInfo.iSpaceID, 
-			hkInfo.iSubObjID
+		pyTuple(args, 
+			pyID(hkInfo.iShip), 
+			pyID(hkInfo.iSlot), 
+			pyID(hkInfo.iSpaceID), 
+			pyID(hkInfo.iSubObjID)
 		));
 }
 
@@ -285,12 +468,13 @@ PyObject* ToPython(SGFGoodBuyInfo hkInfo)
 
 PyObject* ToPython(SSPMunitionCollisionInfo hkInfo)
 {
+	static PY_ARGS args;
 	return pyConstConverter("SSPMunitionCollisionInfo", 
-		Py_BuildValue("(IkkH)", 
-			hkInfo.iProjectileArchID, 
-			hkInfo.dw2, 
-			hkInfo.dwTargetShip, 
-			hkInfo.s1
+		pyTuple(args, 
+			pyID(hkInfo.iProjectileArchID), 
+			pyID(hkInfo.dw2), 
+			pyID(hkInfo.dwTargetShip), 
+			pyInt(hkInfo.s1)
 		));
 }
 
@@ -0,0 +1,71 @@
+#include "headers.h"
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Damage observer - HkCb_AddDmgEntry fires once for every sub object hit, so a big fight is the busiest hook
+we have. With FLHook.SetDamageObserver(True) the per entry callbacks are replaced by one HkCb_DamageObserved
+event per DamageList: the entries are batched here and passed as a read only FLHook.Payload of packed
+DMG_ENTRY_PACKED records (struct format '<HfI': subobj, health, fate).
+
+A batch is one damage resolution: it's closed when the server starts resolving the next hit (HkCb_GeneralDmg,
+HkCB_MissileTorpHit), when entries for another target or inflictor come in, before ShipDestroyed, or at the
+end of the server tick. The DamageList itself lives on the stack, its address is reused by every hit and can't
+tell two resolutions apart. The server has already applied the entries by then (and the DamageList is gone),
+so this only observes damage; scripts that need to alter damage keep using the per entry HkCb_AddDmgEntry
+with the observer off.
+*/
+bool bDamageBatching = false;
+
+#pragma pack(push, 1)
+struct DMG_ENTRY_PACKED
+{
+	unsigned short iSubObj;
+	float fHealth;
+	uint iFate;
+};
+#pragma pack(pop)
+
+static vector<DMG_ENTRY_PACKED> vDamageBatch;
+static uint iBatchTarget; // space id
+static uint iBatchTargetClient;
+static uint iBatchInflictor;
+static uint iBatchInflictorPlayer;
+
+void DamageBatchFlush()
+{
+	if (vDamageBatch.empty())
+		return;
+
+	PLUGIN_RETURNCODE returncodeHook = returncode; // the batch cant block the hook that closed it
+	PyObject *pPayload = pyPayload(&vDamageBatch[0], vDamageBatch.size() * sizeof(DMG_ENTRY_PACKED));
+	pyCallback("HkCb_DamageObserved", Py_BuildValue("IIIIO", iBatchTarget, iBatchTargetClient, iBatchInflictor, iBatchInflictorPlayer, pPayload));
+	pyPayloadRelease(pPayload);
+	returncode = returncodeHook;
+
+	vDamageBatch.clear();
+}
+
+void DamageBatchAdd(DamageList *dmg, unsigned short iSubObj, float fHealth, DamageEntry::SubObjFate fate)
+{
+	uint iInflictor = dmg->get_inflictor_id();
+	uint iInflictorPlayer = dmg->get_inflictor_owner_player();
+	if (iDmgToSpaceID != iBatchTarget || iInflictor != iBatchInflictor || iInflictorPlayer != iBatchInflictorPlayer)
+		DamageBatchFlush();
+
+	if (vDamageBatch.empty()) {
+		iBatchTarget = iDmgToSpaceID;
+		iBatchTargetClient = iDmgTo;
+		iBatchInflictor = iInflictor;
+		iBatchInflictorPlayer = iInflictorPlayer;
+	}
+	DMG_ENTRY_PACKED entry = { iSubObj, fHealth, (uint)fate };
+	vDamageBatch.push_back(entry);
+}
+
+void SetDamageObserver(bool bEnabled)
+{
+	if (!bEnabled)
+		DamageBatchFlush();
+	bDamageBatching = bEnabled;
+}
@@ -26,7 +26,13 @@ static PyObject* emb_PrintUserCmdText(PyObject *self, PyObject *pArgs)
 	PyObject* pText;
 	if (!PyArg_ParseTuple(pArgs, "IO", &iClientID, &pText))
 		return NULL;
-	PrintUserCmdText(iClientID, pytows(pText));
+	if (bOutbox) {
+		if (RaisePyException(OutboxQueueText(iClientID, pytows(pText), true)))
+			return NULL;
+	}
+	else {
+		PrintUserCmdText(iClientID, pytows(pText));
+	}
 	Py_RETURN_NONE;
 }
 
@@ -37,6 +43,14 @@ static PyObject* emb_HkMsg(PyObject *self, PyObject *pArgs)
 	PyObject *pCharName, *pText;
 	if (!PyArg_ParseTuple(pArgs, "OO", &pCharName, &pText))
 		return NULL;
+	if (bOutbox) {
+		uint iClientID = HkGetClientIdFromCharname(pytows(pCharName));
+		if (HkIsValidClientID(iClientID)) {
+			if (RaisePyException(OutboxQueueText(iClientID, pytows(pText), false)))
+				return NULL;
+			Py_RETURN_NONE;
+		}
+	}
 	if (RaisePyException(HkMsg(pytows(pCharName), pytows(pText))))
 		return NULL;
 	Py_RETURN_NONE;
@@ -64,6 +78,14 @@ static PyObject* emb_HkFMsg(PyObject *self, PyObject *pArgs)
 	PyObject *pCharName, *pText;
 	if (!PyArg_ParseTuple(pArgs, "OO", &pCharName, &pText))
 		return NULL;
+	if (bOutbox) {
+		uint iClientID = HkGetClientIdFromCharname(pytows(pCharName));
+		if (HkIsValidClientID(iClientID)) {
+			if (RaisePyException(OutboxQueue(iClientID, pytows(pText))))
+				return NULL;
+			Py_RETURN_NONE;
+		}
+	}
 	if (RaisePyException(HkFMsg(pytows(pCharName), pytows(pText))))
 		return NULL;
 	Py_RETURN_NONE;
@@ -191,8 +213,11 @@ static PyObject* emb_HkAddCash(PyObject *self, PyObject *pArgs)
 	int iCash;
 	if (!PyArg_ParseTuple(pArgs, "Oi", &pCharname, &iCash))
 		return NULL;
-	if (RaisePyException(HkAddCash(pytows(pCharname), iCash)))
+	wstring wscCharname = pytows(pCharname);
+	if (RaisePyException(HkAddCash(wscCharname, iCash)))
 		return NULL;
+	if (bChangeFeed) // FL doesn't call a hook for this
+		ChangeFeedDirty(HkGetClientIdFromCharname(wscCharname), CHG_CASH);
 	Py_RETURN_NONE;
 }
 static PyObject* emb_HkKick(PyObject *self, PyObject *pArgs)
@@ -237,7 +262,10 @@ static PyObject* emb_HkSaveChar(PyObject *self, PyObject *pArgs)
 	PyObject *pCharname;
 	if (!PyArg_ParseTuple(pArgs, "O", &pCharname))
 		return NULL;
-	if (RaisePyException(HkSaveChar(pytows(pCharname))))
+	wstring wscCharname = pytows(pCharname);
+	HK_ERROR hkErr = HkSaveChar(wscCharname);
+	IniCacheInvalidateChar(wscCharname);
+	if (RaisePyException(hkErr))
 		return NULL;
 	Py_RETURN_NONE;
 }
@@ -367,6 +395,9 @@ static PyObject* emb_HkGetClientIDByShip(PyObject *self, PyObject *pArgs)
 	uint iShip;
 	if (!PyArg_ParseTuple(pArgs, "I", &iShip))
 		return NULL;
+	const SHIP_ENTRY *pEntry = ShipRegistryFind(iShip);
+	if (pEntry && pEntry->iClientID) // 0 can be a player ship registered before FL assigned its owner
+		return Py_BuildValue("I", pEntry->iClientID);
 	return Py_BuildValue("I", HkGetClientIDByShip(iShip));
 }
 static PyObject* emb_HkGetAccountDirName(PyObject *self, PyObject *pArgs)
@@ -427,6 +458,770 @@ static PyObject* emb_HkGetCharnameFromClientId(PyObject *self, PyObject *pArgs)
 }
 
 
+static PyObject* emb_SetFusedHook(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pEvent;
+	int bFused;
+	if (!PyArg_ParseTuple(pArgs, "Oi", &pEvent, &bFused))
+		return NULL;
+	if (!SetFusedHook(pytos(pEvent), bFused ? true : false)) {
+		PyErr_SetString(PyExc_ValueError, "not a BEFORE/AFTER hook pair");
+		return NULL;
+	}
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetMarshalStats(PyObject *self, PyObject *pArgs)
+{
+	return Py_BuildValue("{sIsIsIsIsIsI}",
+		"tuples_reused", MarshalStats.iTuplesReused,
+		"tuples_allocated", MarshalStats.iTuplesAllocated,
+		"id_hits", MarshalStats.iIDHits,
+		"id_misses", MarshalStats.iIDMisses,
+		"string_hits", MarshalStats.iStringHits,
+		"string_misses", MarshalStats.iStringMisses);
+}
+static PyObject* emb_CheckTupleReuse(PyObject *self, PyObject *pArgs)
+{
+	uint iEvents = 1000;
+	if (!PyArg_ParseTuple(pArgs, "|I", &iEvents))
+		return NULL;
+	return TupleReuseCheck(iEvents);
+}
+static PyObject* emb_SetGCPolicy(PyObject *self, PyObject *pArgs)
+{
+	GC_POLICY policy = GCPolicy;
+	int bManaged;
+	if (!PyArg_ParseTuple(pArgs, "i|iif", &bManaged, &policy.iThreshold0, &policy.iThreshold1, &policy.fFullInterval))
+		return NULL;
+	if (policy.iThreshold0 < 1 || policy.iThreshold1 < 1 || policy.fFullInterval < 0) {
+		PyErr_SetString(PyExc_ValueError, "thresholds must be positive and full_interval >= 0");
+		return NULL;
+	}
+	policy.bManaged = bManaged ? true : false;
+	SetGCPolicy(policy);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetGCStats(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pBuckets = PyTuple_New(GC_HISTOGRAM_SIZE - 1);
+	for (uint i = 0; i < GC_HISTOGRAM_SIZE - 1; i++)
+		PyTuple_SET_ITEM(pBuckets, i, PyFloat_FromDouble(GC_BUCKETS_MS[i]));
+
+	PyObject *pHistogram = PyTuple_New(3);
+	for (uint iGen = 0; iGen < 3; iGen++) {
+		PyObject *pGen = PyTuple_New(GC_HISTOGRAM_SIZE);
+		for (uint i = 0; i < GC_HISTOGRAM_SIZE; i++)
+			PyTuple_SET_ITEM(pGen, i, PyInt_FromSize_t(GCStats.iHistogram[iGen][i]));
+		PyTuple_SET_ITEM(pHistogram, iGen, pGen);
+	}
+
+	return Py_BuildValue("{sOs(III)s(ddd)sIsIsNsN}",
+		"managed", PY_BOOL(GCPolicy.bManaged),
+		"collections", GCStats.iCollections[0], GCStats.iCollections[1], GCStats.iCollections[2],
+		"max_pause_ms", GCStats.dMaxPause[0], GCStats.dMaxPause[1], GCStats.dMaxPause[2],
+		"forced", GCStats.iForced,
+		"deferred", GCStats.iDeferred,
+		"buckets_ms", pBuckets,
+		"histogram", pHistogram);
+}
+static PyObject* emb_SetLeakSentinel(PyObject *self, PyObject *pArgs)
+{
+	int bEnabled;
+	uint iInterval = LeakSentinel.iInterval, iWindow = LeakSentinel.iWindow;
+	if (!PyArg_ParseTuple(pArgs, "i|II", &bEnabled, &iInterval, &iWindow))
+		return NULL;
+	if (!SetLeakSentinel(bEnabled ? true : false, iInterval, iWindow)) {
+		PyErr_SetString(PyExc_ValueError, "interval must be > 0 and window between 2 and 16");
+		return NULL;
+	}
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetLeakReport(PyObject *self, PyObject *pArgs)
+{
+	list<LEAK_REPORT> &lstReports = GetLeakReports();
+	PyObject *pReports = PyList_New(0);
+	for (list<LEAK_REPORT>::iterator it = lstReports.begin(); it != lstReports.end(); ++it) {
+		PyObject *pSuspects = PyList_New(0);
+		for (list<LEAK_SUSPECT>::iterator sus = it->lstSuspects.begin(); sus != it->lstSuspects.end(); ++sus) {
+			PyObject *pSuspect = Py_BuildValue("(sdd)", sus->scEvent.c_str(), sus->dCorrelation, sus->dPerCall);
+			PyList_Append(pSuspects, pSuspect);
+			Py_XDECREF(pSuspect);
+		}
+		PyObject *pReport = Py_BuildValue("{sssisN}", "type", it->scType.c_str(), "growth", it->iGrowth, "suspects", pSuspects);
+		PyList_Append(pReports, pReport);
+		Py_XDECREF(pReport);
+	}
+	return Py_BuildValue("{sOsnsN}",
+		"enabled", PY_BOOL(LeakSentinel.bEnabled),
+		"ref_growth", LeakSentinel.iRefGrowth,
+		"reports", pReports);
+}
+static PyObject* emb_SetNativeHandler(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pEvent, *pCapsule;
+	if (!PyArg_ParseTuple(pArgs, "OO", &pEvent, &pCapsule))
+		return NULL;
+	int iEvent = GetNativeEvent(pytos(pEvent));
+	if (iEvent < 0) {
+		PyErr_SetString(PyExc_ValueError, "event has no native handler support");
+		return NULL;
+	}
+	if (pCapsule == Py_None) {
+		SetNativeHandler(iEvent, NULL);
+		Py_RETURN_NONE;
+	}
+	if (!PyCapsule_IsValid(pCapsule, FLHOOK_NATIVE_CAPSULE)) {
+		PyErr_SetString(PyExc_TypeError, "expected a " FLHOOK_NATIVE_CAPSULE " capsule");
+		return NULL;
+	}
+	FLHOOK_NATIVE_HANDLER_INFO *pInfo = (FLHOOK_NATIVE_HANDLER_INFO*)PyCapsule_GetPointer(pCapsule, FLHOOK_NATIVE_CAPSULE);
+	if (pInfo->iABIVersion != FLHOOK_NATIVE_ABI_VERSION) {
+		PyErr_Format(PyExc_ValueError, "native handler built for ABI version %u, plugin uses %u", pInfo->iABIVersion, FLHOOK_NATIVE_ABI_VERSION);
+		return NULL;
+	}
+	if (pInfo->pHandler == NULL) {
+		PyErr_SetString(PyExc_ValueError, "native handler has no handler function");
+		return NULL;
+	}
+	SetNativeHandler(iEvent, pCapsule);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetNativeStats(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pStats = PyDict_New();
+	for (int i = 0; i < FNE_COUNT; i++) {
+		if (NativeHandlers[i].pInfo == NULL)
+			continue;
+		PyObject *pItem = Py_BuildValue("(II)", NativeHandlers[i].iCalls, NativeHandlers[i].iPython);
+		PyDict_SetItemString(pStats, GetNativeEventName(i), pItem);
+		Py_XDECREF(pItem);
+	}
+	return pStats;
+}
+static PyObject* emb_SetDamageObserver(PyObject *self, PyObject *pArgs)
+{
+	int bEnabled;
+	if (!PyArg_ParseTuple(pArgs, "i", &bEnabled))
+		return NULL;
+	SetDamageObserver(bEnabled ? true : false);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_SetKillTracking(PyObject *self, PyObject *pArgs)
+{
+	KILL_LEDGER_POLICY policy = KillLedgerPolicy;
+	int bEnabled;
+	if (!PyArg_ParseTuple(pArgs, "i|ff", &bEnabled, &policy.fHalfLife, &policy.fExpiry))
+		return NULL;
+	if (policy.fHalfLife < 0 || policy.fExpiry <= 0) {
+		PyErr_SetString(PyExc_ValueError, "half_life must be >= 0 and expiry > 0");
+		return NULL;
+	}
+	policy.bEnabled = bEnabled ? true : false;
+	SetKillLedgerPolicy(policy);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_SetSequenceTracking(PyObject *self, PyObject *pArgs)
+{
+	int bEnabled, bOutcomesOnly = 0;
+	if (!PyArg_ParseTuple(pArgs, "i|i", &bEnabled, &bOutcomesOnly))
+		return NULL;
+	SetSequenceTracking(bEnabled ? true : false, bOutcomesOnly ? true : false);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_SetRateLimit(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pEvent;
+	float fRate, fBurst = 1.0f;
+	int iAction = RLA_DROP;
+	if (!PyArg_ParseTuple(pArgs, "Of|fi", &pEvent, &fRate, &fBurst, &iAction))
+		return NULL;
+	int iEvent = GetRateEvent(pytos(pEvent));
+	if (iEvent < 0) {
+		PyErr_SetString(PyExc_ValueError, "event can not be rate limited");
+		return NULL;
+	}
+	if (iAction < RLA_DROP || iAction > RLA_FLAG) {
+		PyErr_SetString(PyExc_ValueError, "unknown rate limit action");
+		return NULL;
+	}
+	SetRateLimit((RATE_EVENT)iEvent, fRate, fBurst, (RATE_ACTION)iAction);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetRateLimitStats(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pStats = PyDict_New();
+	for (int i = 0; i < RLE_COUNT; i++) {
+		if (!RateLimits[i].bEnabled)
+			continue;
+		PyObject *pItem = PyInt_FromSize_t(RateLimits[i].iLimited);
+		PyDict_SetItemString(pStats, GetRateEventName(i), pItem);
+		Py_XDECREF(pItem);
+	}
+	return pStats;
+}
+static PyObject* emb_IsRateLimited(PyObject *self, PyObject *pArgs)
+{
+	return Py_BuildValue("O", PY_BOOL(RateLimitFlagged(pyCurrentEvent())));
+}
+static PyObject* emb_RateLimit(PyObject *self, PyObject *pArgs)
+{
+	uint iClientID;
+	char *szKey;
+	float fRate, fBurst = 1.0f;
+	if (!PyArg_ParseTuple(pArgs, "Isf|f", &iClientID, &szKey, &fRate, &fBurst))
+		return NULL;
+	return Py_BuildValue("O", PY_BOOL(RateLimitCustom(iClientID, szKey, fRate, fBurst)));
+}
+static PyObject* emb_Cooldown(PyObject *self, PyObject *pArgs)
+{
+	uint iClientID, iMS;
+	char *szKey;
+	if (!PyArg_ParseTuple(pArgs, "IsI", &iClientID, &szKey, &iMS))
+		return NULL;
+	return PyInt_FromSize_t(RateCooldown(iClientID, szKey, iMS));
+}
+static PyObject* emb_AdmissionAddIP(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pCIDR;
+	int iVerdict = ADM_REJECT;
+	if (!PyArg_ParseTuple(pArgs, "O|i", &pCIDR, &iVerdict))
+		return NULL;
+	if (iVerdict < ADM_NONE || iVerdict > ADM_REJECT) {
+		PyErr_SetString(PyExc_ValueError, "verdict must be ADM_NONE, ADM_ALLOW or ADM_REJECT");
+		return NULL;
+	}
+	if (!AdmissionAddIP(pytows(pCIDR), (ADM_VERDICT)iVerdict)) {
+		PyErr_SetString(PyExc_ValueError, "invalid ip range");
+		return NULL;
+	}
+	Py_RETURN_NONE;
+}
+static PyObject* emb_AdmissionBanAccount(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pAccount;
+	PyObject *pBanned = Py_True;
+	if (!PyArg_ParseTuple(pArgs, "O|O", &pAccount, &pBanned))
+		return NULL;
+	AdmissionBanAccount(pytows(pAccount), PyObject_IsTrue(pBanned) == 1);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_AdmissionSetRate(PyObject *self, PyObject *pArgs)
+{
+	uint iMax, iWindow = 10000;
+	int iAction = ADM_REJECT;
+	if (!PyArg_ParseTuple(pArgs, "I|Ii", &iMax, &iWindow, &iAction))
+		return NULL;
+	if (iAction != ADM_REJECT && iAction != ADM_FLAG) {
+		PyErr_SetString(PyExc_ValueError, "action must be ADM_REJECT or ADM_FLAG");
+		return NULL;
+	}
+	AdmissionSetRate(iMax, iWindow, (ADM_VERDICT)iAction);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_AdmissionLoad(PyObject *self, PyObject *pArgs)
+{
+	char *szPath;
+	if (!PyArg_ParseTuple(pArgs, "s", &szPath))
+		return NULL;
+	int iRules = AdmissionLoad(szPath);
+	if (iRules < 0) {
+		PyErr_SetFromErrnoWithFilename(PyExc_IOError, szPath);
+		return NULL;
+	}
+	return PyInt_FromLong(iRules);
+}
+static PyObject* emb_AdmissionClear(PyObject *self, PyObject *pArgs)
+{
+	AdmissionClear();
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetAdmissionStats(PyObject *self, PyObject *pArgs)
+{
+	return Py_BuildValue("{s:I,s:I,s:I,s:I,s:I,s:I,s:I,s:I,s:I}",
+		"admitted", AdmissionStats.iAdmitted,
+		"rejected_ip", AdmissionStats.iRejectedIP,
+		"rejected_account", AdmissionStats.iRejectedAccount,
+		"rejected_rate", AdmissionStats.iRejectedRate,
+		"flagged", AdmissionStats.iFlagged,
+		"bloom_hits", AdmissionStats.iBloomHits,
+		"bloom_false_positives", AdmissionStats.iBloomFalsePositives,
+		"ip_rules", AdmissionStats.iIPRules,
+		"accounts", AdmissionStats.iAccounts);
+}
+static PyObject* emb_ChatFilterAdd(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pPatterns;
+	int iAction = CFA_BLOCK;
+	PyObject *pWholeWord = Py_False;
+	if (!PyArg_ParseTuple(pArgs, "O|iO", &pPatterns, &iAction, &pWholeWord))
+		return NULL;
+	if (iAction < CFA_BLOCK || iAction > CFA_FLAG) {
+		PyErr_SetString(PyExc_ValueError, "unknown chat filter action");
+		return NULL;
+	}
+	bool bWholeWord = PyObject_IsTrue(pWholeWord) == 1;
+	if (PyString_Check(pPatterns) || PyUnicode_Check(pPatterns)) {
+		ChatFilterAdd(pyunitows(pPatterns), (CF_ACTION)iAction, bWholeWord);
+		return PyInt_FromLong(1);
+	}
+	PyObject *pSeq = PySequence_Fast(pPatterns, "patterns must be a string or a sequence of strings");
+	if (!pSeq)
+		return NULL;
+	Py_ssize_t iCount = PySequence_Fast_GET_SIZE(pSeq);
+	for (Py_ssize_t i = 0; i < iCount; i++)
+		ChatFilterAdd(pyunitows(PySequence_Fast_GET_ITEM(pSeq, i)), (CF_ACTION)iAction, bWholeWord);
+	Py_DECREF(pSeq);
+	return PyInt_FromSsize_t(iCount);
+}
+static PyObject* emb_ChatFilterClear(PyObject *self, PyObject *pArgs)
+{
+	ChatFilterClear();
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetChatFilterStats(PyObject *self, PyObject *pArgs)
+{
+	return Py_BuildValue("{s:I,s:I,s:I,s:I,s:I,s:I}",
+		"patterns", ChatFilterStats.iPatterns,
+		"nodes", ChatFilterStats.iNodes,
+		"checked", ChatFilterStats.iChecked,
+		"blocked", ChatFilterStats.iBlocked,
+		"masked", ChatFilterStats.iMasked,
+		"flagged", ChatFilterStats.iFlagged);
+}
+static PyObject* emb_ChannelCreate(PyObject *self, PyObject *pArgs)
+{
+	char *szName;
+	int iFilter = CHF_MEMBERS;
+	uint iValue = 0;
+	if (!PyArg_ParseTuple(pArgs, "s|iI", &szName, &iFilter, &iValue))
+		return NULL;
+	if (iFilter < CHF_MEMBERS || iFilter > CHF_AFFILIATION) {
+		PyErr_SetString(PyExc_ValueError, "unknown channel filter");
+		return NULL;
+	}
+	ChannelCreate(szName, (CH_FILTER)iFilter, iValue);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_ChannelDelete(PyObject *self, PyObject *pArgs)
+{
+	char *szName;
+	if (!PyArg_ParseTuple(pArgs, "s", &szName))
+		return NULL;
+	return Py_BuildValue("O", PY_BOOL(ChannelDelete(szName)));
+}
+static PyObject* emb_ChannelJoin(PyObject *self, PyObject *pArgs)
+{
+	char *szName;
+	uint iClientID;
+	PyObject *pJoin = Py_True;
+	if (!PyArg_ParseTuple(pArgs, "sI|O", &szName, &iClientID, &pJoin))
+		return NULL;
+	if (!ChannelJoin(szName, iClientID, PyObject_IsTrue(pJoin) == 1)) {
+		PyErr_SetString(PyExc_ValueError, "unknown channel");
+		return NULL;
+	}
+	Py_RETURN_NONE;
+}
+static PyObject* emb_ChannelSend(PyObject *self, PyObject *pArgs)
+{
+	char *szName;
+	uint iSenderID;
+	PyObject *pText;
+	PyObject *pXML = Py_False;
+	if (!PyArg_ParseTuple(pArgs, "sIO|O", &szName, &iSenderID, &pText, &pXML))
+		return NULL;
+	int iSent = ChannelSend(szName, iSenderID, pyunitows(pText), PyObject_IsTrue(pXML) == 1);
+	if (iSent < 0) {
+		PyErr_SetString(PyExc_ValueError, "unknown channel or invalid xml");
+		return NULL;
+	}
+	return PyInt_FromLong(iSent);
+}
+static PyObject* emb_GetChannelMembers(PyObject *self, PyObject *pArgs)
+{
+	char *szName;
+	if (!PyArg_ParseTuple(pArgs, "s", &szName))
+		return NULL;
+	list<uint> lstRecipients;
+	if (!ChannelRecipients(szName, lstRecipients)) {
+		PyErr_SetString(PyExc_ValueError, "unknown channel");
+		return NULL;
+	}
+	PyObject *pMembers = PyTuple_New(lstRecipients.size());
+	uint i = 0;
+	for (list<uint>::iterator it = lstRecipients.begin(); it != lstRecipients.end(); ++it, ++i)
+		PyTuple_SET_ITEM(pMembers, i, PyInt_FromSize_t(*it));
+	return pMembers;
+}
+static PyObject* emb_SetOutbox(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pEnabled;
+	if (!PyArg_ParseTuple(pArgs, "O", &pEnabled))
+		return NULL;
+	SetOutbox(PyObject_IsTrue(pEnabled) == 1);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_FlushOutbox(PyObject *self, PyObject *pArgs)
+{
+	uint iClientID = 0;
+	if (!PyArg_ParseTuple(pArgs, "|I", &iClientID))
+		return NULL;
+	OutboxFlush(iClientID);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetOutboxStats(PyObject *self, PyObject *pArgs)
+{
+	return Py_BuildValue("{s:I,s:I}", "queued", OutboxStats.iQueued, "sent", OutboxStats.iSent);
+}
+static PyObject* emb_RegisterMessageTemplate(PyObject *self, PyObject *pArgs)
+{
+	char *szName;
+	PyObject *pXML;
+	if (!PyArg_ParseTuple(pArgs, "sO", &szName, &pXML))
+		return NULL;
+	if (!MessageTemplateRegister(szName, pyunitows(pXML))) {
+		PyErr_SetString(PyExc_ValueError, "invalid xml");
+		return NULL;
+	}
+	Py_RETURN_NONE;
+}
+static PyObject* emb_RemoveMessageTemplate(PyObject *self, PyObject *pArgs)
+{
+	char *szName;
+	if (!PyArg_ParseTuple(pArgs, "s", &szName))
+		return NULL;
+	return Py_BuildValue("O", PY_BOOL(MessageTemplateRemove(szName)));
+}
+static PyObject* emb_SendMessageTemplate(PyObject *self, PyObject *pArgs)
+{
+	char *szName;
+	PyObject *pTargets;
+	PyObject *pParams = NULL;
+	if (!PyArg_ParseTuple(pArgs, "sO|O!", &szName, &pTargets, &PyDict_Type, &pParams))
+		return NULL;
+
+	list<uint> lstClients;
+	if (PyInt_Check(pTargets) || PyLong_Check(pTargets)) {
+		uint iClientID = (uint)PyInt_AsUnsignedLongMask(pTargets);
+		if (iClientID) // 0 is everyone, an empty list
+			lstClients.push_back(iClientID);
+	}
+	else {
+		PyObject *pSeq = PySequence_Fast(pTargets, "targets must be a client id or a sequence of client ids");
+		if (!pSeq)
+			return NULL;
+		for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(pSeq); i++)
+			lstClients.push_back((uint)PyInt_AsUnsignedLongMask(PySequence_Fast_GET_ITEM(pSeq, i)));
+		Py_DECREF(pSeq);
+		if (lstClients.empty())
+			return PyInt_FromLong(0);
+	}
+
+	wstring wscXML;
+	if (!MessageTemplateRender(szName, pParams, wscXML)) {
+		PyErr_SetString(PyExc_ValueError, "unknown message template");
+		return NULL;
+	}
+	int iSent = MessageTemplateSend(wscXML, lstClients);
+	if (iSent < 0) {
+		PyErr_SetString(PyExc_ValueError, "message does not encode, too long?");
+		return NULL;
+	}
+	return PyInt_FromLong(iSent);
+}
+static PyObject* emb_Distances(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pFrom, *pPoints;
+	if (!PyArg_ParseTuple(pArgs, "OO", &pFrom, &pPoints))
+		return NULL;
+	Vector vFrom;
+	vector<float> vStorage;
+	const float *pData;
+	uint iCount;
+	if (!pyToVector(pFrom, vFrom) || !pyToPoints(pPoints, vStorage, pData, iCount))
+		return NULL;
+	PyObject *pResult = PyByteArray_FromStringAndSize(NULL, iCount * sizeof(float));
+	if (pResult && iCount)
+		MathDistances(vFrom, pData, iCount, (float*)PyByteArray_AS_STRING(pResult));
+	return pResult;
+}
+static PyObject* emb_WithinRange(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pFrom, *pPoints;
+	float fRange;
+	if (!PyArg_ParseTuple(pArgs, "OfO", &pFrom, &fRange, &pPoints))
+		return NULL;
+	Vector vFrom;
+	vector<float> vStorage;
+	const float *pData;
+	uint iCount;
+	if (!pyToVector(pFrom, vFrom) || !pyToPoints(pPoints, vStorage, pData, iCount))
+		return NULL;
+	vector<uint> vIndices;
+	if (iCount)
+		MathWithinRange(vFrom, fRange, pData, iCount, vIndices);
+	PyObject *pResult = PyTuple_New(vIndices.size());
+	for (uint i = 0; i < vIndices.size(); i++)
+		PyTuple_SET_ITEM(pResult, i, PyInt_FromSize_t(vIndices[i]));
+	return pResult;
+}
+static PyObject* emb_NormalizeVectors(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pPoints;
+	if (!PyArg_ParseTuple(pArgs, "O", &pPoints))
+		return NULL;
+	vector<float> vStorage;
+	const float *pData;
+	uint iCount;
+	if (!pyToPoints(pPoints, vStorage, pData, iCount))
+		return NULL;
+	PyObject *pResult = PyByteArray_FromStringAndSize(NULL, iCount * 3 * sizeof(float));
+	if (pResult && iCount)
+		MathNormalize(pData, iCount, (float*)PyByteArray_AS_STRING(pResult));
+	return pResult;
+}
+static PyObject* emb_GetShipInfo(PyObject *self, PyObject *pArgs)
+{
+	uint iShip;
+	if (!PyArg_ParseTuple(pArgs, "I", &iShip))
+		return NULL;
+	const SHIP_ENTRY *pEntry = ShipRegistryFind(iShip);
+	if (!pEntry)
+		Py_RETURN_NONE;
+	return Py_BuildValue("(IIIK)", pEntry->iArchID, pEntry->iClientID, pEntry->iSystem, timeInMS() - pEntry->tmSpawn);
+}
+static PyObject* emb_GetSystemShipCounts(PyObject *self, PyObject *pArgs)
+{
+	uint iSystem = 0;
+	if (!PyArg_ParseTuple(pArgs, "|I", &iSystem))
+		return NULL;
+	if (!iSystem)
+		return ShipRegistryAllCounts();
+	uint iNPCs = 0, iPlayers = 0;
+	ShipRegistrySystemCounts(iSystem, iNPCs, iPlayers);
+	return Py_BuildValue("(II)", iNPCs, iPlayers);
+}
+static PyObject* emb_GetShipsInSystem(PyObject *self, PyObject *pArgs)
+{
+	uint iSystem;
+	PyObject *pPlayers = Py_None;
+	if (!PyArg_ParseTuple(pArgs, "I|O", &iSystem, &pPlayers))
+		return NULL;
+	list<uint> lstShips;
+	ShipRegistryInSystem(iSystem, pPlayers == Py_None ? -1 : PyObject_IsTrue(pPlayers), lstShips);
+	PyObject *pShips = PyTuple_New(lstShips.size());
+	uint i = 0;
+	for (list<uint>::iterator it = lstShips.begin(); it != lstShips.end(); ++it, ++i)
+		PyTuple_SET_ITEM(pShips, i, PyInt_FromSize_t(*it));
+	return pShips;
+}
+static PyObject* emb_SetShipEvents(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pEnabled;
+	if (!PyArg_ParseTuple(pArgs, "O", &pEnabled))
+		return NULL;
+	bShipEvents = PyObject_IsTrue(pEnabled) == 1;
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetAllPlayers(PyObject *self, PyObject *pArgs, PyObject *pKwArgs)
+{
+	static char *kwlist[] = { "fields", "packed", NULL };
+	PyObject *pFields = Py_None, *pPacked = Py_False;
+	if (!PyArg_ParseTupleAndKeywords(pArgs, pKwArgs, "|OO", kwlist, &pFields, &pPacked))
+		return NULL;
+	list<int> lstFields;
+	if (pFields == Py_None) {
+		for (int i = 0; i < PQF_COUNT; i++)
+			lstFields.push_back(i);
+	}
+	else {
+		PyObject *pSeq = PySequence_Fast(pFields, "fields must be a sequence of field names");
+		if (!pSeq)
+			return NULL;
+		for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(pSeq); i++) {
+			PyObject *pName = PySequence_Fast_GET_ITEM(pSeq, i);
+			int iField = PyString_Check(pName) ? PlayerFieldByName(PyString_AS_STRING(pName)) : -1;
+			if (iField < 0) {
+				Py_DECREF(pSeq);
+				PyErr_SetString(PyExc_ValueError, "unknown player field");
+				return NULL;
+			}
+			lstFields.push_back(iField);
+		}
+		Py_DECREF(pSeq);
+	}
+	return PlayerQuery(lstFields, PyObject_IsTrue(pPacked) == 1);
+}
+static PyObject* emb_SetChangeFeed(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pEnabled;
+	float fBucket = 0;
+	if (!PyArg_ParseTuple(pArgs, "O|f", &pEnabled, &fBucket))
+		return NULL;
+	SetChangeFeed(PyObject_IsTrue(pEnabled) == 1, fBucket);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_ReadChanges(PyObject *self, PyObject *pArgs)
+{
+	unsigned PY_LONG_LONG iCursor = 0;
+	uint iMax = 0;
+	if (!PyArg_ParseTuple(pArgs, "|KI", &iCursor, &iMax))
+		return NULL;
+	return ChangeFeedRead(iCursor, iMax);
+}
+static PyObject* emb_AddCashBatch(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pItems;
+	if (!PyArg_ParseTuple(pArgs, "O", &pItems))
+		return NULL;
+	return BatchAddCash(pItems);
+}
+static PyObject* emb_SetRepBatch(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pItems;
+	if (!PyArg_ParseTuple(pArgs, "O", &pItems))
+		return NULL;
+	return BatchSetRep(pItems);
+}
+static PyObject* emb_AddCargoBatch(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pItems;
+	if (!PyArg_ParseTuple(pArgs, "O", &pItems))
+		return NULL;
+	return BatchAddCargo(pItems);
+}
+static PyObject* emb_MsgBatch(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pItems;
+	if (!PyArg_ParseTuple(pArgs, "O", &pItems))
+		return NULL;
+	return BatchMsg(pItems);
+}
+static PyObject* emb_SaveCharAsync(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pCharname;
+	uint iWindow = 1000;
+	if (!PyArg_ParseTuple(pArgs, "O|I", &pCharname, &iWindow))
+		return NULL;
+	SaveCharAsync(pyunitows(pCharname), iWindow);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_WriteFileAsync(PyObject *self, PyObject *pArgs)
+{
+	const char *szPath, *szData;
+	int iLength;
+	PyObject *pAppend = Py_False;
+	if (!PyArg_ParseTuple(pArgs, "ss#|O", &szPath, &szData, &iLength, &pAppend))
+		return NULL;
+	WriteFileAsync(szPath, string(szData, iLength), PyObject_IsTrue(pAppend) == 1);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetAsyncStats(PyObject *self, PyObject *pArgs)
+{
+	return Py_BuildValue("{s:I,s:I,s:I,s:I,s:I,s:I,s:I}", "saves_queued", AsyncStats.iSavesQueued, "saves", AsyncStats.iSaves,
+		"writes_queued", AsyncStats.iWritesQueued, "writes", AsyncStats.iWrites, "merged", AsyncStats.iMerged,
+		"failed", AsyncStats.iFailed, "pending", AsyncPending());
+}
+static PyObject* emb_Log(PyObject *self, PyObject *pArgs)
+{
+	Py_ssize_t iSize = PyTuple_Size(pArgs);
+	if (iSize < 1 || !PyInt_Check(PyTuple_GET_ITEM(pArgs, 0))) {
+		PyErr_SetString(PyExc_TypeError, "Log(int level, *args)");
+		return NULL;
+	}
+	long iLevel = PyInt_AS_LONG(PyTuple_GET_ITEM(pArgs, 0));
+	if (iLevel < LOG_DEBUG || iLevel > LOG_ERROR) {
+		PyErr_SetString(PyExc_ValueError, "level must be one of the LOG_ constants");
+		return NULL;
+	}
+	wstring wscText;
+	for (Py_ssize_t i = 1; i < iSize; i++) {
+		if (i > 1)
+			wscText += L" ";
+		wscText += pyunitows(PyTuple_GET_ITEM(pArgs, i));
+	}
+	LogWrite((LOG_LEVEL)iLevel, wscText);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_SetLogLevel(PyObject *self, PyObject *pArgs)
+{
+	int iLevel;
+	if (!PyArg_ParseTuple(pArgs, "i", &iLevel))
+		return NULL;
+	if (iLevel < LOG_DEBUG || iLevel > LOG_ERROR) {
+		PyErr_SetString(PyExc_ValueError, "level must be one of the LOG_ constants");
+		return NULL;
+	}
+	SetLogLevel((LOG_LEVEL)iLevel);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetLogStats(PyObject *self, PyObject *pArgs)
+{
+	return Py_BuildValue("{s:I,s:I,s:I}", "lines", LogStats.iLines, "suppressed", LogStats.iSuppressed, "dropped", LogStats.iDropped);
+}
+static PyObject* emb_GetErrors(PyObject *self, PyObject *pArgs)
+{
+	return TracebackErrors();
+}
+static PyObject* emb_ClearErrors(PyObject *self, PyObject *pArgs)
+{
+	TracebackClear();
+	Py_RETURN_NONE;
+}
+static PyObject* emb_SetTracebackSamples(PyObject *self, PyObject *pArgs)
+{
+	uint iSamples;
+	if (!PyArg_ParseTuple(pArgs, "I", &iSamples))
+		return NULL;
+	SetTracebackSamples(iSamples);
+	Py_RETURN_NONE;
+}
+static PyObject* emb_Store(PyObject *self, PyObject *pArgs)
+{
+	const char *szName;
+	if (!PyArg_ParseTuple(pArgs, "s", &szName))
+		return NULL;
+	return pyStore(szName);
+}
+static PyObject* emb_CheckStore(PyObject *self, PyObject *pArgs)
+{
+	uint iRecords = 1000;
+	if (!PyArg_ParseTuple(pArgs, "|I", &iRecords))
+		return NULL;
+	return StoreCheck(iRecords);
+}
+static PyObject* emb_ReadIni(PyObject *self, PyObject *pArgs)
+{
+	const char *szPath;
+	if (!PyArg_ParseTuple(pArgs, "s", &szPath))
+		return NULL;
+	return IniRead(szPath);
+}
+static PyObject* emb_ReadCharFile(PyObject *self, PyObject *pArgs)
+{
+	PyObject *pCharname;
+	if (!PyArg_ParseTuple(pArgs, "O", &pCharname))
+		return NULL;
+	return IniReadChar(pytows(pCharname));
+}
+static PyObject* emb_GetIniValues(PyObject *self, PyObject *pArgs)
+{
+	const char *szPath, *szSection, *szKey;
+	if (!PyArg_ParseTuple(pArgs, "sss", &szPath, &szSection, &szKey))
+		return NULL;
+	return IniValues(szPath, szSection, szKey);
+}
+static PyObject* emb_ClearIniCache(PyObject *self, PyObject *pArgs)
+{
+	IniCacheClear();
+	Py_RETURN_NONE;
+}
+static PyObject* emb_GetIniCacheStats(PyObject *self, PyObject *pArgs)
+{
+	return Py_BuildValue("{s:I,s:I,s:I,s:I}", "hits", IniCacheStats.iHits, "misses", IniCacheStats.iMisses,
+		"invalidated", IniCacheStats.iInvalidated, "files", IniCacheSize());
+}
+
 
 static PyMethodDef FLHookMethods[] = {
 	{ "ConPrint", emb_ConPrint, METH_VARARGS, "ConPrint(str text)" },
@@ -482,6 +1277,73 @@ static PyMethodDef FLHookMethods[] = {
 
 	// Custom
 	{ "HkGetCharnameFromClientId", emb_HkGetCharnameFromClientId, METH_VARARGS, "str charname = HkGetCharnameFromClientId(int client_id)" },
+	{ "SetFusedHook", emb_SetFusedHook, METH_VARARGS, "SetFusedHook(str event, bool fused)" },
+	{ "GetMarshalStats", emb_GetMarshalStats, METH_VARARGS, "dict stats = GetMarshalStats()" },
+	{ "CheckTupleReuse", emb_CheckTupleReuse, METH_VARARGS, "dict result = CheckTupleReuse(int events=1000)" },
+	{ "SetGCPolicy", emb_SetGCPolicy, METH_VARARGS, "SetGCPolicy(bool managed, int gen0_threshold, int gen1_threshold, float full_interval)" },
+	{ "GetGCStats", emb_GetGCStats, METH_VARARGS, "dict stats = GetGCStats()" },
+	{ "SetLeakSentinel", emb_SetLeakSentinel, METH_VARARGS, "SetLeakSentinel(bool enabled, int interval, int window)" },
+	{ "GetLeakReport", emb_GetLeakReport, METH_VARARGS, "dict report = GetLeakReport()" },
+	{ "SetNativeHandler", emb_SetNativeHandler, METH_VARARGS, "SetNativeHandler(str event, capsule handler)" },
+	{ "GetNativeStats", emb_GetNativeStats, METH_VARARGS, "dict stats = GetNativeStats()" },
+	{ "SetDamageObserver", emb_SetDamageObserver, METH_VARARGS, "SetDamageObserver(bool enabled)" },
+	{ "SetKillTracking", emb_SetKillTracking, METH_VARARGS, "SetKillTracking(bool enabled, float half_life, float expiry)" },
+	{ "SetSequenceTracking", emb_SetSequenceTracking, METH_VARARGS, "SetSequenceTracking(bool enabled, bool outcomes_only)" },
+	{ "SetRateLimit", emb_SetRateLimit, METH_VARARGS, "SetRateLimit(str event, float rate, float burst, int action)" },
+	{ "GetRateLimitStats", emb_GetRateLimitStats, METH_VARARGS, "dict stats = GetRateLimitStats()" },
+	{ "IsRateLimited", emb_IsRateLimited, METH_VARARGS, "bool limited = IsRateLimited()" },
+	{ "RateLimit", emb_RateLimit, METH_VARARGS, "bool allowed = RateLimit(int client_id, str key, float rate, float burst)" },
+	{ "Cooldown", emb_Cooldown, METH_VARARGS, "int remaining_ms = Cooldown(int client_id, str key, int ms)" },
+	{ "AdmissionAddIP", emb_AdmissionAddIP, METH_VARARGS, "AdmissionAddIP(str ip_range, int verdict)" },
+	{ "AdmissionBanAccount", emb_AdmissionBanAccount, METH_VARARGS, "AdmissionBanAccount(str account_id, bool banned)" },
+	{ "AdmissionSetRate", emb_AdmissionSetRate, METH_VARARGS, "AdmissionSetRate(int max, int window_ms, int action)" },
+	{ "AdmissionLoad", emb_AdmissionLoad, METH_VARARGS, "int rules = AdmissionLoad(str path)" },
+	{ "AdmissionClear", emb_AdmissionClear, METH_VARARGS, "AdmissionClear()" },
+	{ "GetAdmissionStats", emb_GetAdmissionStats, METH_VARARGS, "dict stats = GetAdmissionStats()" },
+	{ "ChatFilterAdd", emb_ChatFilterAdd, METH_VARARGS, "int added = ChatFilterAdd(list patterns, int action, bool whole_word)" },
+	{ "ChatFilterClear", emb_ChatFilterClear, METH_VARARGS, "ChatFilterClear()" },
+	{ "GetChatFilterStats", emb_GetChatFilterStats, METH_VARARGS, "dict stats = GetChatFilterStats()" },
+	{ "ChannelCreate", emb_ChannelCreate, METH_VARARGS, "ChannelCreate(str name, int filter, int value)" },
+	{ "ChannelDelete", emb_ChannelDelete, METH_VARARGS, "bool deleted = ChannelDelete(str name)" },
+	{ "ChannelJoin", emb_ChannelJoin, METH_VARARGS, "ChannelJoin(str name, int client_id, bool join)" },
+	{ "ChannelSend", emb_ChannelSend, METH_VARARGS, "int sent = ChannelSend(str name, int from_client_id, str text, bool xml)" },
+	{ "GetChannelMembers", emb_GetChannelMembers, METH_VARARGS, "tuple client_ids = GetChannelMembers(str name)" },
+	{ "SetOutbox", emb_SetOutbox, METH_VARARGS, "SetOutbox(bool enabled)" },
+	{ "FlushOutbox", emb_FlushOutbox, METH_VARARGS, "FlushOutbox(int client_id)" },
+	{ "GetOutboxStats", emb_GetOutboxStats, METH_VARARGS, "dict stats = GetOutboxStats()" },
+	{ "RegisterMessageTemplate", emb_RegisterMessageTemplate, METH_VARARGS, "RegisterMessageTemplate(str name, str xml)" },
+	{ "RemoveMessageTemplate", emb_RemoveMessageTemplate, METH_VARARGS, "bool removed = RemoveMessageTemplate(str name)" },
+	{ "SendMessageTemplate", emb_SendMessageTemplate, METH_VARARGS, "int sent = SendMessageTemplate(str name, targets, dict params)" },
+	{ "Distances", emb_Distances, METH_VARARGS, "bytearray distances = Distances(Vec3 point, points)" },
+	{ "WithinRange", emb_WithinRange, METH_VARARGS, "tuple indices = WithinRange(Vec3 point, float range, points)" },
+	{ "NormalizeVectors", emb_NormalizeVectors, METH_VARARGS, "bytearray vectors = NormalizeVectors(points)" },
+	{ "GetShipInfo", emb_GetShipInfo, METH_VARARGS, "tuple info = GetShipInfo(int ship_id)" },
+	{ "GetSystemShipCounts", emb_GetSystemShipCounts, METH_VARARGS, "tuple counts = GetSystemShipCounts(int system_id)" },
+	{ "GetShipsInSystem", emb_GetShipsInSystem, METH_VARARGS, "tuple ship_ids = GetShipsInSystem(int system_id, bool players)" },
+	{ "SetShipEvents", emb_SetShipEvents, METH_VARARGS, "SetShipEvents(bool enabled)" },
+	{ "GetAllPlayers", (PyCFunction)emb_GetAllPlayers, METH_VARARGS | METH_KEYWORDS, "dict columns = GetAllPlayers(fields=None, packed=False)" },
+	{ "SetChangeFeed", emb_SetChangeFeed, METH_VARARGS, "SetChangeFeed(bool enabled, float bucket)" },
+	{ "ReadChanges", emb_ReadChanges, METH_VARARGS, "tuple (cursor, records, complete) = ReadChanges(int cursor, int max)" },
+	{ "AddCashBatch", emb_AddCashBatch, METH_VARARGS, "tuple errors = AddCashBatch(items)" },
+	{ "SetRepBatch", emb_SetRepBatch, METH_VARARGS, "tuple errors = SetRepBatch(items)" },
+	{ "AddCargoBatch", emb_AddCargoBatch, METH_VARARGS, "tuple errors = AddCargoBatch(items)" },
+	{ "MsgBatch", emb_MsgBatch, METH_VARARGS, "tuple errors = MsgBatch(items)" },
+	{ "SaveCharAsync", emb_SaveCharAsync, METH_VARARGS, "SaveCharAsync(str charname, int window)" },
+	{ "WriteFileAsync", emb_WriteFileAsync, METH_VARARGS, "WriteFileAsync(str path, str data, bool append)" },
+	{ "GetAsyncStats", emb_GetAsyncStats, METH_VARARGS, "dict stats = GetAsyncStats()" },
+	{ "Log", emb_Log, METH_VARARGS, "Log(int level, *args)" },
+	{ "SetLogLevel", emb_SetLogLevel, METH_VARARGS, "SetLogLevel(int level)" },
+	{ "GetLogStats", emb_GetLogStats, METH_VARARGS, "dict stats = GetLogStats()" },
+	{ "GetErrors", emb_GetErrors, METH_VARARGS, "tuple errors = GetErrors()" },
+	{ "ClearErrors", emb_ClearErrors, METH_VARARGS, "ClearErrors()" },
+	{ "SetTracebackSamples", emb_SetTracebackSamples, METH_VARARGS, "SetTracebackSamples(int samples)" },
+	{ "Store", emb_Store, METH_VARARGS, "KVStore store = Store(str name)" },
+	{ "ReadIni", emb_ReadIni, METH_VARARGS, "tuple sections = ReadIni(str path)" },
+	{ "ReadCharFile", emb_ReadCharFile, METH_VARARGS, "tuple sections = ReadCharFile(str charname)" },
+	{ "GetIniValues", emb_GetIniValues, METH_VARARGS, "tuple values = GetIniValues(str path, str section, str key)" },
+	{ "ClearIniCache", emb_ClearIniCache, METH_VARARGS, "ClearIniCache()" },
+	{ "GetIniCacheStats", emb_GetIniCacheStats, METH_VARARGS, "dict stats = GetIniCacheStats()" },
+	{ "CheckStore", emb_CheckStore, METH_VARARGS, "dict result = CheckStore(int records=1000)" },
 
 	{ NULL, NULL, 0, NULL }
 };
@@ -663,7 +1525,7 @@ static PyObject* emb_DamageList_GetAttr(PyObject *self, PyObject *pArgs)
 	case 0:
 		return Py_BuildValue("I", ptr->iDunno1);
 	case 1:
-		return Py_BuildValue("N", ptr->damageentries);
+		return ToPython(ptr->damageentries);
 	case 2:
 		return Py_BuildValue("O", PY_BOOL(ptr->bDestroyed));
 	case 3:
@@ -814,5 +1676,9 @@ void BuildEmbedded()
 	pException = PyErr_NewException("FLHook.Error", NULL, NULL);
 	Py_INCREF(pException); // we need to manually inc the ref count here due to the next line
 	PyModule_AddObject(pHook, "Error", pException); // reference stealer
+
+	InitPayloadType(pHook);
+	InitMathTypes(pHook);
+	InitStoreType(pHook);
 }
 
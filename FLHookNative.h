@@ -0,0 +1,73 @@
+#ifndef __FLHOOK_NATIVE_H__
+#define __FLHOOK_NATIVE_H__ 1
+
+/*
+FLHookNative.h - the ABI for native (C) event handlers, include this in a compiled python extension.
+
+The extension exports a capsule named FLHOOK_NATIVE_CAPSULE pointing at a (static) FLHOOK_NATIVE_HANDLER_INFO,
+which a script registers with FLHook.SetNativeHandler(event, capsule). The plugin then calls pHandler for that
+event with the raw hook data, before (and usually instead of) the python callback.
+
+	static int MyObjUpdate(const FLHOOK_NATIVE_CONTEXT *ctx, void *pData) { ... return FNR_DEFAULT; }
+	static FLHOOK_NATIVE_HANDLER_INFO info = { FLHOOK_NATIVE_ABI_VERSION, MyObjUpdate, NULL };
+	PyModule_AddObject(m, "obj_update", PyCapsule_New(&info, FLHOOK_NATIVE_CAPSULE, NULL));
+
+pData per event (the _AFTER events get the same):
+	HkCbIServerImpl_SPObjUpdate - const SSPObjUpdateInfo*
+	HkCbIServerImpl_FireWeapon - const XFireWeaponInfo*
+	HkCb_AddDmgEntry - FLHOOK_NATIVE_DMGENTRY*
+
+The ABI version is only bumped for incompatible changes, new fields are added to the end of
+FLHOOK_NATIVE_CONTEXT and can be detected with iSize.
+*/
+
+#define FLHOOK_NATIVE_ABI_VERSION 1
+#define FLHOOK_NATIVE_CAPSULE "FLHook.NativeHandler"
+
+enum FLHOOK_NATIVE_EVENT
+{
+	FNE_SPObjUpdate,
+	FNE_SPObjUpdate_AFTER,
+	FNE_FireWeapon,
+	FNE_FireWeapon_AFTER,
+	FNE_AddDmgEntry,
+	FNE_AddDmgEntry_AFTER,
+	FNE_COUNT
+};
+
+// handler return values, the same as the python callback returncodes
+#define FNR_DEFAULT 0
+#define FNR_SKIPPLUGINS 1
+#define FNR_SKIPPLUGINS_NOFUNCTIONCALL 2
+#define FNR_NOFUNCTIONCALL 3
+// or'd with the above: also call the python callback. If the callback returns 1-3 that replaces the handlers
+// returncode, anything else (None, 0...) leaves the handlers returncode in place
+#define FNR_PYTHON 0x100
+
+struct FLHOOK_NATIVE_CONTEXT
+{
+	unsigned int iABIVersion; // FLHOOK_NATIVE_ABI_VERSION of the plugin
+	unsigned int iSize; // sizeof(FLHOOK_NATIVE_CONTEXT) of the plugin
+	unsigned int iEvent; // FLHOOK_NATIVE_EVENT
+	unsigned int iClientID; // 0 if the event has none
+	void *pUserData; // FLHOOK_NATIVE_HANDLER_INFO::pUserData
+};
+
+struct FLHOOK_NATIVE_DMGENTRY
+{
+	struct DamageList *dmg;
+	unsigned short iSubObjID;
+	float fHitPoints;
+	int iFate; // DamageEntry::SubObjFate
+};
+
+typedef int (__cdecl *FLHOOK_NATIVE_HANDLER)(const struct FLHOOK_NATIVE_CONTEXT *ctx, void *pData);
+
+struct FLHOOK_NATIVE_HANDLER_INFO
+{
+	unsigned int iABIVersion; // FLHOOK_NATIVE_ABI_VERSION the extension was built with
+	FLHOOK_NATIVE_HANDLER pHandler;
+	void *pUserData;
+};
+
+#endif
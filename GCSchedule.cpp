@@ -0,0 +1,177 @@
+#include "headers.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+GC Scheduling - pythons cyclic garbage collector normally runs whenever its allocation thresholds trip, which
+tends to be in the middle of a SPObjUpdate burst, stalling the frame. When managed (the default) we turn the
+automatic collector off and run it ourselves at the end of a server tick (HkCb_Update_Time_AFTER):
+
+	gen 0/1 - once gen 0 passes its threshold, collect if the time left in this tick (the average tick length
+		minus the work done so far) is larger then the average pause for that generation. If we keep
+		missing the slack, the collection is forced once gen 0 reaches GC_FORCE_FACTOR * threshold.
+	gen 2 - a full collection every fFullInterval seconds, preferably with slack, forced at twice the interval.
+
+All pause times are recorded in GCStats.iHistogram, see FLHook.GetGCStats()
+*/
+GC_POLICY GCPolicy = { true, 700, 10, 300.0f };
+GC_STATS GCStats;
+
+// upper bounds (ms) of the histogram buckets, the last bucket catches everything above
+const double GC_BUCKETS_MS[GC_HISTOGRAM_SIZE - 1] = { 0.1, 0.25, 0.5, 1.0, 2.0, 5.0, 10.0, 25.0, 50.0 };
+
+#define GC_FORCE_FACTOR 10
+#define GC_EMA_WEIGHT 0.1
+
+static PyObject *pGCEnable; // gc.enable
+static PyObject *pGCDisable; // gc.disable
+static PyObject *pGCCollect; // gc.collect
+static PyObject *pGCGetCount; // gc.get_count
+
+static double dTickStart; // ms
+static double dTickPeriod; // ms, average time between 2 ticks
+static double dPauseAvg[3]; // ms, average pause per generation
+static double dLastFull; // ms
+
+static double GCNow()
+{
+	static double dFreq = 0;
+	LARGE_INTEGER li;
+	if (dFreq == 0) {
+		QueryPerformanceFrequency(&li);
+		dFreq = (double)li.QuadPart / 1000.0;
+	}
+	QueryPerformanceCounter(&li);
+	return (double)li.QuadPart / dFreq;
+}
+
+static void GCRecordPause(int iGen, double dPause)
+{
+	uint iBucket = 0;
+	while (iBucket < GC_HISTOGRAM_SIZE - 1 && dPause > GC_BUCKETS_MS[iBucket])
+		iBucket++;
+	GCStats.iHistogram[iGen][iBucket]++;
+	GCStats.iCollections[iGen]++;
+	if (dPause > GCStats.dMaxPause[iGen])
+		GCStats.dMaxPause[iGen] = dPause;
+	dPauseAvg[iGen] = dPauseAvg[iGen] == 0 ? dPause : dPauseAvg[iGen] + (dPause - dPauseAvg[iGen]) * GC_EMA_WEIGHT;
+}
+
+static void GCCollect(int iGen)
+{
+	double dStart = GCNow();
+	PyObject *pResult = PyObject_CallFunction(pGCCollect, "i", iGen);
+	double dEnd = GCNow();
+	Py_XDECREF(pResult);
+	if (CheckPyException()) {
+		ERRMSG(L"ERROR gc.collect() failed");
+		return;
+	}
+	GCRecordPause(iGen, dEnd - dStart);
+	if (iGen == 2)
+		dLastFull = dEnd;
+}
+
+static void GCSetAutomatic(bool bAutomatic)
+{
+	if (pGCEnable == NULL)
+		return;
+	PyObject *pResult = PyObject_CallObject(bAutomatic ? pGCEnable : pGCDisable, NULL);
+	Py_XDECREF(pResult);
+	CheckPyException();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StartGC()
+{
+	PyObject *pGC = PyImport_ImportModule("gc");
+	if (pGC == NULL) {
+		CheckPyException();
+		ERRMSG(L"ERROR importing gc, GC scheduling disabled");
+		GCPolicy.bManaged = false;
+		return;
+	}
+	pGCEnable = PyObject_GetAttrString(pGC, "enable");
+	pGCDisable = PyObject_GetAttrString(pGC, "disable");
+	pGCCollect = PyObject_GetAttrString(pGC, "collect");
+	pGCGetCount = PyObject_GetAttrString(pGC, "get_count");
+	Py_DECREF(pGC);
+	if (CheckPyException()) {
+		ERRMSG(L"ERROR reading the gc module, GC scheduling disabled");
+		GCPolicy.bManaged = false;
+		return;
+	}
+	dLastFull = GCNow();
+	SetGCPolicy(GCPolicy);
+}
+
+void StopGC()
+{
+	GCSetAutomatic(true);
+	Py_XDECREF(pGCEnable);
+	Py_XDECREF(pGCDisable);
+	Py_XDECREF(pGCCollect);
+	Py_XDECREF(pGCGetCount);
+	pGCEnable = pGCDisable = pGCCollect = pGCGetCount = NULL;
+}
+
+void SetGCPolicy(const GC_POLICY &policy)
+{
+	GCPolicy = policy;
+	GCSetAutomatic(!GCPolicy.bManaged || pGCCollect == NULL);
+}
+
+void GCTickStart()
+{
+	double dNow = GCNow();
+	if (dTickStart != 0) {
+		double dPeriod = dNow - dTickStart;
+		dTickPeriod = dTickPeriod == 0 ? dPeriod : dTickPeriod + (dPeriod - dTickPeriod) * GC_EMA_WEIGHT;
+	}
+	dTickStart = dNow;
+}
+
+void GCTickEnd()
+{
+	if (!GCPolicy.bManaged || pGCCollect == NULL || dTickStart == 0)
+		return;
+
+	double dNow = GCNow();
+	double dSlack = dTickPeriod - (dNow - dTickStart);
+
+	// long cadence full collection
+	double dSinceFull = dNow - dLastFull;
+	double dFullInterval = GCPolicy.fFullInterval * 1000.0;
+	if (dFullInterval > 0 && dSinceFull >= dFullInterval) {
+		if (dSlack >= dPauseAvg[2] || dSinceFull >= dFullInterval * 2) {
+			if (dSlack < dPauseAvg[2])
+				GCStats.iForced++;
+			GCCollect(2);
+			return;
+		}
+		GCStats.iDeferred++;
+	}
+
+	PyObject *pCount = PyObject_CallObject(pGCGetCount, NULL);
+	int iCount0 = 0, iCount1 = 0, iCount2 = 0;
+	if (pCount == NULL || !PyArg_ParseTuple(pCount, "iii", &iCount0, &iCount1, &iCount2)) {
+		Py_XDECREF(pCount);
+		CheckPyException();
+		return;
+	}
+	Py_DECREF(pCount);
+
+	if (iCount0 < GCPolicy.iThreshold0)
+		return;
+	int iGen = iCount1 >= GCPolicy.iThreshold1 ? 1 : 0;
+	if (dSlack >= dPauseAvg[iGen]) {
+		GCCollect(iGen);
+	}
+	else if (iCount0 >= GCPolicy.iThreshold0 * GC_FORCE_FACTOR) {
+		GCStats.iForced++;
+		GCCollect(iGen);
+	}
+	else {
+		GCStats.iDeferred++;
+	}
+}
@@ -0,0 +1,317 @@
+#include "headers.h"
+#include <map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+INI cache - FLHook.ReadIni(), ReadCharFile() and GetIniValues() read freelancer style ini files (character
+and account files mostly) natively instead of parsing them in python.
+
+A file is memory mapped and copied into one buffer once (decoding it if FL saved it encrypted, "FLS1"), then
+tokenised in place: every section and key = value line is just an offset and length into that buffer, no
+string per token. The parsed file is cached by path and reused until the file's modification time or size
+changes, so asking for the same character file again is a stat() and a map lookup. The python tuple built
+for ReadIni is cached with it and handed out again (tuples are immutable).
+
+FL writes a character file when it's saved, the player switches characters and on disconnect, and the
+modification time has a granularity that can miss a save made right after a read, so the cache entry of
+the character is also dropped in those hooks and after HkSaveChar.
+*/
+INI_CACHE_STATS IniCacheStats;
+
+#define INI_CACHE_MAX 1024 // files, the least recently used is dropped after that
+
+struct INI_ENTRY
+{
+	uint iKey, iKeyLen;
+	uint iValue, iValueLen;
+};
+
+struct INI_SECTION
+{
+	uint iName, iNameLen;
+	uint iFirst, iCount; // entries
+};
+
+struct INI_FILE
+{
+	FILETIME ftWrite;
+	uint iSize;
+	uint iLastUse;
+	string scData; // the decoded file, every token points into it
+	vector<INI_SECTION> vSections;
+	vector<INI_ENTRY> vEntries;
+	PyObject *pTuple; // built on the first ReadIni, NULL until then
+};
+
+static map<string, INI_FILE> mapIniCache; // by lower case path
+static uint iIniUseCounter = 0;
+
+static string IniPathKey(const string &scPath)
+{
+	string scKey = scPath;
+	for (uint i = 0; i < scKey.length(); i++)
+		scKey[i] = scKey[i] == '/' ? '\\' : (char)tolower((unsigned char)scKey[i]);
+	return scKey;
+}
+
+static inline bool IniSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// FL's save file encryption, a byte xor with a running key
+static void IniDecodeFLS1(const unsigned char *pIn, uint iSize, string &scOut)
+{
+	static const char szGene[] = "Gene";
+	scOut.resize(iSize);
+	for (uint i = 0; i < iSize; i++)
+		scOut[i] = (char)(pIn[i] ^ (((szGene[i & 3] + i) & 0xFF) | 0x80));
+}
+
+static void IniTokenise(INI_FILE &file)
+{
+	const char *pData = file.scData.data();
+	uint iSize = file.scData.size();
+	uint iPos = 0;
+	while (iPos < iSize) {
+		uint iLineEnd = iPos;
+		while (iLineEnd < iSize && pData[iLineEnd] != '\n')
+			iLineEnd++;
+		uint iEnd = iLineEnd;
+		for (uint i = iPos; i < iEnd; i++) {
+			if (pData[i] == ';') { // comment
+				iEnd = i;
+				break;
+			}
+		}
+		while (iPos < iEnd && IniSpace(pData[iPos]))
+			iPos++;
+		while (iEnd > iPos && IniSpace(pData[iEnd - 1]))
+			iEnd--;
+
+		if (iPos < iEnd && pData[iPos] == '[') {
+			INI_SECTION section;
+			section.iName = iPos + 1;
+			uint iClose = iPos + 1;
+			while (iClose < iEnd && pData[iClose] != ']')
+				iClose++;
+			section.iNameLen = iClose - section.iName;
+			section.iFirst = file.vEntries.size();
+			section.iCount = 0;
+			file.vSections.push_back(section);
+		}
+		else if (iPos < iEnd && !file.vSections.empty()) { // lines before the first section are ignored, like FL does
+			INI_ENTRY entry;
+			uint iEquals = iPos;
+			while (iEquals < iEnd && pData[iEquals] != '=')
+				iEquals++;
+			uint iKeyEnd = iEquals;
+			while (iKeyEnd > iPos && IniSpace(pData[iKeyEnd - 1]))
+				iKeyEnd--;
+			entry.iKey = iPos;
+			entry.iKeyLen = iKeyEnd - iPos;
+			uint iValue = iEquals < iEnd ? iEquals + 1 : iEnd;
+			while (iValue < iEnd && IniSpace(pData[iValue]))
+				iValue++;
+			entry.iValue = iValue;
+			entry.iValueLen = iEnd - iValue;
+			file.vEntries.push_back(entry);
+			file.vSections.back().iCount++;
+		}
+		iPos = iLineEnd + 1;
+	}
+}
+
+static bool IniLoad(const string &scPath, INI_FILE &file)
+{
+	HANDLE hFile = CreateFile(scPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	uint iSize = GetFileSize(hFile, NULL);
+	if (iSize) {
+		HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		const unsigned char *pView = hMapping ? (const unsigned char*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+		if (!pView) {
+			if (hMapping)
+				CloseHandle(hMapping);
+			CloseHandle(hFile);
+			return false;
+		}
+		if (iSize >= 4 && !memcmp(pView, "FLS1", 4))
+			IniDecodeFLS1(pView + 4, iSize - 4, file.scData);
+		else
+			file.scData.assign((const char*)pView, iSize);
+		UnmapViewOfFile(pView);
+		CloseHandle(hMapping);
+	}
+	CloseHandle(hFile);
+	IniTokenise(file);
+	return true;
+}
+
+static void IniRelease(INI_FILE &file)
+{
+	Py_XDECREF(file.pTuple);
+	file.pTuple = NULL;
+}
+
+static void IniEvict()
+{
+	map<string, INI_FILE>::iterator itOldest = mapIniCache.begin();
+	for (map<string, INI_FILE>::iterator it = mapIniCache.begin(); it != mapIniCache.end(); ++it) {
+		if (it->second.iLastUse < itOldest->second.iLastUse)
+			itOldest = it;
+	}
+	IniRelease(itOldest->second);
+	mapIniCache.erase(itOldest);
+}
+
+// the parsed file, from the cache if it hasn't changed. NULL if it can't be read
+static INI_FILE* IniGet(const string &scPath)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesEx(scPath.c_str(), GetFileExInfoStandard, &attributes))
+		return NULL;
+	string scKey = IniPathKey(scPath);
+	map<string, INI_FILE>::iterator it = mapIniCache.find(scKey);
+	if (it != mapIniCache.end()) {
+		INI_FILE &file = it->second;
+		if (!CompareFileTime(&file.ftWrite, &attributes.ftLastWriteTime) && file.iSize == attributes.nFileSizeLow) {
+			IniCacheStats.iHits++;
+			file.iLastUse = ++iIniUseCounter;
+			return &file;
+		}
+		IniRelease(file);
+		mapIniCache.erase(it);
+	}
+
+	IniCacheStats.iMisses++;
+	if (mapIniCache.size() >= INI_CACHE_MAX)
+		IniEvict();
+	INI_FILE &file = mapIniCache[scKey];
+	file.pTuple = NULL;
+	if (!IniLoad(scPath, file)) {
+		mapIniCache.erase(scKey);
+		return NULL;
+	}
+	file.ftWrite = attributes.ftLastWriteTime;
+	file.iSize = attributes.nFileSizeLow;
+	file.iLastUse = ++iIniUseCounter;
+	return &file;
+}
+
+static inline PyObject* IniString(const INI_FILE &file, uint iOffset, uint iLength)
+{
+	return PyString_FromStringAndSize(file.scData.data() + iOffset, iLength);
+}
+
+static bool IniCharPath(const wstring &wscCharname, string &scPath)
+{
+	wstring wscDir, wscFile;
+	if (HkGetAccountDirName(wscCharname, wscDir) != HKE_OK || HkGetCharFileName(wscCharname, wscFile) != HKE_OK)
+		return false;
+	scPath = scAcctPath + wstos(wscDir) + "\\" + wstos(wscFile) + ".fl";
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// tuple of (section, ((key, value), ...)) in file order, sections and keys can repeat. NULL with an IOError
+PyObject* IniRead(const string &scPath)
+{
+	INI_FILE *pFile = IniGet(scPath);
+	if (!pFile) {
+		PyErr_SetString(PyExc_IOError, ("can't read " + scPath).c_str());
+		return NULL;
+	}
+	if (!pFile->pTuple) {
+		pFile->pTuple = PyTuple_New(pFile->vSections.size());
+		for (uint i = 0; i < pFile->vSections.size(); i++) {
+			const INI_SECTION &section = pFile->vSections[i];
+			PyObject *pEntries = PyTuple_New(section.iCount);
+			for (uint j = 0; j < section.iCount; j++) {
+				const INI_ENTRY &entry = pFile->vEntries[section.iFirst + j];
+				PyTuple_SET_ITEM(pEntries, j, Py_BuildValue("(NN)", IniString(*pFile, entry.iKey, entry.iKeyLen), IniString(*pFile, entry.iValue, entry.iValueLen)));
+			}
+			PyTuple_SET_ITEM(pFile->pTuple, i, Py_BuildValue("(NN)", IniString(*pFile, section.iName, section.iNameLen), pEntries));
+		}
+	}
+	Py_INCREF(pFile->pTuple);
+	return pFile->pTuple;
+}
+
+// tuple of the values of every scKey in every section scSection (both case insensitive), without building the rest
+PyObject* IniValues(const string &scPath, const string &scSection, const string &scKey)
+{
+	INI_FILE *pFile = IniGet(scPath);
+	if (!pFile) {
+		PyErr_SetString(PyExc_IOError, ("can't read " + scPath).c_str());
+		return NULL;
+	}
+	const char *pData = pFile->scData.data();
+	list<PyObject*> lstValues;
+	for (uint i = 0; i < pFile->vSections.size(); i++) {
+		const INI_SECTION &section = pFile->vSections[i];
+		if (section.iNameLen != scSection.length() || _strnicmp(pData + section.iName, scSection.c_str(), section.iNameLen))
+			continue;
+		for (uint j = section.iFirst; j < section.iFirst + section.iCount; j++) {
+			const INI_ENTRY &entry = pFile->vEntries[j];
+			if (entry.iKeyLen == scKey.length() && !_strnicmp(pData + entry.iKey, scKey.c_str(), entry.iKeyLen))
+				lstValues.push_back(IniString(*pFile, entry.iValue, entry.iValueLen));
+		}
+	}
+	PyObject *pValues = PyTuple_New(lstValues.size());
+	uint i = 0;
+	for (list<PyObject*>::iterator it = lstValues.begin(); it != lstValues.end(); ++it, ++i)
+		PyTuple_SET_ITEM(pValues, i, *it);
+	return pValues;
+}
+
+// IniRead of the character's file, NULL with a FLHook.Error if the character doesn't exist
+PyObject* IniReadChar(const wstring &wscCharname)
+{
+	string scPath;
+	if (!IniCharPath(wscCharname, scPath)) {
+		RaisePyException(HKE_CHAR_DOES_NOT_EXIST);
+		return NULL;
+	}
+	return IniRead(scPath);
+}
+
+// drops the cached file of the character, FL has written (or is about to write) it
+void IniCacheInvalidateChar(const wstring &wscCharname)
+{
+	if (mapIniCache.empty())
+		return;
+	string scPath;
+	if (!IniCharPath(wscCharname, scPath))
+		return;
+	map<string, INI_FILE>::iterator it = mapIniCache.find(IniPathKey(scPath));
+	if (it == mapIniCache.end())
+		return;
+	IniCacheStats.iInvalidated++;
+	IniRelease(it->second);
+	mapIniCache.erase(it);
+}
+
+void IniCacheInvalidateClient(uint iClientID)
+{
+	if (mapIniCache.empty())
+		return;
+	const wchar_t *wszCharname = Players.GetActiveCharacterName(iClientID);
+	if (wszCharname)
+		IniCacheInvalidateChar(wszCharname);
+}
+
+void IniCacheClear()
+{
+	for (map<string, INI_FILE>::iterator it = mapIniCache.begin(); it != mapIniCache.end(); ++it)
+		IniRelease(it->second);
+	mapIniCache.clear();
+}
+
+uint IniCacheSize()
+{
+	return mapIniCache.size();
+}
@@ -0,0 +1,161 @@
+#include "headers.h"
+#include <map>
+#include <math.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Kill ledger - rather then having scripts keep damage ledgers updated on every hit, we keep one per victim
+here. Every hull damage entry (AddDmgEntry, sub object 1) is booked on the victim under the inflicting ship:
+the damage done (the hull health lost, decayed with a half life of fHalfLife seconds), the time of the last
+hit and the last munition that ship hit the victim with. Munitions are booked per victim and inflictor when
+SPMunitionCollision comes in, which only player clients send, so npc inflictors have no weapon arch (0).
+
+When the victim dies (ShipDestroyed) one KillReport event is sent:
+
+	KillReport - (victim_id, victim_client_id, killer_client_id, time_to_kill_ms, assists)
+
+with assists a tuple of (client_id, inflictor_id, damage, share, weapon_arch, last_hit_ms_ago) ordered by
+damage share, the killer included. Entries older then fExpiry seconds are dropped.
+*/
+KILL_LEDGER_POLICY KillLedgerPolicy = { false, 30.0f, 120.0f };
+
+struct KILL_LEDGER_ENTRY
+{
+	uint iClientID; // 0 for npcs
+	float fDamage; // decayed up to tmLastHit
+	mstime tmLastHit;
+	uint iWeaponArch;
+};
+
+struct KILL_LEDGER
+{
+	mstime tmFirstHit;
+	mstime tmLastHit; // hit or munition, for pruning
+	map<uint, KILL_LEDGER_ENTRY> mapInflictors; // by inflictor space id
+	map<uint, uint> mapMunitions; // projectile arch of the last SPMunitionCollision, by inflictor space id
+};
+
+static map<uint, KILL_LEDGER> mapKillLedgers; // by victim space id
+static mstime tmLastPrune;
+
+static float KillLedgerDecay(float fDamage, mstime tmFrom, mstime tmTo)
+{
+	if (KillLedgerPolicy.fHalfLife <= 0 || tmTo <= tmFrom)
+		return fDamage;
+	return fDamage * (float)pow(0.5, (double)(tmTo - tmFrom) / (KillLedgerPolicy.fHalfLife * 1000.0));
+}
+
+void KillLedgerMunition(uint iClientID, const SSPMunitionCollisionInfo &ci)
+{
+	uint iShip = 0;
+	pub::Player::GetShip(iClientID, iShip);
+	if (!iShip || !ci.dwTargetShip || ci.dwTargetShip == iShip)
+		return;
+	KILL_LEDGER &ledger = mapKillLedgers[ci.dwTargetShip];
+	ledger.tmLastHit = timeInMS();
+	ledger.mapMunitions[iShip] = ci.iProjectileArchID;
+}
+
+void KillLedgerDamage(DamageList *dmg, unsigned short iSubObj, float fHealth)
+{
+	if (iSubObj != 1 || !iDmgToSpaceID) // hull only
+		return;
+	uint iInflictor = dmg->get_inflictor_id();
+	if (!iInflictor || iInflictor == iDmgToSpaceID)
+		return;
+
+	float fCurrent, fMax;
+	pub::SpaceObj::GetHealth(iDmgToSpaceID, fCurrent, fMax);
+	float fDamage = fCurrent - fHealth;
+	if (fDamage <= 0)
+		return;
+
+	mstime tmNow = timeInMS();
+	KILL_LEDGER &ledger = mapKillLedgers[iDmgToSpaceID];
+	if (ledger.mapInflictors.empty())
+		ledger.tmFirstHit = tmNow;
+	ledger.tmLastHit = tmNow;
+
+	KILL_LEDGER_ENTRY &entry = ledger.mapInflictors[iInflictor];
+	uint iClientID = dmg->get_inflictor_owner_player();
+	entry.iClientID = iClientID;
+	entry.fDamage = KillLedgerDecay(entry.fDamage, entry.tmLastHit, tmNow) + fDamage;
+	entry.tmLastHit = tmNow;
+	map<uint, uint>::iterator munition = ledger.mapMunitions.find(iInflictor);
+	if (munition != ledger.mapMunitions.end())
+		entry.iWeaponArch = munition->second;
+}
+
+void KillLedgerDestroyed(DamageList *dmg, uint iVictim, uint iVictimClientID, bool bKill)
+{
+	map<uint, KILL_LEDGER>::iterator it = mapKillLedgers.find(iVictim);
+	if (!bKill) { // despawned, docked...
+		if (it != mapKillLedgers.end())
+			mapKillLedgers.erase(it);
+		return;
+	}
+
+	mstime tmNow = timeInMS();
+	mstime tmExpiry = (mstime)(KillLedgerPolicy.fExpiry * 1000.0f);
+	list<KILL_LEDGER_ENTRY> lstAssists;
+	list<uint> lstInflictors;
+	float fTotal = 0;
+	mstime tmFirstHit = tmNow;
+	if (it != mapKillLedgers.end()) {
+		if (!it->second.mapInflictors.empty()) // a munition alone doesnt start the clock
+			tmFirstHit = it->second.tmFirstHit;
+		for (map<uint, KILL_LEDGER_ENTRY>::iterator inf = it->second.mapInflictors.begin(); inf != it->second.mapInflictors.end(); ++inf) {
+			if (tmNow - inf->second.tmLastHit > tmExpiry)
+				continue;
+			KILL_LEDGER_ENTRY entry = inf->second;
+			entry.fDamage = KillLedgerDecay(entry.fDamage, entry.tmLastHit, tmNow);
+			fTotal += entry.fDamage;
+
+			// keep them ordered by damage, theres rarely more then a handful
+			list<KILL_LEDGER_ENTRY>::iterator pos = lstAssists.begin();
+			list<uint>::iterator posID = lstInflictors.begin();
+			while (pos != lstAssists.end() && pos->fDamage >= entry.fDamage) {
+				++pos;
+				++posID;
+			}
+			lstAssists.insert(pos, entry);
+			lstInflictors.insert(posID, inf->first);
+		}
+		mapKillLedgers.erase(it);
+	}
+
+	PyObject *pAssists = PyTuple_New(lstAssists.size());
+	uint i = 0;
+	list<uint>::iterator itID = lstInflictors.begin();
+	for (list<KILL_LEDGER_ENTRY>::iterator as = lstAssists.begin(); as != lstAssists.end(); ++as, ++itID, ++i) {
+		PyTuple_SET_ITEM(pAssists, i, Py_BuildValue("IIffIK",
+			as->iClientID, *itID, as->fDamage, fTotal > 0 ? as->fDamage / fTotal : 0.0f, as->iWeaponArch, tmNow - as->tmLastHit));
+	}
+
+	uint iKillerClientID = dmg ? dmg->get_inflictor_owner_player() : 0;
+	pyCallback("KillReport", Py_BuildValue("IIIKN", iVictim, iVictimClientID, iKillerClientID, tmNow - tmFirstHit, pAssists));
+}
+
+void KillLedgerPrune()
+{
+	mstime tmNow = timeInMS();
+	if (tmNow - tmLastPrune < 10000)
+		return;
+	tmLastPrune = tmNow;
+
+	// victims that never died (healed, despawned without ShipDestroyed...)
+	mstime tmExpiry = (mstime)(KillLedgerPolicy.fExpiry * 1000.0f);
+	for (map<uint, KILL_LEDGER>::iterator it = mapKillLedgers.begin(); it != mapKillLedgers.end(); ) {
+		if (tmNow - it->second.tmLastHit > tmExpiry)
+			it = mapKillLedgers.erase(it);
+		else
+			++it;
+	}
+}
+
+void SetKillLedgerPolicy(const KILL_LEDGER_POLICY &policy)
+{
+	KillLedgerPolicy = policy;
+	if (!KillLedgerPolicy.bEnabled)
+		mapKillLedgers.clear();
+}
@@ -0,0 +1,309 @@
+#include "headers.h"
+#include <map>
+#include <math.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Leak Sentinel - a refcount mistake in the glue code (O vs N in Py_BuildValue...) leaks a few objects per
+event, which on a long running server slowly eats the 32 bit process. When enabled, every iInterval seconds
+(checked at the end of a server tick) we count the live objects tracked by the gc by type, and count the
+events passed to pyCallback since the last sample.
+
+The gc only sees containers, and the usual leak (an int or str built with O instead of N) isn't one, so a few
+more counts are sampled the same way:
+	int, float - the live objects in pythons int and float blocks (what Py{Int,Float}_ClearFreeList return)
+	<address space KB> - the virtual memory the process uses, catches strings and anything else
+	<total refcount> - sys.gettotalrefcount, debug builds of python only
+	<type> (allocs) - live objects per type from sys.getcounts, COUNT_ALLOCS builds of python only
+
+A type that grew in every one of the last iWindow samples is reported together with the events whose call
+counts correlate with that growth (pearson r over the window), ie:
+
+	LeakSentinel: tuple +3120 (r=0.98 HkCbIServerImpl_SPObjUpdate 1.00/call)
+
+Reports go to the console/log and are kept for FLHook.GetLeakReport()
+*/
+LEAK_SENTINEL LeakSentinel = { false, 60, 5, 0 };
+
+#define LEAK_MIN_CORRELATION 0.7
+#define LEAK_MAX_SUSPECTS 3
+
+struct LEAK_TYPE
+{
+	string scName;
+	uint iCount;
+	uint iStreak; // samples in a row this type grew
+	int iHistory[LEAK_MAX_WINDOW]; // growth per sample
+};
+
+struct LEAK_EVENT
+{
+	string scName;
+	uint iCalls; // since the last sample
+	int iHistory[LEAK_MAX_WINDOW]; // calls per sample
+};
+
+static map<PyTypeObject*, LEAK_TYPE> mapLeakTypes;
+static map<string, LEAK_TYPE> mapLeakGauges; // the counts not from the gc, by name
+static map<const char*, LEAK_EVENT> mapLeakEvents;
+static list<LEAK_REPORT> lstLeakReports;
+static uint iSample; // samples taken since enabled
+static DWORD iLastSample;
+static PyObject *pGetObjects; // gc.get_objects
+static PyObject *pGetTotalRefCount; // sys.gettotalrefcount, debug builds only
+static PyObject *pGetCounts; // sys.getcounts, COUNT_ALLOCS builds only
+static Py_ssize_t iLastRefCount;
+
+static double LeakCorrelation(const int *x, const int *y, uint iSize)
+{
+	double dMeanX = 0, dMeanY = 0;
+	for (uint i = 0; i < iSize; i++) {
+		dMeanX += x[i];
+		dMeanY += y[i];
+	}
+	dMeanX /= iSize;
+	dMeanY /= iSize;
+
+	double dCov = 0, dVarX = 0, dVarY = 0;
+	for (uint i = 0; i < iSize; i++) {
+		dCov += (x[i] - dMeanX) * (y[i] - dMeanY);
+		dVarX += (x[i] - dMeanX) * (x[i] - dMeanX);
+		dVarY += (y[i] - dMeanY) * (y[i] - dMeanY);
+	}
+	if (dVarX == 0 || dVarY == 0)
+		return 0; // constant growth or a constant event rate cant be told apart from each other
+	return dCov / sqrt(dVarX * dVarY);
+}
+
+static void LeakReport(LEAK_TYPE &type, uint iWindow)
+{
+	LEAK_REPORT report;
+	report.scType = type.scName;
+	report.iGrowth = 0;
+	for (uint i = 0; i < iWindow; i++)
+		report.iGrowth += type.iHistory[i];
+
+	for (map<const char*, LEAK_EVENT>::iterator it = mapLeakEvents.begin(); it != mapLeakEvents.end(); ++it) {
+		double dR = LeakCorrelation(type.iHistory, it->second.iHistory, iWindow);
+		if (dR < LEAK_MIN_CORRELATION)
+			continue;
+		uint iCalls = 0;
+		for (uint i = 0; i < iWindow; i++)
+			iCalls += it->second.iHistory[i];
+
+		LEAK_SUSPECT suspect = { it->second.scName, dR, iCalls ? (double)report.iGrowth / iCalls : 0 };
+		list<LEAK_SUSPECT>::iterator pos = report.lstSuspects.begin();
+		while (pos != report.lstSuspects.end() && pos->dCorrelation >= dR)
+			++pos;
+		report.lstSuspects.insert(pos, suspect);
+		if (report.lstSuspects.size() > LEAK_MAX_SUSPECTS)
+			report.lstSuspects.pop_back();
+	}
+
+	char szBuf[128];
+	snprintf(szBuf, sizeof(szBuf), "LeakSentinel: %s +%d", report.scType.c_str(), report.iGrowth);
+	string scMsg = szBuf;
+	if (report.lstSuspects.empty())
+		scMsg += " (no correlated events)";
+	for (list<LEAK_SUSPECT>::iterator it = report.lstSuspects.begin(); it != report.lstSuspects.end(); ++it) {
+		snprintf(szBuf, sizeof(szBuf), " (r=%.2f %s %.2f/call)", it->dCorrelation, it->scEvent.c_str(), it->dPerCall);
+		scMsg += szBuf;
+	}
+	ERRMSG(stows(scMsg));
+
+	lstLeakReports.push_back(report);
+	if (lstLeakReports.size() > LEAK_MAX_REPORTS)
+		lstLeakReports.pop_front();
+}
+
+// a new sample of a types count, reported once it grew in each of the last iWindow samples
+static void LeakGrowth(LEAK_TYPE &type, uint iCount, uint iSlot, uint iWindow)
+{
+	int iGrowth = (int)iCount - (int)type.iCount;
+	type.iHistory[iSlot] = iGrowth;
+	type.iStreak = iGrowth > 0 ? type.iStreak + 1 : 0;
+	type.iCount = iCount;
+	if (type.iStreak >= iWindow) {
+		LeakReport(type, iWindow);
+		type.iStreak = 0; // report again after another full window of growth
+	}
+}
+
+static void LeakNewType(LEAK_TYPE &type, const string &scName, uint iCount)
+{
+	type.scName = scName;
+	type.iCount = iCount;
+	type.iStreak = 0;
+	memset(type.iHistory, 0, sizeof(type.iHistory));
+}
+
+static void LeakGauge(const string &scName, uint iCount, uint iSlot, uint iWindow)
+{
+	map<string, LEAK_TYPE>::iterator it = mapLeakGauges.find(scName);
+	if (it == mapLeakGauges.end()) // growth counts from the next sample
+		LeakNewType(mapLeakGauges[scName], scName, iCount);
+	else
+		LeakGrowth(it->second, iCount, iSlot, iWindow);
+}
+
+// the counts the gc can't see
+static void LeakSampleGauges(uint iSlot, uint iWindow)
+{
+	// both walk their blocks counting the live objects, and free the blocks left empty (gc.collect() does too)
+	LeakGauge("int", (uint)PyInt_ClearFreeList(), iSlot, iWindow);
+	LeakGauge("float", (uint)PyFloat_ClearFreeList(), iSlot, iWindow);
+
+	MEMORYSTATUSEX status;
+	status.dwLength = sizeof(status);
+	if (GlobalMemoryStatusEx(&status))
+		LeakGauge("<address space KB>", (uint)((status.ullTotalVirtual - status.ullAvailVirtual) / 1024), iSlot, iWindow);
+
+	if (pGetTotalRefCount) {
+		PyObject *pRefs = PyObject_CallObject(pGetTotalRefCount, NULL);
+		if (pRefs) {
+			Py_ssize_t iRefs = PyInt_AsSsize_t(pRefs);
+			Py_DECREF(pRefs);
+			LeakSentinel.iRefGrowth = iSample > 0 ? iRefs - iLastRefCount : 0;
+			iLastRefCount = iRefs;
+			LeakGauge("<total refcount>", (uint)iRefs, iSlot, iWindow);
+		}
+		CheckPyException();
+	}
+
+	if (pGetCounts) { // [(type name, allocs, frees, max alloced)]
+		PyObject *pCounts = PyObject_CallObject(pGetCounts, NULL);
+		if (pCounts && PyList_Check(pCounts)) {
+			for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pCounts); i++) {
+				const char *szType;
+				Py_ssize_t iAllocs, iFrees, iMax;
+				if (PyArg_ParseTuple(PyList_GET_ITEM(pCounts, i), "snnn", &szType, &iAllocs, &iFrees, &iMax))
+					LeakGauge(string(szType) + " (allocs)", (uint)(iAllocs - iFrees), iSlot, iWindow);
+			}
+		}
+		Py_XDECREF(pCounts);
+		CheckPyException();
+	}
+}
+
+static void LeakSample()
+{
+	PyObject *pObjects = PyObject_CallObject(pGetObjects, NULL);
+	if (pObjects == NULL || !PyList_Check(pObjects)) {
+		Py_XDECREF(pObjects);
+		CheckPyException();
+		return;
+	}
+
+	// count the live objects per type
+	map<PyTypeObject*, uint> mapCounts;
+	Py_ssize_t iSize = PyList_GET_SIZE(pObjects);
+	for (Py_ssize_t i = 0; i < iSize; i++)
+		mapCounts[Py_TYPE(PyList_GET_ITEM(pObjects, i))]++;
+	Py_DECREF(pObjects);
+
+	uint iWindow = LeakSentinel.iWindow;
+	uint iSlot = iSample % iWindow;
+	for (map<const char*, LEAK_EVENT>::iterator it = mapLeakEvents.begin(); it != mapLeakEvents.end(); ++it) {
+		it->second.iHistory[iSlot] = (int)it->second.iCalls;
+		it->second.iCalls = 0;
+	}
+
+	// forget types without instances left (the type itself may be gone)
+	for (map<PyTypeObject*, LEAK_TYPE>::iterator it = mapLeakTypes.begin(); it != mapLeakTypes.end(); ) {
+		if (mapCounts.find(it->first) == mapCounts.end())
+			it = mapLeakTypes.erase(it);
+		else
+			++it;
+	}
+
+	for (map<PyTypeObject*, uint>::iterator it = mapCounts.begin(); it != mapCounts.end(); ++it) {
+		map<PyTypeObject*, LEAK_TYPE>::iterator known = mapLeakTypes.find(it->first);
+		if (known == mapLeakTypes.end()) // new type, growth counts from the next sample
+			LeakNewType(mapLeakTypes[it->first], it->first->tp_name, it->second);
+		else
+			LeakGrowth(known->second, it->second, iSlot, iWindow);
+	}
+	LeakSampleGauges(iSlot, iWindow);
+	iSample++;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool SetLeakSentinel(bool bEnabled, uint iInterval, uint iWindow)
+{
+	if (iWindow < 2 || iWindow > LEAK_MAX_WINDOW || iInterval == 0)
+		return false;
+
+	if (bEnabled && pGetObjects == NULL) {
+		PyObject *pGC = PyImport_ImportModule("gc");
+		if (pGC) {
+			pGetObjects = PyObject_GetAttrString(pGC, "get_objects");
+			Py_DECREF(pGC);
+		}
+		PyObject *pSys = PyImport_ImportModule("sys");
+		if (pSys) {
+			if (PyObject_HasAttrString(pSys, "gettotalrefcount"))
+				pGetTotalRefCount = PyObject_GetAttrString(pSys, "gettotalrefcount");
+			if (PyObject_HasAttrString(pSys, "getcounts"))
+				pGetCounts = PyObject_GetAttrString(pSys, "getcounts");
+			Py_DECREF(pSys);
+		}
+		if (CheckPyException() || pGetObjects == NULL) {
+			ERRMSG(L"ERROR LeakSentinel couldnt read gc.get_objects");
+			return false;
+		}
+	}
+
+	LeakSentinel.bEnabled = bEnabled;
+	LeakSentinel.iInterval = iInterval;
+	LeakSentinel.iWindow = iWindow;
+	LeakSentinel.iRefGrowth = 0;
+	mapLeakTypes.clear();
+	mapLeakGauges.clear();
+	mapLeakEvents.clear();
+	iSample = 0;
+	iLastSample = GetTickCount();
+	return true;
+}
+
+void StopLeakSentinel()
+{
+	LeakSentinel.bEnabled = false;
+	mapLeakTypes.clear();
+	mapLeakGauges.clear();
+	mapLeakEvents.clear();
+	lstLeakReports.clear();
+	Py_XDECREF(pGetObjects);
+	Py_XDECREF(pGetTotalRefCount);
+	Py_XDECREF(pGetCounts);
+	pGetObjects = pGetTotalRefCount = pGetCounts = NULL;
+}
+
+void LeakCountEvent(const char *szEvent)
+{
+	map<const char*, LEAK_EVENT>::iterator it = mapLeakEvents.find(szEvent);
+	if (it == mapLeakEvents.end()) {
+		LEAK_EVENT &event = mapLeakEvents[szEvent];
+		event.scName = szEvent;
+		event.iCalls = 1;
+		memset(event.iHistory, 0, sizeof(event.iHistory));
+		return;
+	}
+	it->second.iCalls++;
+}
+
+void LeakTick()
+{
+	if (!LeakSentinel.bEnabled)
+		return;
+	DWORD iNow = GetTickCount();
+	if (iNow - iLastSample < LeakSentinel.iInterval * 1000)
+		return;
+	iLastSample = iNow;
+	LeakSample();
+}
+
+list<LEAK_REPORT>& GetLeakReports()
+{
+	return lstLeakReports;
+}
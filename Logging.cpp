@@ -0,0 +1,235 @@
+#include "headers.h"
+#include <map>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Logging - ERRMSG and FLHook.Log() don't write to the console and FLHook log themselves, they put the line in a
+ring buffer and a background thread does the writing. Only the game thread writes to the ring and only the
+log thread reads it, so it needs no lock, just the two indexes published with Interlocked calls. When the
+ring is full lines are dropped (and counted) rather than making the game thread wait.
+
+Lines are deduplicated by their text (for a python error that's the event, exception type and message),
+looked up by a hash and compared in full, so two lines sharing a hash are both logged: the first one in
+LOG_DEDUP_WINDOW is logged, the rest are only counted and logged as one "N repeats suppressed"
+line when the window ends. A handler for SPObjUpdate that throws every call is one line every few seconds,
+not thousands.
+
+Multi line entries (tracebacks) go through LogWriteLines instead: one ring slot per line, lines longer then a
+slot continued in the next, and no dedup (Tracebacks.cpp already limits how many it logs).
+
+Warnings and errors also go to the console, everything goes to the FLHook log with its level.
+*/
+LOG_STATS LogStats;
+
+#define LOG_RING_SIZE 1024 // lines, power of 2
+#define LOG_TEXT_MAX 512 // characters per line
+#define LOG_DEDUP_WINDOW 5000 // ms
+#define LOG_DEDUP_MAX 256 // fingerprints kept
+
+struct LOG_SLOT
+{
+	LOG_LEVEL level;
+	wchar_t wszText[LOG_TEXT_MAX];
+};
+
+struct LOG_DEDUP
+{
+	mstime tmWindowStart;
+	uint iSuppressed;
+	LOG_LEVEL level;
+	wstring wscText;
+};
+
+static LOG_SLOT LogRing[LOG_RING_SIZE];
+static volatile LONG iLogHead = 0; // next slot written, only the game thread changes it
+static volatile LONG iLogTail = 0; // next slot read, only the log thread changes it
+static volatile LONG iLogDropped = 0;
+static HANDLE hLogThread = NULL;
+static HANDLE hLogEvent = NULL;
+static volatile LONG bLogStop = 0;
+static LOG_LEVEL LogMinLevel = LOG_INFO;
+static map<uint, LOG_DEDUP> mapLogDedup;
+static mstime tmLastDedupCheck;
+
+static const char *LogLevelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static uint LogFingerprint(const wstring &wscText)
+{
+	uint iHash = 2166136261u;
+	for (uint i = 0; i < wscText.length(); i++)
+		iHash = (iHash ^ wscText[i]) * 16777619u;
+	return iHash;
+}
+
+static void LogOutput(LOG_LEVEL level, const wchar_t *wszText)
+{
+	if (level >= LOG_WARN)
+		ConPrint(wstring(wszText) + L"\n");
+	AddLog("%s: %s", LogLevelNames[level], wstos(wszText).c_str());
+}
+
+// empties the ring, on the log thread or (with no log thread) the game thread
+static void LogDrain()
+{
+	LONG iDropped = InterlockedExchange(&iLogDropped, 0);
+	if (iDropped) {
+		wchar_t wszDropped[64];
+		swprintf(wszDropped, 64, L"%d log lines dropped, the log buffer was full", iDropped);
+		LogOutput(LOG_WARN, wszDropped);
+	}
+	LONG iTail = iLogTail;
+	while (iTail != InterlockedCompareExchange(&iLogHead, 0, 0)) {
+		const LOG_SLOT &slot = LogRing[iTail & (LOG_RING_SIZE - 1)];
+		LogOutput(slot.level, slot.wszText);
+		iTail++;
+		InterlockedExchange(&iLogTail, iTail); // the slot can be reused now
+	}
+}
+
+static DWORD WINAPI LogThread(LPVOID lpParam)
+{
+	while (!InterlockedCompareExchange(&bLogStop, 0, 0)) {
+		WaitForSingleObject(hLogEvent, 1000);
+		LogDrain();
+	}
+	LogDrain();
+	return 0;
+}
+
+static void LogPush(LOG_LEVEL level, const wstring &wscText)
+{
+	if (!hLogThread) { // not started or already stopped
+		LogOutput(level, wscText.c_str());
+		return;
+	}
+	LONG iHead = iLogHead;
+	if (iHead - InterlockedCompareExchange(&iLogTail, 0, 0) >= LOG_RING_SIZE) {
+		InterlockedIncrement(&iLogDropped);
+		LogStats.iDropped++;
+		return;
+	}
+	LOG_SLOT &slot = LogRing[iHead & (LOG_RING_SIZE - 1)];
+	slot.level = level;
+	size_t iLength = min(wscText.length(), (size_t)LOG_TEXT_MAX - 1);
+	wscText.copy(slot.wszText, iLength);
+	slot.wszText[iLength] = 0;
+	InterlockedExchange(&iLogHead, iHead + 1); // publishes the slot
+	SetEvent(hLogEvent);
+}
+
+static void LogSuppressed(const LOG_DEDUP &dedup)
+{
+	wchar_t wszCount[64];
+	swprintf(wszCount, 64, L" (%u repeats suppressed)", dedup.iSuppressed);
+	LogPush(dedup.level, dedup.wscText + wszCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StartLogging()
+{
+	if (hLogThread)
+		return;
+	hLogEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	InterlockedExchange(&bLogStop, 0);
+	hLogThread = CreateThread(NULL, 0, LogThread, NULL, 0, NULL);
+}
+
+// waits (a while) for the log thread to write everything, anything it left is written here once it has exited
+void StopLogging()
+{
+	if (!hLogThread)
+		return;
+	for (map<uint, LOG_DEDUP>::iterator it = mapLogDedup.begin(); it != mapLogDedup.end(); ++it) {
+		if (it->second.iSuppressed)
+			LogSuppressed(it->second);
+	}
+	mapLogDedup.clear();
+	InterlockedExchange(&bLogStop, 1);
+	SetEvent(hLogEvent);
+	if (WaitForSingleObject(hLogThread, 2000) != WAIT_OBJECT_0) {
+		// under the loader lock (DLL detach) the thread can't exit, so don't wait forever. It still owns the ring and
+		// hLogEvent then: leave them to it (draining here too would write lines twice)
+		LogOutput(LOG_WARN, L"log thread did not stop, leaving it running");
+		return;
+	}
+	CloseHandle(hLogThread);
+	CloseHandle(hLogEvent);
+	hLogThread = NULL;
+	LogDrain();
+}
+
+void LogWrite(LOG_LEVEL level, const wstring &wscText)
+{
+	if (level < LogMinLevel)
+		return;
+	LogStats.iLines++;
+	mstime tmNow = timeInMS();
+	uint iFingerprint = LogFingerprint(wscText);
+	map<uint, LOG_DEDUP>::iterator it = mapLogDedup.find(iFingerprint);
+	if (it != mapLogDedup.end() && it->second.wscText == wscText) {
+		LOG_DEDUP &dedup = it->second;
+		if (tmNow - dedup.tmWindowStart < LOG_DEDUP_WINDOW) {
+			dedup.iSuppressed++;
+			LogStats.iSuppressed++;
+			return;
+		}
+		if (dedup.iSuppressed)
+			LogSuppressed(dedup);
+		dedup.tmWindowStart = tmNow;
+		dedup.iSuppressed = 0;
+	}
+	else if (it == mapLogDedup.end() && mapLogDedup.size() < LOG_DEDUP_MAX) { // a different line with the same hash isnt deduplicated
+		LOG_DEDUP &dedup = mapLogDedup[iFingerprint];
+		dedup.tmWindowStart = tmNow;
+		dedup.iSuppressed = 0;
+		dedup.level = level;
+		dedup.wscText = wscText;
+	}
+	LogPush(level, wscText);
+}
+
+// a multi line entry, every line logged in full and not deduplicated
+void LogWriteLines(LOG_LEVEL level, const wstring &wscText)
+{
+	if (level < LogMinLevel)
+		return;
+	size_t iStart = 0;
+	while (iStart < wscText.length()) {
+		size_t iEnd = wscText.find(L'\n', iStart);
+		if (iEnd == wstring::npos)
+			iEnd = wscText.length();
+		do { // a line longer then a slot is continued in the next one
+			size_t iLength = min(iEnd - iStart, (size_t)LOG_TEXT_MAX - 1);
+			LogStats.iLines++;
+			LogPush(level, wscText.substr(iStart, iLength));
+			iStart += iLength;
+		} while (iStart < iEnd);
+		iStart = iEnd + 1;
+	}
+}
+
+// logs the suppressed counts of windows that ended and forgets quiet fingerprints, from HkCb_Update_Time_AFTER
+void LogTick()
+{
+	if (mapLogDedup.empty())
+		return;
+	mstime tmNow = timeInMS();
+	if (tmNow - tmLastDedupCheck < 1000)
+		return;
+	tmLastDedupCheck = tmNow;
+	for (map<uint, LOG_DEDUP>::iterator it = mapLogDedup.begin(); it != mapLogDedup.end(); ) {
+		if (tmNow - it->second.tmWindowStart < LOG_DEDUP_WINDOW) {
+			++it;
+			continue;
+		}
+		if (it->second.iSuppressed)
+			LogSuppressed(it->second);
+		mapLogDedup.erase(it++);
+	}
+}
+
+void SetLogLevel(LOG_LEVEL level)
+{
+	LogMinLevel = level;
+}
@@ -53,8 +53,16 @@ bool RaisePyException(HK_ERROR hkErr)
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*
-CheckPyException - Checks if a exception was raised in python and logs it
+CheckPyException - Checks if a exception was raised in python and logs it. The exception (traceback included)
+	goes to Tracebacks.cpp, which keeps the first few of each
 */
+static const char *szPyEvent = NULL; // the event pyCallback is in, for the traceback fingerprint
+
+const char* pyCurrentEvent()
+{
+	return szPyEvent;
+}
+
 bool CheckPyException()
 {
 	if (PyErr_Occurred() == NULL)
@@ -62,10 +70,9 @@ bool CheckPyException()
 	
 	PyObject *pType, *pValue, *pTraceback;
 	PyErr_Fetch(&pType, &pValue, &pTraceback);
-	ERRMSG(pytows(pType) + L": "  + pytows(pValue));
-	Py_XDECREF(pType);
-	Py_XDECREF(pValue);
-	Py_XDECREF(pTraceback);
+	wstring wscError = pytows(pType) + L": "  + pytows(pValue);
+	ERRMSG(szPyEvent ? L"(" + stows(szPyEvent) + L") " + wscError : wscError); // the event keeps errors of different handlers apart
+	TracebackRecord(szPyEvent, wscError, pType, pValue, pTraceback);
 	return true;
 }
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -99,6 +106,7 @@ StartPython - Initializes python, sets our module paths and calls freelancer.emb
 void StartPython()
 {
 	ConPrint(L"Starting Python....\n");
+	StartLogging();
 	Py_Initialize();
 	g_bEnabled = true;
 	
@@ -109,6 +117,7 @@ void StartPython()
 		"sys.path.append('./flhook_plugins/python')\n"
 		//"sys.path.append('C:/Development/PyFL/lib')\n" /// Fenris's Dev directory
 	);
+	StartGC();
 
 	// load the python module
 	PyObject *pName;
@@ -145,6 +154,14 @@ void StopPython()
 	catch (...) {
 		AddLog("Error Closing Python!");
 	}
+	StopGC();
+	StopLeakSentinel();
+	ClearNativeHandlers();
+	ClearHookPairs();
+	ClearMarshalCache();
+	StopStores();
+	IniCacheClear();
+	TracebackClear();
 	Py_XDECREF(pException);
 	Py_XDECREF(pCallback);
 	Py_XDECREF(pConstConverter);
@@ -152,15 +169,17 @@ void StopPython()
 	Py_XDECREF(pModule);
 	Py_XDECREF(pModule);
 	Py_Finalize();
+	StopLogging();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*
 pyCallback - calls the python freelancer.embedded._callback function
 */
-void pyCallback(string scEvent, PyObject *pData)
+void pyCallback(const char *szEvent, PyObject *pData)
 {
-	PyObject *pResult;
+	static PY_ARGS args; // our (event, data) tuple, reused between calls
+	PyObject *pResult = NULL;
 	if (pModule == NULL) {
 		// somehow we lost python...something crashed
 		CheckPyException();
@@ -173,25 +192,33 @@ void pyCallback(string scEvent, PyObject *pData)
 
 	if (pData == NULL) { // input data must have errored
 		CheckPyException();
-		ERRMSG(L"ERROR (" + stows(scEvent) + L") got NULL data");
+		ERRMSG(L"ERROR (" + stows(szEvent) + L") got NULL data");
 		Py_XDECREF(pData);
 		return;
 	}
+	if (LeakSentinel.bEnabled)
+		LeakCountEvent(szEvent);
 
+	const char *szOuterEvent = szPyEvent; // python can cause events of its own
 	try {
 		// make the actual python call
-		PyObject *pArgs = Py_BuildValue("sN", scEvent.c_str(), pData);
+		szPyEvent = szEvent;
+		PyObject *pArgs = pyTuple(args, pyString(szEvent), pData);
 		pResult = PyObject_CallObject(pCallback, pArgs);
 		Py_XDECREF(pArgs);
-		if (CheckPyException()) {
-			ERRMSG(L"ERROR (" + stows(scEvent) + L") Returned NULL");
+		pyTupleRelease(args); // lets go of pData, so the hook's own tuple can be reused next call
+		bool bError = CheckPyException();
+		szPyEvent = szOuterEvent;
+		if (bError) {
+			ERRMSG(L"ERROR (" + stows(szEvent) + L") Returned NULL");
 		}
 		else {
 			iResult = (uint)PyInt_AsLong(pResult);
 		}
 	}
 	catch (...) { 
-		string msg = "Exception in pyCallback (" + scEvent +")";
+		szPyEvent = szOuterEvent;
+		string msg = "Exception in pyCallback (" + string(szEvent) +")";
 		AddLog(msg.c_str());
 	}
 	Py_XDECREF(pResult);
@@ -205,6 +232,178 @@ void pyCallback(string scEvent, PyObject *pData)
 	return;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Hook pairs - most hooks come as a BEFORE/AFTER pair called with the exact same arguments. Rather then running
+Py_BuildValue and the ToPython converters twice, the BEFORE hook keeps its (immutable) argument tuple along
+with a raw copy of the hook arguments. The AFTER hook reuses that tuple if its own arguments still match,
+otherwise it rebuilds them. Arguments that point to data are keyed on what they point to (a hash of the chat
+buffer, the converted fields of a struct), not the pointer, so a BEFORE handler changing the data is seen.
+BEFORE hooks that can return before pyCallbackBefore drop the slot first with pyPairDrop.
+
+A script can also ask for a hook pair to be 'fused' with FLHook.SetFusedHook(). The BEFORE call is then
+skipped, and the AFTER hook sends a single '<event>_FUSED' callback with (before_data, after_data). When
+nothing changed in between both are the same object. Note a fused hook can not block the BEFORE call.
+*/
+struct HOOK_PAIR_SLOT
+{
+	PyObject *pArgs;
+	HOOK_KEY key;
+	bool bFused;
+	string scFusedEvent;
+	bool bMuted; // this call isnt sent to python, decided by the BEFORE hook (see SetSequenceTracking)
+};
+static HOOK_PAIR_SLOT HookPairs[HKP_COUNT];
+
+// must match the order of the HOOK_PAIR enum, names are the BEFORE event names
+static const char *HookPairNames[HKP_COUNT] = {
+	"HkCbIServerImpl_SubmitChat",
+	"HkCbIServerImpl_PlayerLaunch",
+	"HkCbIServerImpl_FireWeapon",
+	"HkCbIServerImpl_SPMunitionCollision",
+	"HkCbIServerImpl_SPObjUpdate",
+	"HkCbIServerImpl_SPObjCollision",
+	"HkCbIServerImpl_LaunchComplete",
+	"HkCbIServerImpl_BaseEnter",
+	"HkCbIServerImpl_BaseExit",
+	"HkCbIServerImpl_OnConnect",
+	"HkCbIServerImpl_DisConnect",
+	"HkCbIServerImpl_TerminateTrade",
+	"HkCbIServerImpl_InitiateTrade",
+	"HkCbIServerImpl_ActivateEquip",
+	"HkCbIServerImpl_ActivateCruise",
+	"HkCbIServerImpl_ActivateThrusters",
+	"HkCbIServerImpl_GFGoodSell",
+	"HkCbIServerImpl_CharacterInfoReq",
+	"HkCbIServerImpl_JumpInComplete",
+	"HkCbIServerImpl_SystemSwitchOutComplete",
+	"HkCbIServerImpl_MineAsteroid",
+	"HkCbIServerImpl_GoTradelane",
+	"HkCbIServerImpl_AbortMission",
+	"HkCbIServerImpl_AcceptTrade",
+	"HkCbIServerImpl_AddTradeEquip",
+	"HkCbIServerImpl_BaseInfoRequest",
+	"HkCbIServerImpl_DelTradeEquip",
+	"HkCbIServerImpl_GFGoodBuy",
+	"HkCbIServerImpl_GFObjSelect",
+	"HkCbIServerImpl_Hail",
+	"HkCbIServerImpl_InterfaceItemUsed",
+	"HkCbIServerImpl_JettisonCargo",
+	"HkCbIServerImpl_LocationEnter",
+	"HkCbIServerImpl_LocationExit",
+	"HkCbIServerImpl_LocationInfoRequest",
+	"HkCbIServerImpl_MissionResponse",
+	"HkCbIServerImpl_ReqChangeCash",
+	"HkCbIServerImpl_ReqHullStatus",
+	"HkCbIServerImpl_ReqRemoveItem",
+	"HkCbIServerImpl_ReqSetCash",
+	"HkCbIServerImpl_ReqShipArch",
+	"HkCbIServerImpl_RequestCancel",
+	"HkCbIServerImpl_RequestCreateShip",
+	"HkCbIServerImpl_RequestEvent",
+	"HkCbIServerImpl_RequestTrade",
+	"HkCbIServerImpl_SPRequestInvincibility",
+	"HkCbIServerImpl_SPScanCargo",
+	"HkCbIServerImpl_SetManeuver",
+	"HkCbIServerImpl_SetTarget",
+	"HkCbIServerImpl_SetTradeMoney",
+	"HkCbIServerImpl_StopTradeRequest",
+	"HkCb_AddDmgEntry"
+};
+
+void pyCallbackBefore(HOOK_PAIR hkPair, const char *szEvent, const HOOK_KEY &key, PyObject *pData, bool bMuted)
+{
+	HOOK_PAIR_SLOT &slot = HookPairs[hkPair];
+	Py_XDECREF(slot.pArgs);
+	slot.pArgs = NULL;
+	slot.bMuted = bMuted;
+	if (pData != NULL && key.iSize != HOOK_KEY_INVALID) {
+		Py_INCREF(pData); // our slot keeps its own reference
+		slot.pArgs = pData;
+		slot.key = key;
+	}
+
+	if (slot.bFused || slot.bMuted) {
+		Py_XDECREF(pData);
+		return;
+	}
+	pyCallback(szEvent, pData);
+}
+
+PyObject* pyPairArgs(HOOK_PAIR hkPair, const HOOK_KEY &key)
+{
+	HOOK_PAIR_SLOT &slot = HookPairs[hkPair];
+	if (slot.pArgs == NULL || key.iSize == HOOK_KEY_INVALID || key.iSize != slot.key.iSize)
+		return NULL;
+	if (memcmp(key.data, slot.key.data, key.iSize) != 0)
+		return NULL; // changed since the BEFORE hook, caller has to rebuild
+	Py_INCREF(slot.pArgs);
+	return slot.pArgs;
+}
+
+// forgets the slot, for BEFORE hooks that can return before pyCallbackBefore: the AFTER hook mustn't match
+// the arguments kept by an earlier call
+void pyPairDrop(HOOK_PAIR hkPair)
+{
+	HOOK_PAIR_SLOT &slot = HookPairs[hkPair];
+	Py_XDECREF(slot.pArgs);
+	slot.pArgs = NULL;
+	slot.bMuted = false;
+}
+
+void pyCallbackAfter(HOOK_PAIR hkPair, const char *szEvent, PyObject *pData)
+{
+	HOOK_PAIR_SLOT &slot = HookPairs[hkPair];
+	PyObject *pBefore = slot.pArgs; // we take over the slots reference
+	slot.pArgs = NULL;
+	bool bMuted = slot.bMuted;
+	slot.bMuted = false;
+
+	if (bMuted) {
+		Py_XDECREF(pBefore);
+		Py_XDECREF(pData);
+		return;
+	}
+
+	if (!slot.bFused) {
+		Py_XDECREF(pBefore);
+		pyCallback(szEvent, pData);
+		return;
+	}
+	if (pData == NULL) {
+		Py_XDECREF(pBefore);
+		pyCallback(szEvent, pData); // logs the error for us
+		return;
+	}
+	if (pBefore == NULL) { // BEFORE hook didnt run (or had bad data)
+		Py_INCREF(Py_None);
+		pBefore = Py_None;
+	}
+	pyCallback(slot.scFusedEvent.c_str(), Py_BuildValue("NN", pBefore, pData));
+}
+
+bool SetFusedHook(const string &scEvent, bool bFused)
+{
+	for (uint i = 0; i < HKP_COUNT; i++) {
+		if (scEvent == HookPairNames[i]) {
+			HookPairs[i].bFused = bFused;
+			HookPairs[i].scFusedEvent = scEvent + "_FUSED";
+			return true;
+		}
+	}
+	return false;
+}
+
+void ClearHookPairs()
+{
+	for (uint i = 0; i < HKP_COUNT; i++) {
+		Py_XDECREF(HookPairs[i].pArgs);
+		HookPairs[i].pArgs = NULL;
+		HookPairs[i].bFused = false;
+		HookPairs[i].bMuted = false;
+	}
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -241,271 +440,409 @@ namespace HkIServerImpl
 	EXPORT void __stdcall SubmitChat(struct CHAT_ID cId, unsigned long lP1, void const *rdlReader, struct CHAT_ID cIdTo, int iP2)
 	{
 		DEFAULT_CHECK();
+		pyPairDrop(HKP_SubmitChat);
+		ADMISSION_CHECK(cId.iID);
 		// Group join/leave commands
 		if (cIdTo.iID == 0x10004)
 		{
 			return;
 		}
 
+		RATE_CHECK(RLE_SubmitChat, cId.iID);
+
 		// extract text from rdlReader
 		BinaryRDLReader rdl;
 		wchar_t wszBuf[1024] = L"";
 		uint iRet1;
 		rdl.extract_text_from_buffer((unsigned short*)wszBuf, sizeof(wszBuf), iRet1, (const char*)rdlReader, lP1);
+		if (!ChatFilterApply(cId.iID, wszBuf, rdlReader, lP1))
+			return;
 		wstring wscBuf = wszBuf;
 		uint iClientID = cId.iID;
 
-		pyCallback("HkCbIServerImpl_SubmitChat", Py_BuildValue("INIi", cId.iID, ToPython(wscBuf), cIdTo.iID, iP2));
+		pyCallbackBefore(HKP_SubmitChat, "HkCbIServerImpl_SubmitChat", HookKey(cId, lP1, HookKeyHash(rdlReader, lP1), cIdTo, iP2),
+			Py_BuildValue("INIi", cId.iID, ToPython(wscBuf), cIdTo.iID, iP2));
 	}
 	EXPORT void __stdcall SubmitChat_AFTER(struct CHAT_ID cId, unsigned long lP1, void const *rdlReader, struct CHAT_ID cIdTo, int iP2)
 	{
 		DEFAULT_CHECK();
+		ADMISSION_CHECK(cId.iID);
 
 		// Group join/leave commands
 		if (cIdTo.iID == 0x10004)
 		{
 			return;
 		}
+		RATE_CHECK_AFTER(RLE_SubmitChat, cId.iID);
+		if (ChatFilterBlocked(cId.iID))
+			return;
 
-		// extract text from rdlReader
-		BinaryRDLReader rdl;
-		wchar_t wszBuf[1024] = L"";
-		uint iRet1;
-		rdl.extract_text_from_buffer((unsigned short*)wszBuf, sizeof(wszBuf), iRet1, (const char*)rdlReader, lP1);
-		wstring wscBuf = wszBuf;
-		uint iClientID = cId.iID;
-
-		pyCallback("HkCbIServerImpl_SubmitChat", Py_BuildValue("INIi", cId.iID, ToPython(wscBuf), cIdTo.iID, iP2));
+		// same text as the BEFORE hook? then it's already converted
+		PyObject *pData = pyPairArgs(HKP_SubmitChat, HookKey(cId, lP1, HookKeyHash(rdlReader, lP1), cIdTo, iP2));
+		if (pData == NULL) {
+			// extract text from rdlReader
+			BinaryRDLReader rdl;
+			wchar_t wszBuf[1024] = L"";
+			uint iRet1;
+			rdl.extract_text_from_buffer((unsigned short*)wszBuf, sizeof(wszBuf), iRet1, (const char*)rdlReader, lP1);
+			wstring wscBuf = wszBuf;
+			pData = Py_BuildValue("INIi", cId.iID, ToPython(wscBuf), cIdTo.iID, iP2);
+		}
+		pyCallbackAfter(HKP_SubmitChat, "HkCbIServerImpl_SubmitChat", pData); // the AFTER callback has always had the BEFORE name, scripts rely on it
+		RATE_CLEAR(RLE_SubmitChat, cId.iID);
 	}
 	EXPORT void __stdcall PlayerLaunch(unsigned int iShip, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_PlayerLaunch", Py_BuildValue("II", iShip, iClientID));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_PlayerLaunch, "HkCbIServerImpl_PlayerLaunch", HookKey(iShip, iClientID), pyTuple(args, pyID(iShip), pyID(iClientID)), SequenceMutedLaunch(iClientID, iShip));
 	}
 	EXPORT void __stdcall PlayerLaunch_AFTER(unsigned int iShip, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_PlayerLaunch_AFTER", Py_BuildValue("II", iShip, iClientID));
+		if (bSequenceTracking)
+			SequencePlayerLaunch(iShip, iClientID);
+		ShipRegistrySetOwner(iShip, iClientID);
+		if (bChangeFeed) {
+			uint iSystem = 0;
+			pub::Player::GetSystem(iClientID, iSystem);
+			ChangeFeedSet(iClientID, CHG_SYSTEM, iSystem);
+			ChangeFeedSet(iClientID, CHG_SHIP, iShip);
+			ChangeFeedDirty(iClientID, CHG_CASH);
+		}
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_PlayerLaunch, HookKey(iShip, iClientID));
+		pyCallbackAfter(HKP_PlayerLaunch, "HkCbIServerImpl_PlayerLaunch_AFTER", pData ? pData : pyTuple(args, pyID(iShip), pyID(iClientID)));
 	}
 	EXPORT void __stdcall FireWeapon(unsigned int iClientID, struct XFireWeaponInfo const &wpn)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_FireWeapon", Py_BuildValue("IN", iClientID, ToPython(wpn)));
+		pyPairDrop(HKP_FireWeapon);
+		NATIVE_CHECK(FNE_FireWeapon, iClientID, &wpn);
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_FireWeapon, "HkCbIServerImpl_FireWeapon", HookKey(iClientID, wpn.iDunno1, wpn.vDirection, wpn.iDunno2, wpn.sArray1, wpn.sArray2, wpn.s3), pyTuple(args, pyID(iClientID), ToPython(wpn)));
 	}
 	EXPORT void __stdcall FireWeapon_AFTER(unsigned int iClientID, struct XFireWeaponInfo const &wpn)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_FireWeapon_AFTER", Py_BuildValue("IN", iClientID, ToPython(wpn)));
+		NATIVE_CHECK(FNE_FireWeapon_AFTER, iClientID, &wpn);
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_FireWeapon, HookKey(iClientID, wpn.iDunno1, wpn.vDirection, wpn.iDunno2, wpn.sArray1, wpn.sArray2, wpn.s3));
+		pyCallbackAfter(HKP_FireWeapon, "HkCbIServerImpl_FireWeapon_AFTER", pData ? pData : pyTuple(args, pyID(iClientID), ToPython(wpn)));
 	}
 	EXPORT void __stdcall SPMunitionCollision(struct SSPMunitionCollisionInfo const & ci, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPMunitionCollision", Py_BuildValue("NI", ToPython(ci), iClientID));
+		if (KillLedgerPolicy.bEnabled)
+			KillLedgerMunition(iClientID, ci);
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_SPMunitionCollision, "HkCbIServerImpl_SPMunitionCollision", HookKey(ci, iClientID), pyTuple(args, ToPython(ci), pyID(iClientID)));
 	}
 	EXPORT void __stdcall SPMunitionCollision_AFTER(struct SSPMunitionCollisionInfo const & ci, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPMunitionCollision_AFTER", Py_BuildValue("NI", ToPython(ci), iClientID));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_SPMunitionCollision, HookKey(ci, iClientID));
+		pyCallbackAfter(HKP_SPMunitionCollision, "HkCbIServerImpl_SPMunitionCollision_AFTER", pData ? pData : pyTuple(args, ToPython(ci), pyID(iClientID)));
 	}
 	EXPORT void __stdcall SPObjUpdate(struct SSPObjUpdateInfo const &ui, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPObjUpdate", Py_BuildValue("NI", ToPython(ui), iClientID));
+		pyPairDrop(HKP_SPObjUpdate);
+		NATIVE_CHECK(FNE_SPObjUpdate, iClientID, &ui);
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_SPObjUpdate, "HkCbIServerImpl_SPObjUpdate", HookKey(ui, iClientID), pyTuple(args, ToPython(ui), pyID(iClientID)));
 	}
 	EXPORT void __stdcall SPObjUpdate_AFTER(struct SSPObjUpdateInfo const &ui, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPObjUpdate_AFTER", Py_BuildValue("NI", ToPython(ui), iClientID));
+		if (bChangeFeed)
+			ChangeFeedPosition(iClientID, ui.vPos);
+		NATIVE_CHECK(FNE_SPObjUpdate_AFTER, iClientID, &ui);
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_SPObjUpdate, HookKey(ui, iClientID));
+		pyCallbackAfter(HKP_SPObjUpdate, "HkCbIServerImpl_SPObjUpdate_AFTER", pData ? pData : pyTuple(args, ToPython(ui), pyID(iClientID)));
 	}
 	EXPORT void __stdcall SPObjCollision(struct SSPObjCollisionInfo const &ci, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPObjCollision", Py_BuildValue("NI", ToPython(ci), iClientID));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_SPObjCollision, "HkCbIServerImpl_SPObjCollision", HookKey(ci, iClientID), pyTuple(args, ToPython(ci), pyID(iClientID)));
 	}
 	EXPORT void __stdcall SPObjCollision_AFTER(struct SSPObjCollisionInfo const &ci, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPObjCollision_AFTER", Py_BuildValue("NI", ToPython(ci), iClientID));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_SPObjCollision, HookKey(ci, iClientID));
+		pyCallbackAfter(HKP_SPObjCollision, "HkCbIServerImpl_SPObjCollision_AFTER", pData ? pData : pyTuple(args, ToPython(ci), pyID(iClientID)));
 	}
 	EXPORT void __stdcall LaunchComplete(unsigned int iBaseID, unsigned int iShip)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_LaunchComplete", Py_BuildValue("II", iBaseID, iShip));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_LaunchComplete, "HkCbIServerImpl_LaunchComplete", HookKey(iBaseID, iShip), pyTuple(args, pyID(iBaseID), pyID(iShip)), SequenceMutedLaunch(0, iShip));
 	}
 	EXPORT void __stdcall LaunchComplete_AFTER(unsigned int iBaseID, unsigned int iShip)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_LaunchComplete_AFTER", Py_BuildValue("II", iBaseID, iShip));
+		if (bSequenceTracking)
+			SequenceLaunchComplete(iBaseID, iShip);
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_LaunchComplete, HookKey(iBaseID, iShip));
+		pyCallbackAfter(HKP_LaunchComplete, "HkCbIServerImpl_LaunchComplete_AFTER", pData ? pData : pyTuple(args, pyID(iBaseID), pyID(iShip)));
 	}
 	EXPORT void __stdcall CharacterSelect(struct CHARACTER_ID const & cId, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		IniCacheInvalidateClient(iClientID); // the character being left is saved
+		ADMISSION_CHECK(iClientID);
 		pyCallback("HkCbIServerImpl_CharacterSelect", Py_BuildValue("NI", ToPython(cId), iClientID));
 	}
 	EXPORT void __stdcall CharacterSelect_AFTER(struct CHARACTER_ID const & cId, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		IniCacheInvalidateClient(iClientID);
+		ADMISSION_CHECK(iClientID);
 		pyCallback("HkCbIServerImpl_CharacterSelect_AFTER", Py_BuildValue("NI", ToPython(cId), iClientID));
 	}
 	EXPORT void __stdcall BaseEnter(unsigned int iBaseID, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_BaseEnter", Py_BuildValue("II", iBaseID, iClientID));
+		pyCallbackBefore(HKP_BaseEnter, "HkCbIServerImpl_BaseEnter", HookKey(iBaseID, iClientID), Py_BuildValue("II", iBaseID, iClientID));
 	}
 	EXPORT void __stdcall BaseEnter_AFTER(unsigned int iBaseID, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_BaseEnter_AFTER", Py_BuildValue("II", iBaseID, iClientID));
+		ShipRegistryClearClient(iClientID);
+		if (bChangeFeed) {
+			ChangeFeedSet(iClientID, CHG_BASE, iBaseID);
+			ChangeFeedSet(iClientID, CHG_SHIP, 0);
+			ChangeFeedDirty(iClientID, CHG_CASH);
+		}
+		PyObject *pData = pyPairArgs(HKP_BaseEnter, HookKey(iBaseID, iClientID));
+		pyCallbackAfter(HKP_BaseEnter, "HkCbIServerImpl_BaseEnter_AFTER", pData ? pData : Py_BuildValue("II", iBaseID, iClientID));
 	}
 	EXPORT void __stdcall BaseExit(unsigned int iBaseID, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_BaseExit", Py_BuildValue("II", iBaseID, iClientID));
+		pyCallbackBefore(HKP_BaseExit, "HkCbIServerImpl_BaseExit", HookKey(iBaseID, iClientID), Py_BuildValue("II", iBaseID, iClientID));
 	}
 	EXPORT void __stdcall BaseExit_AFTER(unsigned int iBaseID, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_BaseExit_AFTER", Py_BuildValue("II", iBaseID, iClientID));
+		if (bSequenceTracking)
+			SequenceBaseExit(iBaseID, iClientID);
+		if (bChangeFeed)
+			ChangeFeedSet(iClientID, CHG_BASE, 0);
+		PyObject *pData = pyPairArgs(HKP_BaseExit, HookKey(iBaseID, iClientID));
+		pyCallbackAfter(HKP_BaseExit, "HkCbIServerImpl_BaseExit_AFTER", pData ? pData : Py_BuildValue("II", iBaseID, iClientID));
 	}
 	EXPORT void __stdcall OnConnect(unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_OnConnect", Py_BuildValue("I", iClientID));
+		pyPairDrop(HKP_OnConnect);
+		if (!AdmissionConnect(iClientID))
+			return;
+		pyCallbackBefore(HKP_OnConnect, "HkCbIServerImpl_OnConnect", HookKey(iClientID), Py_BuildValue("I", iClientID));
 	}
 	EXPORT void __stdcall OnConnect_AFTER(unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_OnConnect_AFTER", Py_BuildValue("I", iClientID));
+		ADMISSION_CHECK(iClientID);
+		if (bChangeFeed)
+			ChangeFeedSet(iClientID, CHG_CONNECTED, 1);
+		PyObject *pData = pyPairArgs(HKP_OnConnect, HookKey(iClientID));
+		pyCallbackAfter(HKP_OnConnect, "HkCbIServerImpl_OnConnect_AFTER", pData ? pData : Py_BuildValue("I", iClientID));
 	}
 	EXPORT void __stdcall DisConnect(unsigned int iClientID, enum EFLConnection p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_DisConnect", Py_BuildValue("II", iClientID, p2));
+		SaveCharAsyncFlushClient(iClientID);
+		IniCacheInvalidateClient(iClientID);
+		ADMISSION_CHECK(iClientID);
+		pyCallbackBefore(HKP_DisConnect, "HkCbIServerImpl_DisConnect", HookKey(iClientID, p2), Py_BuildValue("II", iClientID, p2));
 	}
 	EXPORT void __stdcall DisConnect_AFTER(unsigned int iClientID, enum EFLConnection p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_DisConnect_AFTER", Py_BuildValue("II", iClientID, p2));
+		if (bSequenceTracking)
+			SequenceClearClient(iClientID);
+		bool bRejected = AdmissionRejected(iClientID);
+		AdmissionDisconnect(iClientID);
+		ChannelClearClient(iClientID);
+		OutboxClearClient(iClientID);
+		ShipRegistryClearClient(iClientID);
+		if (bChangeFeed)
+			ChangeFeedDisconnect(iClientID);
+		if (bRejected)
+			return;
+		PyObject *pData = pyPairArgs(HKP_DisConnect, HookKey(iClientID, p2));
+		pyCallbackAfter(HKP_DisConnect, "HkCbIServerImpl_DisConnect_AFTER", pData ? pData : Py_BuildValue("II", iClientID, p2));
 	}
 	EXPORT void __stdcall TerminateTrade(unsigned int iClientID, int iAccepted)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_TerminateTrade", Py_BuildValue("Ii", iClientID, iAccepted));
+		pyCallbackBefore(HKP_TerminateTrade, "HkCbIServerImpl_TerminateTrade", HookKey(iClientID, iAccepted), Py_BuildValue("Ii", iClientID, iAccepted), SequenceMutedTrade(iClientID));
 	}
 	EXPORT void __stdcall TerminateTrade_AFTER(unsigned int iClientID, int iAccepted)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_TerminateTrade_AFTER", Py_BuildValue("Ii", iClientID, iAccepted));
+		if (bSequenceTracking)
+			SequenceTerminateTrade(iClientID, iAccepted);
+		PyObject *pData = pyPairArgs(HKP_TerminateTrade, HookKey(iClientID, iAccepted));
+		pyCallbackAfter(HKP_TerminateTrade, "HkCbIServerImpl_TerminateTrade_AFTER", pData ? pData : Py_BuildValue("Ii", iClientID, iAccepted));
 	}
 	EXPORT void __stdcall InitiateTrade(unsigned int iClientID1, unsigned int iClientID2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_InitiateTrade", Py_BuildValue("II", iClientID1, iClientID2));
+		pyPairDrop(HKP_InitiateTrade);
+		RATE_CHECK(RLE_InitiateTrade, iClientID1);
+		pyCallbackBefore(HKP_InitiateTrade, "HkCbIServerImpl_InitiateTrade", HookKey(iClientID1, iClientID2), Py_BuildValue("II", iClientID1, iClientID2));
 	}
 	EXPORT void __stdcall InitiateTrade_AFTER(unsigned int iClientID1, unsigned int iClientID2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_InitiateTrade_AFTER", Py_BuildValue("II", iClientID1, iClientID2));
+		if (bSequenceTracking)
+			SequenceInitiateTrade(iClientID1, iClientID2);
+		RATE_CHECK_AFTER(RLE_InitiateTrade, iClientID1);
+		PyObject *pData = pyPairArgs(HKP_InitiateTrade, HookKey(iClientID1, iClientID2));
+		pyCallbackAfter(HKP_InitiateTrade, "HkCbIServerImpl_InitiateTrade_AFTER", pData ? pData : Py_BuildValue("II", iClientID1, iClientID2));
+		RATE_CLEAR(RLE_InitiateTrade, iClientID1);
 	}
 	EXPORT void __stdcall ActivateEquip(unsigned int iClientID, struct XActivateEquip const &aq)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ActivateEquip", Py_BuildValue("IN", iClientID, ToPython(aq)));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_ActivateEquip, "HkCbIServerImpl_ActivateEquip", HookKey(iClientID, aq), pyTuple(args, pyID(iClientID), ToPython(aq)));
 	}
 	EXPORT void __stdcall ActivateEquip_AFTER(unsigned int iClientID, struct XActivateEquip const &aq)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ActivateEquip_AFTER", Py_BuildValue("IN", iClientID, ToPython(aq)));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_ActivateEquip, HookKey(iClientID, aq));
+		pyCallbackAfter(HKP_ActivateEquip, "HkCbIServerImpl_ActivateEquip_AFTER", pData ? pData : pyTuple(args, pyID(iClientID), ToPython(aq)));
 	}
 	EXPORT void __stdcall ActivateCruise(unsigned int iClientID, struct XActivateCruise const &ac)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ActivateCruise", Py_BuildValue("IN", iClientID, ToPython(ac)));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_ActivateCruise, "HkCbIServerImpl_ActivateCruise", HookKey(iClientID, ac), pyTuple(args, pyID(iClientID), ToPython(ac)));
 	}
 	EXPORT void __stdcall ActivateCruise_AFTER(unsigned int iClientID, struct XActivateCruise const &ac)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ActivateCruise_AFTER", Py_BuildValue("IN", iClientID, ToPython(ac)));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_ActivateCruise, HookKey(iClientID, ac));
+		pyCallbackAfter(HKP_ActivateCruise, "HkCbIServerImpl_ActivateCruise_AFTER", pData ? pData : pyTuple(args, pyID(iClientID), ToPython(ac)));
 	}
 	EXPORT void __stdcall ActivateThrusters(unsigned int iClientID, struct XActivateThrusters const &at)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ActivateThrusters", Py_BuildValue("IN", iClientID, ToPython(at)));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_ActivateThrusters, "HkCbIServerImpl_ActivateThrusters", HookKey(iClientID, at), pyTuple(args, pyID(iClientID), ToPython(at)));
 	}
 	EXPORT void __stdcall ActivateThrusters_AFTER(unsigned int iClientID, struct XActivateThrusters const &at)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ActivateThrusters_AFTER", Py_BuildValue("IN", iClientID, ToPython(at)));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_ActivateThrusters, HookKey(iClientID, at));
+		pyCallbackAfter(HKP_ActivateThrusters, "HkCbIServerImpl_ActivateThrusters_AFTER", pData ? pData : pyTuple(args, pyID(iClientID), ToPython(at)));
 	}
 	EXPORT void __stdcall GFGoodSell(struct SGFGoodSellInfo const &gsi, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_GFGoodSell", Py_BuildValue("NI", ToPython(gsi), iClientID));
+		pyCallbackBefore(HKP_GFGoodSell, "HkCbIServerImpl_GFGoodSell", HookKey(gsi, iClientID), Py_BuildValue("NI", ToPython(gsi), iClientID));
 	}
 	EXPORT void __stdcall GFGoodSell_AFTER(struct SGFGoodSellInfo const &gsi, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_GFGoodSell_AFTER", Py_BuildValue("NI", ToPython(gsi), iClientID));
+		if (bChangeFeed)
+			ChangeFeedDirty(iClientID, CHG_CASH);
+		PyObject *pData = pyPairArgs(HKP_GFGoodSell, HookKey(gsi, iClientID));
+		pyCallbackAfter(HKP_GFGoodSell, "HkCbIServerImpl_GFGoodSell_AFTER", pData ? pData : Py_BuildValue("NI", ToPython(gsi), iClientID));
 	}
 	EXPORT void __stdcall CharacterInfoReq(unsigned int iClientID, bool p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_CharacterInfoReq", Py_BuildValue("IO", iClientID, PY_BOOL(p2)));
+		ADMISSION_CHECK(iClientID);
+		pyCallbackBefore(HKP_CharacterInfoReq, "HkCbIServerImpl_CharacterInfoReq", HookKey(iClientID, p2), Py_BuildValue("IO", iClientID, PY_BOOL(p2)));
 	}
 	EXPORT void __stdcall CharacterInfoReq_AFTER(unsigned int iClientID, bool p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_CharacterInfoReq_AFTER", Py_BuildValue("IO", iClientID, PY_BOOL(p2)));
+		ADMISSION_CHECK(iClientID);
+		PyObject *pData = pyPairArgs(HKP_CharacterInfoReq, HookKey(iClientID, p2));
+		pyCallbackAfter(HKP_CharacterInfoReq, "HkCbIServerImpl_CharacterInfoReq_AFTER", pData ? pData : Py_BuildValue("IO", iClientID, PY_BOOL(p2)));
 	}
 	EXPORT void __stdcall JumpInComplete(unsigned int iSystemID, unsigned int iShip)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_JumpInComplete", Py_BuildValue("II", iSystemID, iShip));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_JumpInComplete, "HkCbIServerImpl_JumpInComplete", HookKey(iSystemID, iShip), pyTuple(args, pyID(iSystemID), pyID(iShip)));
 	}
 	EXPORT void __stdcall JumpInComplete_AFTER(unsigned int iSystemID, unsigned int iShip)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_JumpInComplete_AFTER", Py_BuildValue("II", iSystemID, iShip));
+		if (bChangeFeed) {
+			const SHIP_ENTRY *pEntry = ShipRegistryFind(iShip);
+			if (pEntry && pEntry->iClientID)
+				ChangeFeedSet(pEntry->iClientID, CHG_SYSTEM, iSystemID);
+		}
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_JumpInComplete, HookKey(iSystemID, iShip));
+		pyCallbackAfter(HKP_JumpInComplete, "HkCbIServerImpl_JumpInComplete_AFTER", pData ? pData : pyTuple(args, pyID(iSystemID), pyID(iShip)));
 	}
 	EXPORT void __stdcall SystemSwitchOutComplete(unsigned int iShip, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SystemSwitchOutComplete", Py_BuildValue("II", iShip, iClientID));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_SystemSwitchOutComplete, "HkCbIServerImpl_SystemSwitchOutComplete", HookKey(iShip, iClientID), pyTuple(args, pyID(iShip), pyID(iClientID)));
 	}
 	EXPORT void __stdcall SystemSwitchOutComplete_AFTER(unsigned int iShip, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SystemSwitchOutComplete_AFTER", Py_BuildValue("II", iShip, iClientID));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_SystemSwitchOutComplete, HookKey(iShip, iClientID));
+		pyCallbackAfter(HKP_SystemSwitchOutComplete, "HkCbIServerImpl_SystemSwitchOutComplete_AFTER", pData ? pData : pyTuple(args, pyID(iShip), pyID(iClientID)));
 	}
 	EXPORT void __stdcall Login(struct SLoginInfo const &li, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		if (!AdmissionLogin(li.wszAccount, iClientID))
+			return;
 		pyCallback("HkCbIServerImpl_Login", Py_BuildValue("NI", ToPython(li), iClientID));
 	}
 	EXPORT void __stdcall Login_AFTER(struct SLoginInfo const &li, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		ADMISSION_CHECK(iClientID);
 		pyCallback("HkCbIServerImpl_Login_AFTER", Py_BuildValue("NI", ToPython(li), iClientID));
 	}
 	EXPORT void __stdcall MineAsteroid(unsigned int p1, class Vector const &vPos, unsigned int iLookID, unsigned int iGoodID, unsigned int iCount, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_MineAsteroid", Py_BuildValue("INIIII", p1, ToPython(vPos), iLookID, iGoodID, iCount, iClientID));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_MineAsteroid, "HkCbIServerImpl_MineAsteroid", HookKey(p1, vPos, iLookID, iGoodID, iCount, iClientID), pyTuple(args, pyID(p1), ToPython(vPos), pyID(iLookID), pyID(iGoodID), pyID(iCount), pyID(iClientID)));
 	}
 	EXPORT void __stdcall MineAsteroid_AFTER(unsigned int p1, class Vector const &vPos, unsigned int iLookID, unsigned int iGoodID, unsigned int iCount, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_MineAsteroid_AFTER", Py_BuildValue("INIIII", p1, ToPython(vPos), iLookID, iGoodID, iCount, iClientID));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_MineAsteroid, HookKey(p1, vPos, iLookID, iGoodID, iCount, iClientID));
+		pyCallbackAfter(HKP_MineAsteroid, "HkCbIServerImpl_MineAsteroid_AFTER", pData ? pData : pyTuple(args, pyID(p1), ToPython(vPos), pyID(iLookID), pyID(iGoodID), pyID(iCount), pyID(iClientID)));
 	}
 	EXPORT void __stdcall GoTradelane(unsigned int iClientID, struct XGoTradelane const &gtl)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_GoTradelane", Py_BuildValue("IN", iClientID, ToPython(gtl)));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_GoTradelane, "HkCbIServerImpl_GoTradelane", HookKey(iClientID, gtl), pyTuple(args, pyID(iClientID), ToPython(gtl)));
 	}
 	EXPORT void __stdcall GoTradelane_AFTER(unsigned int iClientID, struct XGoTradelane const &gtl)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_GoTradelane_AFTER", Py_BuildValue("IN", iClientID, ToPython(gtl)));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_GoTradelane, HookKey(iClientID, gtl));
+		pyCallbackAfter(HKP_GoTradelane, "HkCbIServerImpl_GoTradelane_AFTER", pData ? pData : pyTuple(args, pyID(iClientID), ToPython(gtl)));
 	}
 	EXPORT void __stdcall StopTradelane(unsigned int iClientID, unsigned int p2, unsigned int p3, unsigned int p4)
 	{
@@ -520,82 +857,98 @@ namespace HkIServerImpl
 	EXPORT void __stdcall AbortMission(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_AbortMission", Py_BuildValue("II", p1, p2));
+		pyCallbackBefore(HKP_AbortMission, "HkCbIServerImpl_AbortMission", HookKey(p1, p2), Py_BuildValue("II", p1, p2));
 	}
 	EXPORT void __stdcall AbortMission_AFTER(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_AbortMission_AFTER", Py_BuildValue("II", p1, p2));
+		PyObject *pData = pyPairArgs(HKP_AbortMission, HookKey(p1, p2));
+		pyCallbackAfter(HKP_AbortMission, "HkCbIServerImpl_AbortMission_AFTER", pData ? pData : Py_BuildValue("II", p1, p2));
 	}
 	EXPORT void __stdcall AcceptTrade(unsigned int iClientID, bool p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_AcceptTrade", Py_BuildValue("IO", iClientID, PY_BOOL(p2)));
+		pyCallbackBefore(HKP_AcceptTrade, "HkCbIServerImpl_AcceptTrade", HookKey(iClientID, p2), Py_BuildValue("IO", iClientID, PY_BOOL(p2)), SequenceMutedTrade(iClientID));
 	}
 	EXPORT void __stdcall AcceptTrade_AFTER(unsigned int iClientID, bool p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_AcceptTrade_AFTER", Py_BuildValue("IO", iClientID, PY_BOOL(p2)));
+		PyObject *pData = pyPairArgs(HKP_AcceptTrade, HookKey(iClientID, p2));
+		pyCallbackAfter(HKP_AcceptTrade, "HkCbIServerImpl_AcceptTrade_AFTER", pData ? pData : Py_BuildValue("IO", iClientID, PY_BOOL(p2)));
 	}
 	EXPORT void __stdcall AddTradeEquip(unsigned int iClientID, struct EquipDesc const &ed)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_AddTradeEquip", Py_BuildValue("IN", iClientID, ToPython(ed)));
+		pyCallbackBefore(HKP_AddTradeEquip, "HkCbIServerImpl_AddTradeEquip", HookKey(iClientID, ed.iDunno, ed.sID, ed.iArchID, ed.bMounted, ed.fHealth, ed.iCount, ed.bMission, ed.iOwner), Py_BuildValue("IN", iClientID, ToPython(ed)), SequenceMutedTrade(iClientID));
 	}
 	EXPORT void __stdcall AddTradeEquip_AFTER(unsigned int iClientID, struct EquipDesc const &ed)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_AddTradeEquip_AFTER", Py_BuildValue("IN", iClientID, ToPython(ed)));
+		if (bSequenceTracking)
+			SequenceTradeEquip(iClientID, ed, true);
+		PyObject *pData = pyPairArgs(HKP_AddTradeEquip, HookKey(iClientID, ed.iDunno, ed.sID, ed.iArchID, ed.bMounted, ed.fHealth, ed.iCount, ed.bMission, ed.iOwner));
+		pyCallbackAfter(HKP_AddTradeEquip, "HkCbIServerImpl_AddTradeEquip_AFTER", pData ? pData : Py_BuildValue("IN", iClientID, ToPython(ed)));
 	}
 	EXPORT void __stdcall BaseInfoRequest(unsigned int p1, unsigned int p2, bool p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_BaseInfoRequest", Py_BuildValue("IIO", p1, p2, PY_BOOL(p3)));
+		pyCallbackBefore(HKP_BaseInfoRequest, "HkCbIServerImpl_BaseInfoRequest", HookKey(p1, p2, p3), Py_BuildValue("IIO", p1, p2, PY_BOOL(p3)));
 	}
 	EXPORT void __stdcall BaseInfoRequest_AFTER(unsigned int p1, unsigned int p2, bool p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_BaseInfoRequest_AFTER", Py_BuildValue("IIO", p1, p2, PY_BOOL(p3)));
+		PyObject *pData = pyPairArgs(HKP_BaseInfoRequest, HookKey(p1, p2, p3));
+		pyCallbackAfter(HKP_BaseInfoRequest, "HkCbIServerImpl_BaseInfoRequest_AFTER", pData ? pData : Py_BuildValue("IIO", p1, p2, PY_BOOL(p3)));
 	}
 	EXPORT void __stdcall CreateNewCharacter(struct SCreateCharacterInfo const & scci, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		ADMISSION_CHECK(iClientID);
 		pyCallback("HkCbIServerImpl_CreateNewCharacter", Py_BuildValue("NI", ToPython(scci), iClientID));
 	}
 	EXPORT void __stdcall CreateNewCharacter_AFTER(struct SCreateCharacterInfo const & scci, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		ADMISSION_CHECK(iClientID);
 		pyCallback("HkCbIServerImpl_CreateNewCharacter_AFTER", Py_BuildValue("NI", ToPython(scci), iClientID));
 	}
 	EXPORT void __stdcall DelTradeEquip(unsigned int iClientID, struct EquipDesc const &ed)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_DelTradeEquip", Py_BuildValue("IN", iClientID, ToPython(ed)));
+		pyCallbackBefore(HKP_DelTradeEquip, "HkCbIServerImpl_DelTradeEquip", HookKey(iClientID, ed.iDunno, ed.sID, ed.iArchID, ed.bMounted, ed.fHealth, ed.iCount, ed.bMission, ed.iOwner), Py_BuildValue("IN", iClientID, ToPython(ed)), SequenceMutedTrade(iClientID));
 	}
 	EXPORT void __stdcall DelTradeEquip_AFTER(unsigned int iClientID, struct EquipDesc const &ed)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_DelTradeEquip_AFTER", Py_BuildValue("IN", iClientID, ToPython(ed)));
+		if (bSequenceTracking)
+			SequenceTradeEquip(iClientID, ed, false);
+		PyObject *pData = pyPairArgs(HKP_DelTradeEquip, HookKey(iClientID, ed.iDunno, ed.sID, ed.iArchID, ed.bMounted, ed.fHealth, ed.iCount, ed.bMission, ed.iOwner));
+		pyCallbackAfter(HKP_DelTradeEquip, "HkCbIServerImpl_DelTradeEquip_AFTER", pData ? pData : Py_BuildValue("IN", iClientID, ToPython(ed)));
 	}
 	EXPORT void __stdcall DestroyCharacter(struct CHARACTER_ID const &cId, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		ADMISSION_CHECK(iClientID);
 		pyCallback("HkCbIServerImpl_DestroyCharacter", Py_BuildValue("NI", ToPython(cId), iClientID));
 	}
 	EXPORT void __stdcall DestroyCharacter_AFTER(struct CHARACTER_ID const &cId, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		ADMISSION_CHECK(iClientID);
 		pyCallback("HkCbIServerImpl_DestroyCharacter_AFTER", Py_BuildValue("NI", ToPython(cId), iClientID));
 	}
 	EXPORT void __stdcall GFGoodBuy(struct SGFGoodBuyInfo const &gbi, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_GFGoodBuy", Py_BuildValue("NI", ToPython(gbi), iClientID));
+		pyCallbackBefore(HKP_GFGoodBuy, "HkCbIServerImpl_GFGoodBuy", HookKey(gbi, iClientID), Py_BuildValue("NI", ToPython(gbi), iClientID));
 	}
 	EXPORT void __stdcall GFGoodBuy_AFTER(struct SGFGoodBuyInfo const &gbi, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_GFGoodBuy_AFTER", Py_BuildValue("NI", ToPython(gbi), iClientID));
+		if (bChangeFeed)
+			ChangeFeedDirty(iClientID, CHG_CASH);
+		PyObject *pData = pyPairArgs(HKP_GFGoodBuy, HookKey(gbi, iClientID));
+		pyCallbackAfter(HKP_GFGoodBuy, "HkCbIServerImpl_GFGoodBuy_AFTER", pData ? pData : Py_BuildValue("NI", ToPython(gbi), iClientID));
 	}
 	// TBD
 	EXPORT void __stdcall GFGoodVaporized(struct SGFGoodVaporizedInfo const &gvi, unsigned int iClientID)
@@ -610,82 +963,94 @@ namespace HkIServerImpl
 	EXPORT void __stdcall GFObjSelect(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_GFObjSelect", Py_BuildValue("II", p1, p2));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_GFObjSelect, "HkCbIServerImpl_GFObjSelect", HookKey(p1, p2), pyTuple(args, pyID(p1), pyID(p2)));
 	}
 	EXPORT void __stdcall GFObjSelect_AFTER(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_GFObjSelect_AFTER", Py_BuildValue("II", p1, p2));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_GFObjSelect, HookKey(p1, p2));
+		pyCallbackAfter(HKP_GFObjSelect, "HkCbIServerImpl_GFObjSelect_AFTER", pData ? pData : pyTuple(args, pyID(p1), pyID(p2)));
 	}
 	EXPORT void __stdcall Hail(unsigned int p1, unsigned int p2, unsigned int p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_Hail", Py_BuildValue("III", p1, p2, p3));
+		pyCallbackBefore(HKP_Hail, "HkCbIServerImpl_Hail", HookKey(p1, p2, p3), Py_BuildValue("III", p1, p2, p3));
 	}
 	EXPORT void __stdcall Hail_AFTER(unsigned int p1, unsigned int p2, unsigned int p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_Hail_AFTER", Py_BuildValue("III", p1, p2, p3));
+		PyObject *pData = pyPairArgs(HKP_Hail, HookKey(p1, p2, p3));
+		pyCallbackAfter(HKP_Hail, "HkCbIServerImpl_Hail_AFTER", pData ? pData : Py_BuildValue("III", p1, p2, p3));
 	}
 	EXPORT void __stdcall InterfaceItemUsed(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_InterfaceItemUsed", Py_BuildValue("II", p1, p2));
+		pyCallbackBefore(HKP_InterfaceItemUsed, "HkCbIServerImpl_InterfaceItemUsed", HookKey(p1, p2), Py_BuildValue("II", p1, p2));
 	}
 	EXPORT void __stdcall InterfaceItemUsed_AFTER(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_InterfaceItemUsed_AFTER", Py_BuildValue("II", p1, p2));
+		PyObject *pData = pyPairArgs(HKP_InterfaceItemUsed, HookKey(p1, p2));
+		pyCallbackAfter(HKP_InterfaceItemUsed, "HkCbIServerImpl_InterfaceItemUsed_AFTER", pData ? pData : Py_BuildValue("II", p1, p2));
 	}
 	EXPORT void __stdcall JettisonCargo(unsigned int iClientID, struct XJettisonCargo const &jc)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_JettisonCargo", Py_BuildValue("IN", iClientID, ToPython(jc)));
+		pyCallbackBefore(HKP_JettisonCargo, "HkCbIServerImpl_JettisonCargo", HookKey(iClientID, jc), Py_BuildValue("IN", iClientID, ToPython(jc)));
 	}
 	EXPORT void __stdcall JettisonCargo_AFTER(unsigned int iClientID, struct XJettisonCargo const &jc)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_JettisonCargo_AFTER", Py_BuildValue("IN", iClientID, ToPython(jc)));
+		PyObject *pData = pyPairArgs(HKP_JettisonCargo, HookKey(iClientID, jc));
+		pyCallbackAfter(HKP_JettisonCargo, "HkCbIServerImpl_JettisonCargo_AFTER", pData ? pData : Py_BuildValue("IN", iClientID, ToPython(jc)));
 	}
 	EXPORT void __stdcall LocationEnter(unsigned int p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_LocationEnter", Py_BuildValue("II", p1, iClientID));
+		pyCallbackBefore(HKP_LocationEnter, "HkCbIServerImpl_LocationEnter", HookKey(p1, iClientID), Py_BuildValue("II", p1, iClientID));
 	}
 	EXPORT void __stdcall LocationEnter_AFTER(unsigned int p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_LocationEnter_AFTER", Py_BuildValue("II", p1, iClientID));
+		PyObject *pData = pyPairArgs(HKP_LocationEnter, HookKey(p1, iClientID));
+		pyCallbackAfter(HKP_LocationEnter, "HkCbIServerImpl_LocationEnter_AFTER", pData ? pData : Py_BuildValue("II", p1, iClientID));
 	}
 	EXPORT void __stdcall LocationExit(unsigned int p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_LocationExit", Py_BuildValue("II", p1, iClientID));
+		pyCallbackBefore(HKP_LocationExit, "HkCbIServerImpl_LocationExit", HookKey(p1, iClientID), Py_BuildValue("II", p1, iClientID));
 	}
 	EXPORT void __stdcall LocationExit_AFTER(unsigned int p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_LocationExit_AFTER", Py_BuildValue("II", p1, iClientID));
+		if (bSequenceTracking)
+			SequenceLocationExit(iClientID);
+		PyObject *pData = pyPairArgs(HKP_LocationExit, HookKey(p1, iClientID));
+		pyCallbackAfter(HKP_LocationExit, "HkCbIServerImpl_LocationExit_AFTER", pData ? pData : Py_BuildValue("II", p1, iClientID));
 	}
 	EXPORT void __stdcall LocationInfoRequest(unsigned int p1,unsigned int p2, bool p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_LocationInfoRequest", Py_BuildValue("IIO", p1, p2, PY_BOOL(p3)));
+		pyCallbackBefore(HKP_LocationInfoRequest, "HkCbIServerImpl_LocationInfoRequest", HookKey(p1, p2, p3), Py_BuildValue("IIO", p1, p2, PY_BOOL(p3)));
 	}
 	EXPORT void __stdcall LocationInfoRequest_AFTER(unsigned int p1,unsigned int p2, bool p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_LocationInfoRequest_AFTER", Py_BuildValue("IIO", p1, p2, PY_BOOL(p3)));
+		PyObject *pData = pyPairArgs(HKP_LocationInfoRequest, HookKey(p1, p2, p3));
+		pyCallbackAfter(HKP_LocationInfoRequest, "HkCbIServerImpl_LocationInfoRequest_AFTER", pData ? pData : Py_BuildValue("IIO", p1, p2, PY_BOOL(p3)));
 	}
 	EXPORT void __stdcall MissionResponse(unsigned int p1, unsigned long p2, bool p3, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_MissionResponse", Py_BuildValue("IIOI", p1, p2, PY_BOOL(p3), iClientID));
+		pyCallbackBefore(HKP_MissionResponse, "HkCbIServerImpl_MissionResponse", HookKey(p1, p2, p3, iClientID), Py_BuildValue("IIOI", p1, p2, PY_BOOL(p3), iClientID));
 	}
 	EXPORT void __stdcall MissionResponse_AFTER(unsigned int p1, unsigned long p2, bool p3, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_MissionResponse_AFTER", Py_BuildValue("IIOI", p1, p2, PY_BOOL(p3), iClientID));
+		PyObject *pData = pyPairArgs(HKP_MissionResponse, HookKey(p1, p2, p3, iClientID));
+		pyCallbackAfter(HKP_MissionResponse, "HkCbIServerImpl_MissionResponse_AFTER", pData ? pData : Py_BuildValue("IIOI", p1, p2, PY_BOOL(p3), iClientID));
 	}
 	EXPORT void __stdcall ReqAddItem(unsigned int p1, char const *p2, int p3, float p4, bool p5, unsigned int p6)
 	{
@@ -700,12 +1065,15 @@ namespace HkIServerImpl
 	EXPORT void __stdcall ReqChangeCash(int p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqChangeCash", Py_BuildValue("iI", p1, iClientID));
+		pyCallbackBefore(HKP_ReqChangeCash, "HkCbIServerImpl_ReqChangeCash", HookKey(p1, iClientID), Py_BuildValue("iI", p1, iClientID));
 	}
 	EXPORT void __stdcall ReqChangeCash_AFTER(int p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqChangeCash_AFTER", Py_BuildValue("iI", p1, iClientID));
+		if (bChangeFeed)
+			ChangeFeedDirty(iClientID, CHG_CASH);
+		PyObject *pData = pyPairArgs(HKP_ReqChangeCash, HookKey(p1, iClientID));
+		pyCallbackAfter(HKP_ReqChangeCash, "HkCbIServerImpl_ReqChangeCash_AFTER", pData ? pData : Py_BuildValue("iI", p1, iClientID));
 	}
 	// TBD
 	EXPORT void __stdcall ReqCollisionGroups(class std::list<struct CollisionGroupDesc,class std::allocator<struct CollisionGroupDesc> > const &p1, unsigned int iClientID)
@@ -730,12 +1098,15 @@ namespace HkIServerImpl
 	EXPORT void __stdcall ReqHullStatus(float p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqHullStatus", Py_BuildValue("fI", p1, iClientID));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_ReqHullStatus, "HkCbIServerImpl_ReqHullStatus", HookKey(p1, iClientID), pyTuple(args, pyFloat(p1), pyID(iClientID)));
 	}
 	EXPORT void __stdcall ReqHullStatus_AFTER(float p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqHullStatus_AFTER", Py_BuildValue("fI", p1, iClientID));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_ReqHullStatus, HookKey(p1, iClientID));
+		pyCallbackAfter(HKP_ReqHullStatus, "HkCbIServerImpl_ReqHullStatus_AFTER", pData ? pData : pyTuple(args, pyFloat(p1), pyID(iClientID)));
 	}
 	EXPORT void __stdcall ReqModifyItem(unsigned short p1, char const *p2, int p3, float p4, bool p5, unsigned int iClientID)
 	{
@@ -750,32 +1121,37 @@ namespace HkIServerImpl
 	EXPORT void __stdcall ReqRemoveItem(unsigned short p1, int p2, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqRemoveItem", Py_BuildValue("HiI", p1, p2, iClientID));
+		pyCallbackBefore(HKP_ReqRemoveItem, "HkCbIServerImpl_ReqRemoveItem", HookKey(p1, p2, iClientID), Py_BuildValue("HiI", p1, p2, iClientID));
 	}
 	EXPORT void __stdcall ReqRemoveItem_AFTER(unsigned short p1, int p2, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqRemoveItem_AFTER", Py_BuildValue("HiI", p1, p2, iClientID));
+		PyObject *pData = pyPairArgs(HKP_ReqRemoveItem, HookKey(p1, p2, iClientID));
+		pyCallbackAfter(HKP_ReqRemoveItem, "HkCbIServerImpl_ReqRemoveItem_AFTER", pData ? pData : Py_BuildValue("HiI", p1, p2, iClientID));
 	}
 	EXPORT void __stdcall ReqSetCash(int p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqSetCash", Py_BuildValue("iI", p1, iClientID));
+		pyCallbackBefore(HKP_ReqSetCash, "HkCbIServerImpl_ReqSetCash", HookKey(p1, iClientID), Py_BuildValue("iI", p1, iClientID));
 	}
 	EXPORT void __stdcall ReqSetCash_AFTER(int p1, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqSetCash_AFTER", Py_BuildValue("iI", p1, iClientID));
+		if (bChangeFeed)
+			ChangeFeedDirty(iClientID, CHG_CASH);
+		PyObject *pData = pyPairArgs(HKP_ReqSetCash, HookKey(p1, iClientID));
+		pyCallbackAfter(HKP_ReqSetCash, "HkCbIServerImpl_ReqSetCash_AFTER", pData ? pData : Py_BuildValue("iI", p1, iClientID));
 	}
 	EXPORT void __stdcall ReqShipArch(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqShipArch", Py_BuildValue("II", p1, p2));
+		pyCallbackBefore(HKP_ReqShipArch, "HkCbIServerImpl_ReqShipArch", HookKey(p1, p2), Py_BuildValue("II", p1, p2));
 	}
 	EXPORT void __stdcall ReqShipArch_AFTER(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_ReqShipArch_AFTER", Py_BuildValue("II", p1, p2));
+		PyObject *pData = pyPairArgs(HKP_ReqShipArch, HookKey(p1, p2));
+		pyCallbackAfter(HKP_ReqShipArch, "HkCbIServerImpl_ReqShipArch_AFTER", pData ? pData : Py_BuildValue("II", p1, p2));
 	}
 	EXPORT void __stdcall RequestBestPath(unsigned int p1, unsigned char *p2, int p3)
 	{
@@ -790,32 +1166,41 @@ namespace HkIServerImpl
 	EXPORT void __stdcall RequestCancel(int iType, unsigned int iShip, unsigned int p3, unsigned long p4, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_RequestCancel", Py_BuildValue("iIIkI", iType, iShip, p3, p4, iClientID));
+		pyCallbackBefore(HKP_RequestCancel, "HkCbIServerImpl_RequestCancel", HookKey(iType, iShip, p3, p4, iClientID), Py_BuildValue("iIIkI", iType, iShip, p3, p4, iClientID));
 	}
 	EXPORT void __stdcall RequestCancel_AFTER(int iType, unsigned int iShip, unsigned int p3, unsigned long p4, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_RequestCancel_AFTER", Py_BuildValue("iIIkI", iType, iShip, p3, p4, iClientID));
+		PyObject *pData = pyPairArgs(HKP_RequestCancel, HookKey(iType, iShip, p3, p4, iClientID));
+		pyCallbackAfter(HKP_RequestCancel, "HkCbIServerImpl_RequestCancel_AFTER", pData ? pData : Py_BuildValue("iIIkI", iType, iShip, p3, p4, iClientID));
 	}
 	EXPORT void __stdcall RequestCreateShip(unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_RequestCreateShip", Py_BuildValue("I", iClientID));
+		pyCallbackBefore(HKP_RequestCreateShip, "HkCbIServerImpl_RequestCreateShip", HookKey(iClientID), Py_BuildValue("I", iClientID));
 	}
 	EXPORT void __stdcall RequestCreateShip_AFTER(unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_RequestCreateShip_AFTER", Py_BuildValue("I", iClientID));
+		PyObject *pData = pyPairArgs(HKP_RequestCreateShip, HookKey(iClientID));
+		pyCallbackAfter(HKP_RequestCreateShip, "HkCbIServerImpl_RequestCreateShip_AFTER", pData ? pData : Py_BuildValue("I", iClientID));
 	}
 	EXPORT void __stdcall RequestEvent(int p1, unsigned int p2, unsigned int p3, unsigned int p4, unsigned long p5, unsigned int p6)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_RequestEvent", Py_BuildValue("iIIIkI", p1, p2, p3, p4, p5, p6));
+		pyPairDrop(HKP_RequestEvent);
+		RATE_CHECK(RLE_RequestEvent, p6);
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_RequestEvent, "HkCbIServerImpl_RequestEvent", HookKey(p1, p2, p3, p4, p5, p6), pyTuple(args, pyInt(p1), pyID(p2), pyID(p3), pyID(p4), PyLong_FromUnsignedLong(p5), pyID(p6)));
 	}
 	EXPORT void __stdcall RequestEvent_AFTER(int p1, unsigned int p2, unsigned int p3, unsigned int p4, unsigned long p5, unsigned int p6)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_RequestEvent_AFTER", Py_BuildValue("iIIIkI", p1, p2, p3, p4, p5, p6));
+		RATE_CHECK_AFTER(RLE_RequestEvent, p6);
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_RequestEvent, HookKey(p1, p2, p3, p4, p5, p6));
+		pyCallbackAfter(HKP_RequestEvent, "HkCbIServerImpl_RequestEvent_AFTER", pData ? pData : pyTuple(args, pyInt(p1), pyID(p2), pyID(p3), pyID(p4), PyLong_FromUnsignedLong(p5), pyID(p6)));
+		RATE_CLEAR(RLE_RequestEvent, p6);
 	}
 	EXPORT void __stdcall RequestGroupPositions(unsigned int p1, unsigned char *p2, int p3)
 	{
@@ -850,22 +1235,26 @@ namespace HkIServerImpl
 	EXPORT void __stdcall RequestTrade(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_RequestTrade", Py_BuildValue("II", p1, p2));
+		pyCallbackBefore(HKP_RequestTrade, "HkCbIServerImpl_RequestTrade", HookKey(p1, p2), Py_BuildValue("II", p1, p2));
 	}
 	EXPORT void __stdcall RequestTrade_AFTER(unsigned int p1, unsigned int p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_RequestTrade_AFTER", Py_BuildValue("II", p1, p2));
+		PyObject *pData = pyPairArgs(HKP_RequestTrade, HookKey(p1, p2));
+		pyCallbackAfter(HKP_RequestTrade, "HkCbIServerImpl_RequestTrade_AFTER", pData ? pData : Py_BuildValue("II", p1, p2));
 	}
 	EXPORT void __stdcall SPRequestInvincibility(unsigned int iShip, bool p2, enum InvincibilityReason p3, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPRequestInvincibility", Py_BuildValue("IOII", iShip, PY_BOOL(p2), p3, iClientID));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_SPRequestInvincibility, "HkCbIServerImpl_SPRequestInvincibility", HookKey(iShip, p2, p3, iClientID), pyTuple(args, pyID(iShip), pyBool(p2), pyID(p3), pyID(iClientID)));
 	}
 	EXPORT void __stdcall SPRequestInvincibility_AFTER(unsigned int iShip, bool p2, enum InvincibilityReason p3, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPRequestInvincibility_AFTER", Py_BuildValue("IOII", iShip, PY_BOOL(p2), p3, iClientID));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_SPRequestInvincibility, HookKey(iShip, p2, p3, iClientID));
+		pyCallbackAfter(HKP_SPRequestInvincibility, "HkCbIServerImpl_SPRequestInvincibility_AFTER", pData ? pData : pyTuple(args, pyID(iShip), pyBool(p2), pyID(p3), pyID(iClientID)));
 	}
 	// TBD
 	EXPORT void __stdcall SPRequestUseItem(struct SSPUseItem const &p1, unsigned int iClientID)
@@ -881,12 +1270,15 @@ namespace HkIServerImpl
 	EXPORT void __stdcall SPScanCargo(unsigned int const &p1, unsigned int const &p2, unsigned int p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPScanCargo", Py_BuildValue("III", p1, p2, p3));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_SPScanCargo, "HkCbIServerImpl_SPScanCargo", HookKey(p1, p2, p3), pyTuple(args, pyID(p1), pyID(p2), pyID(p3)));
 	}
 	EXPORT void __stdcall SPScanCargo_AFTER(unsigned int const &p1, unsigned int const &p2, unsigned int p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SPScanCargo_AFTER", Py_BuildValue("III", p1, p2, p3));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_SPScanCargo, HookKey(p1, p2, p3));
+		pyCallbackAfter(HKP_SPScanCargo, "HkCbIServerImpl_SPScanCargo_AFTER", pData ? pData : pyTuple(args, pyID(p1), pyID(p2), pyID(p3)));
 	}
 	EXPORT void __stdcall SetInterfaceState(unsigned int p1, unsigned char *p2, int p3)
 	{
@@ -901,57 +1293,77 @@ namespace HkIServerImpl
 	EXPORT void __stdcall SetManeuver(unsigned int iClientID, struct XSetManeuver const &p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetManeuver", Py_BuildValue("IN", iClientID, ToPython(p2)));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_SetManeuver, "HkCbIServerImpl_SetManeuver", HookKey(iClientID, p2), pyTuple(args, pyID(iClientID), ToPython(p2)));
 	}
 	EXPORT void __stdcall SetManeuver_AFTER(unsigned int iClientID, struct XSetManeuver const &p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetManeuver_AFTER", Py_BuildValue("IN", iClientID, ToPython(p2)));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_SetManeuver, HookKey(iClientID, p2));
+		pyCallbackAfter(HKP_SetManeuver, "HkCbIServerImpl_SetManeuver_AFTER", pData ? pData : pyTuple(args, pyID(iClientID), ToPython(p2)));
 	}
 	EXPORT void __stdcall SetTarget(unsigned int iClientID, struct XSetTarget const &p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetTarget", Py_BuildValue("IN", iClientID, ToPython(p2)));
+		static PY_ARGS args;
+		pyCallbackBefore(HKP_SetTarget, "HkCbIServerImpl_SetTarget", HookKey(iClientID, p2), pyTuple(args, pyID(iClientID), ToPython(p2)));
 	}
 	EXPORT void __stdcall SetTarget_AFTER(unsigned int iClientID, struct XSetTarget const &p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetTarget_AFTER", Py_BuildValue("IN", iClientID, ToPython(p2)));
+		static PY_ARGS args;
+		PyObject *pData = pyPairArgs(HKP_SetTarget, HookKey(iClientID, p2));
+		pyCallbackAfter(HKP_SetTarget, "HkCbIServerImpl_SetTarget_AFTER", pData ? pData : pyTuple(args, pyID(iClientID), ToPython(p2)));
 	}
 	EXPORT void __stdcall SetTradeMoney(unsigned int iClientID, unsigned long p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetTradeMoney", Py_BuildValue("Ik", iClientID, p2));
+		pyCallbackBefore(HKP_SetTradeMoney, "HkCbIServerImpl_SetTradeMoney", HookKey(iClientID, p2), Py_BuildValue("Ik", iClientID, p2), SequenceMutedTrade(iClientID));
 	}
 	EXPORT void __stdcall SetTradeMoney_AFTER(unsigned int iClientID, unsigned long p2)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetTradeMoney_AFTER", Py_BuildValue("Ik", iClientID, p2));
+		if (bSequenceTracking)
+			SequenceTradeMoney(iClientID, p2);
+		PyObject *pData = pyPairArgs(HKP_SetTradeMoney, HookKey(iClientID, p2));
+		pyCallbackAfter(HKP_SetTradeMoney, "HkCbIServerImpl_SetTradeMoney_AFTER", pData ? pData : Py_BuildValue("Ik", iClientID, p2));
 	}
 	EXPORT void __stdcall SetVisitedState(unsigned int iClientID, unsigned char *p2, int p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetVisitedState", Py_BuildValue("Is#i", iClientID, p2, strlen((char*)p2), p3));
+		PyObject *pPayload = pyPayload(p2, p3);
+		pyCallback("HkCbIServerImpl_SetVisitedState", Py_BuildValue("IOi", iClientID, pPayload, p3));
+		pyPayloadRelease(pPayload);
 	}
 	EXPORT void __stdcall SetVisitedState_AFTER(unsigned int iClientID, unsigned char *p2, int p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetVisitedState_AFTER", Py_BuildValue("Is#i", iClientID, p2, strlen((char*)p2), p3));
+		PyObject *pPayload = pyPayload(p2, p3);
+		pyCallback("HkCbIServerImpl_SetVisitedState_AFTER", Py_BuildValue("IOi", iClientID, pPayload, p3));
+		pyPayloadRelease(pPayload);
 	}
 	EXPORT void __stdcall SetWeaponGroup(unsigned int iClientID, unsigned char *p2, int p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetWeaponGroup", Py_BuildValue("Is#i", iClientID, p2, strlen((char*)p2), p3));
+		PyObject *pPayload = pyPayload(p2, p3);
+		pyCallback("HkCbIServerImpl_SetWeaponGroup", Py_BuildValue("IOi", iClientID, pPayload, p3));
+		pyPayloadRelease(pPayload);
 	}
 	EXPORT void __stdcall SetWeaponGroup_AFTER(unsigned int iClientID, unsigned char *p2, int p3)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_SetWeaponGroup_AFTER", Py_BuildValue("Is#i", iClientID, p2, strlen((char*)p2), p3));
+		PyObject *pPayload = pyPayload(p2, p3);
+		pyCallback("HkCbIServerImpl_SetWeaponGroup_AFTER", Py_BuildValue("IOi", iClientID, pPayload, p3));
+		pyPayloadRelease(pPayload);
 	}
 	EXPORT void __stdcall Shutdown(void)
 	{
 		DEFAULT_CHECK();
 		pyCallback("HkCbIServerImpl_Shutdown", Py_BuildValue("O", Py_True)); // use O not N here we need to increase the ref count
+		AsyncShutdown();
+		StopStores();
+		StopLogging();
 	}
 	EXPORT bool __stdcall Startup(struct SStartupInfo const &p1)
 	{
@@ -968,32 +1380,52 @@ namespace HkIServerImpl
 	EXPORT void __stdcall StopTradeRequest(unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_StopTradeRequest", Py_BuildValue("I", iClientID));
+		pyCallbackBefore(HKP_StopTradeRequest, "HkCbIServerImpl_StopTradeRequest", HookKey(iClientID), Py_BuildValue("I", iClientID));
 	}
 	EXPORT void __stdcall StopTradeRequest_AFTER(unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
-		pyCallback("HkCbIServerImpl_StopTradeRequest_AFTER", Py_BuildValue("I", iClientID));
+		PyObject *pData = pyPairArgs(HKP_StopTradeRequest, HookKey(iClientID));
+		pyCallbackAfter(HKP_StopTradeRequest, "HkCbIServerImpl_StopTradeRequest_AFTER", pData ? pData : Py_BuildValue("I", iClientID));
+	}
+	// the tractored objects are a st6::vector of space ids (pArraySpaceID is its begin, iDunno2 its end), only the
+	// ids go to python, never the pointers. The count is sanity checked, a tractor beam only ever targets a few loot
+	static PyObject* pyTractorIDs(XTractorObjects const &p2)
+	{
+		const uint *pBegin = (const uint*)p2.pArraySpaceID;
+		const uint *pEnd = (const uint*)p2.iDunno2;
+		if (!pBegin || pEnd < pBegin || pEnd - pBegin > 256)
+			return PyTuple_New(0);
+		PyObject *pIDs = PyTuple_New(pEnd - pBegin);
+		for (uint i = 0; pBegin + i < pEnd; i++)
+			PyTuple_SET_ITEM(pIDs, i, PyInt_FromLong(pBegin[i]));
+		return pIDs;
 	}
-	// TBD
 	EXPORT void __stdcall TractorObjects(unsigned int iClientID, struct XTractorObjects const &p2)
 	{
 		DEFAULT_CHECK();
+		static PY_ARGS args;
+		pyCallback("HkCbIServerImpl_TractorObjects", pyTuple(args, pyID(iClientID), pyTractorIDs(p2)));
 	}
-	// TBD
 	EXPORT void __stdcall TractorObjects_AFTER(unsigned int iClientID, struct XTractorObjects const &p2)
 	{
 		DEFAULT_CHECK();
+		static PY_ARGS args;
+		pyCallback("HkCbIServerImpl_TractorObjects_AFTER", pyTuple(args, pyID(iClientID), pyTractorIDs(p2)));
 	}
-	// TBD
 	EXPORT void __stdcall TradeResponse(unsigned char const *p1, int p2, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		PyObject *pPayload = pyPayload(p1, p2);
+		pyCallback("HkCbIServerImpl_TradeResponse", Py_BuildValue("OiI", pPayload, p2, iClientID));
+		pyPayloadRelease(pPayload);
 	}
-	// TBD
 	EXPORT void __stdcall TradeResponse_AFTER(unsigned char const *p1, int p2, unsigned int iClientID)
 	{
 		DEFAULT_CHECK();
+		PyObject *pPayload = pyPayload(p1, p2);
+		pyCallback("HkCbIServerImpl_TradeResponse_AFTER", Py_BuildValue("OiI", pPayload, p2, iClientID));
+		pyPayloadRelease(pPayload);
 	}
 }
 
@@ -1001,11 +1433,14 @@ namespace HkIServerImpl
 EXPORT void ClearClientInfo(uint iClientID)
 {
 	DEFAULT_CHECK();
+	RateLimitClearClient(iClientID);
+	ADMISSION_CHECK(iClientID);
 	pyCallback("ClearClientInfo", Py_BuildValue("I", iClientID));
 }
 EXPORT void LoadUserCharSettings(uint iClientID)
 {
 	DEFAULT_CHECK();
+	ADMISSION_CHECK(iClientID);
 	pyCallback("LoadUserCharSettings", Py_BuildValue("I", iClientID));
 }
 // TBD
@@ -1017,28 +1452,49 @@ EXPORT void __stdcall HkCb_SendChat(uint iClientID, uint iTo, uint iSize, void *
 EXPORT int __stdcall HkCB_MissileTorpHit(char *ECX, char *p1, DamageList *dmg)
 {
 	DEFAULT_CHECK_V(0);
+	if (bDamageBatching)
+		DamageBatchFlush(); // a new resolution starts
 	return 0;
 }
 EXPORT void __stdcall HkCb_AddDmgEntry(DamageList *dmg, unsigned short p1, float p2, enum DamageEntry::SubObjFate p3)
 {
 	DEFAULT_CHECK();
-	pyCallback("HkCb_AddDmgEntry", Py_BuildValue("NHfI", ToPython(dmg), p1, p2, p3));
+	pyPairDrop(HKP_AddDmgEntry);
+	if (KillLedgerPolicy.bEnabled)
+		KillLedgerDamage(dmg, p1, p2);
+	FLHOOK_NATIVE_DMGENTRY nativeDmg = { dmg, p1, p2, (int)p3 };
+	NATIVE_CHECK(FNE_AddDmgEntry, 0, &nativeDmg);
+	if (bDamageBatching) {
+		DamageBatchAdd(dmg, p1, p2, p3);
+		return;
+	}
+	static PY_ARGS args; // dmg goes to python as the live DamageList, so keying on the pointer is right here
+	pyCallbackBefore(HKP_AddDmgEntry, "HkCb_AddDmgEntry", HookKey(dmg, p1, p2, p3), pyTuple(args, ToPython(dmg), pyInt(p1), pyFloat(p2), pyInt(p3)));
 }
 EXPORT void __stdcall HkCb_AddDmgEntry_AFTER(DamageList *dmg, unsigned short p1, float p2, enum DamageEntry::SubObjFate p3)
 {
 	DEFAULT_CHECK();
-	pyCallback("HkCb_AddDmgEntry_AFTER", Py_BuildValue("NHfI", ToPython(dmg), p1, p2, p3));
+	FLHOOK_NATIVE_DMGENTRY nativeDmg = { dmg, p1, p2, (int)p3 };
+	NATIVE_CHECK(FNE_AddDmgEntry_AFTER, 0, &nativeDmg);
+	if (bDamageBatching)
+		return;
+	static PY_ARGS args;
+	PyObject *pData = pyPairArgs(HKP_AddDmgEntry, HookKey(dmg, p1, p2, p3));
+	pyCallbackAfter(HKP_AddDmgEntry, "HkCb_AddDmgEntry_AFTER", pData ? pData : pyTuple(args, ToPython(dmg), pyInt(p1), pyFloat(p2), pyInt(p3)));
 }
 // TBD
 EXPORT void __stdcall HkCb_GeneralDmg(char *szECX)
 {
 	DEFAULT_CHECK();
+	if (bDamageBatching)
+		DamageBatchFlush(); // a new resolution starts
 	//pyCallback("HkCb_GeneralDmg", Py_BuildValue("s", szECX));
 }
 EXPORT bool AllowPlayerDamage(uint iClientID, uint iClientIDTarget)
 {
 	DEFAULT_CHECK_V(true);
-	pyCallback("HkCb_AllowPlayerDamage", Py_BuildValue("II", iClientID, iClientIDTarget));
+	static PY_ARGS args;
+	pyCallback("HkCb_AllowPlayerDamage", pyTuple(args, pyID(iClientID), pyID(iClientIDTarget)));
 	if (returncode != DEFAULT_RETURNCODE)
 		returncode = DEFAULT_RETURNCODE;
 		return false;
@@ -1052,34 +1508,69 @@ EXPORT void SendDeathMsg(const wstring &wscMsg, uint iSystemID, uint iClientIDVi
 EXPORT void __stdcall ShipDestroyed(DamageList *_dmg, DWORD *ecx, uint iKill)
 {
 	DEFAULT_CHECK();
-	pyCallback("ShipDestroyed", Py_BuildValue("NkI", ToPython(_dmg), ecx, iKill));
+	if (bDamageBatching)
+		DamageBatchFlush();
+	static PY_ARGS args;
+	pyCallback("ShipDestroyed", pyTuple(args, ToPython(_dmg), PyLong_FromUnsignedLong((unsigned long)ecx), pyID(iKill)));
+	if (returncode == NOFUNCTIONCALL || returncode == SKIPPLUGINS_NOFUNCTIONCALL)
+		return; // python vetoed it, the ship lives on
+	CShip *cship = (CShip*)ecx[4];
+	if (KillLedgerPolicy.bEnabled)
+		KillLedgerDestroyed(_dmg, cship->get_id(), cship->GetOwnerPlayer(), iKill != 0);
+	ShipRegistryRemove(cship->get_id());
+	if (bChangeFeed && cship->GetOwnerPlayer())
+		ChangeFeedSet(cship->GetOwnerPlayer(), CHG_SHIP, 0);
 }
 EXPORT void BaseDestroyed(uint iObject, uint iClientIDBy)
 {
 	DEFAULT_CHECK();
 	pyCallback("BaseDestroyed", Py_BuildValue("II", iObject, iClientIDBy));
 }
-// TBD
 EXPORT void __stdcall HkIEngine_CShip_init(CShip* ship)
 {
 	DEFAULT_CHECK();
 	returncode = DEFAULT_RETURNCODE;
+	uint iShip = ship->get_id();
+	uint iArchID = ship->shiparch()->iArchID;
+	uint iClientID = ship->GetOwnerPlayer();
+	ShipRegistryAdd(iShip, iArchID, iClientID, ship->iSystem);
+	static PY_ARGS args;
+	if (bShipEvents)
+		pyCallback("HkIEngine_CShip_init", pyTuple(args, pyID(iShip), pyID(iArchID), pyID(iClientID), pyID(ship->iSystem)));
 }
-// TBD
 EXPORT void __stdcall HkIEngine_CShip_destroy(CShip* ship)
 {
 	DEFAULT_CHECK();
 	returncode = DEFAULT_RETURNCODE;
+	uint iShip = ship->get_id();
+	if (bShipEvents)
+		pyCallback("HkIEngine_CShip_destroy", pyID(iShip));
+	ShipRegistryRemove(iShip);
 }
 EXPORT void HkCb_Update_Time(double dInterval)
 {
 	DEFAULT_CHECK();
-	pyCallback("HkCb_Update_Time", Py_BuildValue("d", dInterval));
+	GCTickStart();
+	pyCallback("HkCb_Update_Time", pyFloat(dInterval));
 }
 EXPORT void HkCb_Update_Time_AFTER(double dInterval)
 {
 	DEFAULT_CHECK();
-	pyCallback("HkCb_Update_Time_AFTER", Py_BuildValue("d", dInterval));
+	pyCallback("HkCb_Update_Time_AFTER", pyFloat(dInterval));
+	if (bOutbox)
+		OutboxFlush(0);
+	if (bDamageBatching)
+		DamageBatchFlush();
+	if (KillLedgerPolicy.bEnabled)
+		KillLedgerPrune();
+	if (bChangeFeed)
+		ChangeFeedFlush();
+	AsyncTick();
+	StoreTick();
+	TracebackTick();
+	LogTick();
+	GCTickEnd();
+	LeakTick();
 }
 // TBD
 EXPORT int HkCb_Dock_Call(unsigned int const &uShipID, unsigned int const &uSpaceID, int p3, enum DOCK_HOST_RESPONSE p4)
@@ -1096,12 +1587,12 @@ EXPORT int HkCb_Dock_Call_AFTER(unsigned int const &uShipID, unsigned int const
 EXPORT void __stdcall HkCb_Elapse_Time(float p1)
 {
 	DEFAULT_CHECK();
-	pyCallback("HkCb_Elapse_Time", Py_BuildValue("f", p1));
+	pyCallback("HkCb_Elapse_Time", pyFloat(p1));
 }
 EXPORT void __stdcall HkCb_Elapse_Time_AFTER(float p1)
 {
 	DEFAULT_CHECK();
-	pyCallback("HkCb_Elapse_Time_AFTER", Py_BuildValue("f", p1));
+	pyCallback("HkCb_Elapse_Time_AFTER", pyFloat(p1));
 }
 // TBD
 EXPORT bool __stdcall LaunchPosHook(uint iSpaceID, struct CEqObj &p1, Vector &p2, Matrix &p3, int iDock)
@@ -1128,7 +1619,10 @@ EXPORT void UserCmd_Help(uint iClientID, const wstring &wscParam)
 EXPORT bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
 {
 	DEFAULT_CHECK_V(false);
+	if (RateLimits[RLE_UserCmd].bEnabled && !RateLimitCheck(RLE_UserCmd, iClientID))
+		return returncode != DEFAULT_RETURNCODE; // vetoed commands count as handled
 	pyCallback("UserCmd_Process", Py_BuildValue("IN", iClientID, ToPython(wscCmd)));
+	RATE_CLEAR(RLE_UserCmd, iClientID); // no AFTER hook
 	if (returncode != DEFAULT_RETURNCODE)
 		return true;
 	return false;
@@ -1141,6 +1635,10 @@ EXPORT void CmdHelp_Callback(CCmds* classptr)
 EXPORT bool ExecuteCommandString_Callback(CCmds* classptr, const wstring &wscCmdStr)
 {
 	DEFAULT_CHECK_V(false);
+	if (TracebackAdminCmd(classptr, wscCmdStr)) {
+		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+		return true;
+	}
 	pyCallback("ExecuteCommandString_Callback", Py_BuildValue("ON", Py_None, ToPython(wscCmdStr)));
 	if (returncode != DEFAULT_RETURNCODE)
 		return true;
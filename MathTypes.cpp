@@ -0,0 +1,811 @@
+#include "headers.h"
+#include <vector>
+#include <math.h>
+#include <xmmintrin.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Math types - FLHook.Vec3, FLHook.Quat and FLHook.Mat3 hold their floats natively, so vector math in scripts
+is one C call per operation instead of pure python on boxed floats:
+
+	Vec3 - x, y, z; + - with Vec3, * / with numbers, dot(), cross(), length(), normalized(), distance()
+	Quat - w, x, y, z; Quat * Quat, Quat * Vec3 (rotation), rotate(), conjugate(), to_matrix(),
+		Quat.from_axis_angle()
+	Mat3 - rows of a 3x3 rotation matrix; Mat3 * Mat3, Mat3 * Vec3, transform(), transposed(), to_quat()
+
+All of them take any sequence of the right length where one is expected (the Vector and Quaternion
+namedtuples hooks pass included). The batch kernels (FLHook.Distances etc) work on packed float32 x,y,z
+triples, 4 points at a time with SSE.
+*/
+struct PY_VEC3
+{
+	PyObject_HEAD
+	Vector v;
+};
+
+struct PY_QUAT
+{
+	PyObject_HEAD
+	Quaternion q;
+};
+
+struct PY_MAT3
+{
+	PyObject_HEAD
+	Matrix m;
+};
+
+// Py_RETURN_NOTIMPLEMENTED is 3.x only
+#define RETURN_NOTIMPLEMENTED { Py_INCREF(Py_NotImplemented); return Py_NotImplemented; }
+
+static PyTypeObject Vec3Type = { PyVarObject_HEAD_INIT(NULL, 0) "FLHook.Vec3", sizeof(PY_VEC3) };
+static PyTypeObject QuatType = { PyVarObject_HEAD_INIT(NULL, 0) "FLHook.Quat", sizeof(PY_QUAT) };
+static PyTypeObject Mat3Type = { PyVarObject_HEAD_INIT(NULL, 0) "FLHook.Mat3", sizeof(PY_MAT3) };
+static PyNumberMethods Vec3Number;
+static PyNumberMethods QuatNumber;
+static PyNumberMethods Mat3Number;
+static PySequenceMethods Vec3Sequence;
+static PySequenceMethods QuatSequence;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// plain math on the FL types
+
+static inline float VecDot(const Vector &a, const Vector &b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline Vector VecMake(float x, float y, float z)
+{
+	Vector v;
+	v.x = x;
+	v.y = y;
+	v.z = z;
+	return v;
+}
+
+static inline Vector VecCross(const Vector &a, const Vector &b)
+{
+	return VecMake(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static inline Vector VecScale(const Vector &a, float f)
+{
+	return VecMake(a.x * f, a.y * f, a.z * f);
+}
+
+static inline Quaternion QuatMake(float w, float x, float y, float z)
+{
+	Quaternion q;
+	q.w = w;
+	q.x = x;
+	q.y = y;
+	q.z = z;
+	return q;
+}
+
+static inline Quaternion QuatMul(const Quaternion &a, const Quaternion &b)
+{
+	return QuatMake(
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w);
+}
+
+static inline Vector QuatRotate(const Quaternion &q, const Vector &v)
+{
+	// v + w*t + u x t with t = 2 * (u x v), u the vector part
+	Vector u = VecMake(q.x, q.y, q.z);
+	Vector t = VecScale(VecCross(u, v), 2.0f);
+	Vector c = VecCross(u, t);
+	return VecMake(v.x + q.w * t.x + c.x, v.y + q.w * t.y + c.y, v.z + q.w * t.z + c.z);
+}
+
+static Matrix QuatToMatrix(const Quaternion &q)
+{
+	Matrix m;
+	m.data[0][0] = 1 - 2 * (q.y * q.y + q.z * q.z);
+	m.data[0][1] = 2 * (q.x * q.y - q.w * q.z);
+	m.data[0][2] = 2 * (q.x * q.z + q.w * q.y);
+	m.data[1][0] = 2 * (q.x * q.y + q.w * q.z);
+	m.data[1][1] = 1 - 2 * (q.x * q.x + q.z * q.z);
+	m.data[1][2] = 2 * (q.y * q.z - q.w * q.x);
+	m.data[2][0] = 2 * (q.x * q.z - q.w * q.y);
+	m.data[2][1] = 2 * (q.y * q.z + q.w * q.x);
+	m.data[2][2] = 1 - 2 * (q.x * q.x + q.y * q.y);
+	return m;
+}
+
+static Quaternion MatrixToQuat(const Matrix &m)
+{
+	float fTrace = m.data[0][0] + m.data[1][1] + m.data[2][2];
+	if (fTrace > 0) {
+		float s = sqrtf(fTrace + 1.0f) * 2;
+		return QuatMake(0.25f * s, (m.data[2][1] - m.data[1][2]) / s, (m.data[0][2] - m.data[2][0]) / s, (m.data[1][0] - m.data[0][1]) / s);
+	}
+	if (m.data[0][0] > m.data[1][1] && m.data[0][0] > m.data[2][2]) {
+		float s = sqrtf(1.0f + m.data[0][0] - m.data[1][1] - m.data[2][2]) * 2;
+		return QuatMake((m.data[2][1] - m.data[1][2]) / s, 0.25f * s, (m.data[0][1] + m.data[1][0]) / s, (m.data[0][2] + m.data[2][0]) / s);
+	}
+	if (m.data[1][1] > m.data[2][2]) {
+		float s = sqrtf(1.0f + m.data[1][1] - m.data[0][0] - m.data[2][2]) * 2;
+		return QuatMake((m.data[0][2] - m.data[2][0]) / s, (m.data[0][1] + m.data[1][0]) / s, 0.25f * s, (m.data[1][2] + m.data[2][1]) / s);
+	}
+	float s = sqrtf(1.0f + m.data[2][2] - m.data[0][0] - m.data[1][1]) * 2;
+	return QuatMake((m.data[1][0] - m.data[0][1]) / s, (m.data[0][2] + m.data[2][0]) / s, (m.data[1][2] + m.data[2][1]) / s, 0.25f * s);
+}
+
+static inline Vector MatrixTransform(const Matrix &m, const Vector &v)
+{
+	return VecMake(
+		m.data[0][0] * v.x + m.data[0][1] * v.y + m.data[0][2] * v.z,
+		m.data[1][0] * v.x + m.data[1][1] * v.y + m.data[1][2] * v.z,
+		m.data[2][0] * v.x + m.data[2][1] * v.y + m.data[2][2] * v.z);
+}
+
+static Matrix MatrixMul(const Matrix &a, const Matrix &b)
+{
+	Matrix m;
+	for (uint i = 0; i < 3; i++) {
+		for (uint j = 0; j < 3; j++)
+			m.data[i][j] = a.data[i][0] * b.data[0][j] + a.data[i][1] * b.data[1][j] + a.data[i][2] * b.data[2][j];
+	}
+	return m;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// conversions
+
+static bool pyToFloats(PyObject *pObj, float *pFloats, Py_ssize_t iCount, const char *szError)
+{
+	PyObject *pSeq = PySequence_Fast(pObj, szError);
+	if (!pSeq)
+		return false;
+	if (PySequence_Fast_GET_SIZE(pSeq) != iCount) {
+		Py_DECREF(pSeq);
+		PyErr_SetString(PyExc_TypeError, szError);
+		return false;
+	}
+	for (Py_ssize_t i = 0; i < iCount; i++) {
+		pFloats[i] = (float)PyFloat_AsDouble(PySequence_Fast_GET_ITEM(pSeq, i));
+		if (PyErr_Occurred()) {
+			Py_DECREF(pSeq);
+			return false;
+		}
+	}
+	Py_DECREF(pSeq);
+	return true;
+}
+
+bool pyToVector(PyObject *pObj, Vector &v)
+{
+	if (PyObject_TypeCheck(pObj, &Vec3Type)) {
+		v = ((PY_VEC3*)pObj)->v;
+		return true;
+	}
+	float f[3];
+	if (!pyToFloats(pObj, f, 3, "expected a Vec3 or a sequence of 3 numbers"))
+		return false;
+	v = VecMake(f[0], f[1], f[2]);
+	return true;
+}
+
+static bool pyToQuat(PyObject *pObj, Quaternion &q)
+{
+	if (PyObject_TypeCheck(pObj, &QuatType)) {
+		q = ((PY_QUAT*)pObj)->q;
+		return true;
+	}
+	float f[4];
+	if (!pyToFloats(pObj, f, 4, "expected a Quat or a sequence of 4 numbers (w, x, y, z)"))
+		return false;
+	q = QuatMake(f[0], f[1], f[2], f[3]);
+	return true;
+}
+
+static bool pyToMatrix(PyObject *pObj, Matrix &m)
+{
+	if (PyObject_TypeCheck(pObj, &Mat3Type)) {
+		m = ((PY_MAT3*)pObj)->m;
+		return true;
+	}
+	PyObject *pSeq = PySequence_Fast(pObj, "expected a Mat3 or 3 rows of 3 numbers");
+	if (!pSeq)
+		return false;
+	bool bOK = PySequence_Fast_GET_SIZE(pSeq) == 3;
+	for (uint i = 0; bOK && i < 3; i++)
+		bOK = pyToFloats(PySequence_Fast_GET_ITEM(pSeq, i), m.data[i], 3, "expected a Mat3 or 3 rows of 3 numbers");
+	Py_DECREF(pSeq);
+	if (!bOK && !PyErr_Occurred())
+		PyErr_SetString(PyExc_TypeError, "expected a Mat3 or 3 rows of 3 numbers");
+	return bOK;
+}
+
+PyObject* pyVec3(const Vector &v)
+{
+	PY_VEC3 *self = PyObject_New(PY_VEC3, &Vec3Type);
+	if (self)
+		self->v = v;
+	return (PyObject*)self;
+}
+
+static PyObject* pyQuat(const Quaternion &q)
+{
+	PY_QUAT *self = PyObject_New(PY_QUAT, &QuatType);
+	if (self)
+		self->q = q;
+	return (PyObject*)self;
+}
+
+static PyObject* pyMat3(const Matrix &m)
+{
+	PY_MAT3 *self = PyObject_New(PY_MAT3, &Mat3Type);
+	if (self)
+		self->m = m;
+	return (PyObject*)self;
+}
+
+// packed float32 triples from anything with a (read) buffer, or a sequence of vectors which is packed here
+bool pyToPoints(PyObject *pObj, vector<float> &vStorage, const float *&pPoints, uint &iCount)
+{
+	const void *pBuf;
+	Py_ssize_t iLen;
+	if (!PySequence_Check(pObj) || PyObject_CheckReadBuffer(pObj)) {
+		if (PyObject_AsReadBuffer(pObj, &pBuf, &iLen) < 0)
+			return false;
+		if (iLen % (3 * sizeof(float))) {
+			PyErr_SetString(PyExc_ValueError, "points buffer must hold float32 x, y, z triples");
+			return false;
+		}
+		pPoints = (const float*)pBuf;
+		iCount = iLen / (3 * sizeof(float));
+		return true;
+	}
+	PyObject *pSeq = PySequence_Fast(pObj, "points must be a buffer or a sequence of vectors");
+	if (!pSeq)
+		return false;
+	iCount = PySequence_Fast_GET_SIZE(pSeq);
+	vStorage.resize(iCount * 3);
+	for (uint i = 0; i < iCount; i++) {
+		Vector v;
+		if (!pyToVector(PySequence_Fast_GET_ITEM(pSeq, i), v)) {
+			Py_DECREF(pSeq);
+			return false;
+		}
+		vStorage[i * 3] = v.x;
+		vStorage[i * 3 + 1] = v.y;
+		vStorage[i * 3 + 2] = v.z;
+	}
+	Py_DECREF(pSeq);
+	pPoints = iCount ? &vStorage[0] : NULL;
+	return true;
+}
+
+static PyObject* pyFloatsRepr(const char *szType, const float *pFloats, uint iCount)
+{
+	char szBuf[256];
+	int iPos = snprintf(szBuf, sizeof(szBuf), "%s(", szType);
+	for (uint i = 0; i < iCount; i++)
+		iPos += snprintf(szBuf + iPos, sizeof(szBuf) - iPos, i ? ", %g" : "%g", pFloats[i]);
+	snprintf(szBuf + iPos, sizeof(szBuf) - iPos, ")");
+	return PyString_FromString(szBuf);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Vec3
+
+static PyObject* Vec3_new(PyTypeObject *pType, PyObject *pArgs, PyObject *pKwds)
+{
+	Vector v = VecMake(0, 0, 0);
+	if (PyTuple_GET_SIZE(pArgs) == 1) {
+		if (!pyToVector(PyTuple_GET_ITEM(pArgs, 0), v))
+			return NULL;
+	}
+	else if (!PyArg_ParseTuple(pArgs, "|fff", &v.x, &v.y, &v.z)) {
+		return NULL;
+	}
+	return pyVec3(v);
+}
+
+static PyObject* Vec3_getattr(PY_VEC3 *self, void *pClosure)
+{
+	return PyFloat_FromDouble((&self->v.x)[(size_t)pClosure]);
+}
+
+static int Vec3_setattr(PY_VEC3 *self, PyObject *pValue, void *pClosure)
+{
+	if (!pValue) {
+		PyErr_SetString(PyExc_TypeError, "can not delete vector components");
+		return -1;
+	}
+	float f = (float)PyFloat_AsDouble(pValue);
+	if (PyErr_Occurred())
+		return -1;
+	(&self->v.x)[(size_t)pClosure] = f;
+	return 0;
+}
+
+static PyObject* Vec3_repr(PY_VEC3 *self)
+{
+	return pyFloatsRepr("Vec3", &self->v.x, 3);
+}
+
+static PyObject* Vec3_add(PyObject *a, PyObject *b)
+{
+	Vector va, vb;
+	if (!pyToVector(a, va) || !pyToVector(b, vb)) {
+		PyErr_Clear();
+		RETURN_NOTIMPLEMENTED;
+	}
+	return pyVec3(VecMake(va.x + vb.x, va.y + vb.y, va.z + vb.z));
+}
+
+static PyObject* Vec3_sub(PyObject *a, PyObject *b)
+{
+	Vector va, vb;
+	if (!pyToVector(a, va) || !pyToVector(b, vb)) {
+		PyErr_Clear();
+		RETURN_NOTIMPLEMENTED;
+	}
+	return pyVec3(VecMake(va.x - vb.x, va.y - vb.y, va.z - vb.z));
+}
+
+static PyObject* Vec3_mul(PyObject *a, PyObject *b)
+{
+	if (PyObject_TypeCheck(b, &Vec3Type)) { // number * Vec3
+		PyObject *t = a;
+		a = b;
+		b = t;
+	}
+	if (!PyObject_TypeCheck(a, &Vec3Type) || !PyNumber_Check(b))
+		RETURN_NOTIMPLEMENTED;
+	float f = (float)PyFloat_AsDouble(b);
+	if (PyErr_Occurred())
+		return NULL;
+	return pyVec3(VecScale(((PY_VEC3*)a)->v, f));
+}
+
+static PyObject* Vec3_div(PyObject *a, PyObject *b)
+{
+	if (!PyObject_TypeCheck(a, &Vec3Type) || !PyNumber_Check(b))
+		RETURN_NOTIMPLEMENTED;
+	float f = (float)PyFloat_AsDouble(b);
+	if (PyErr_Occurred())
+		return NULL;
+	if (f == 0) {
+		PyErr_SetString(PyExc_ZeroDivisionError, "vector division by zero");
+		return NULL;
+	}
+	return pyVec3(VecScale(((PY_VEC3*)a)->v, 1.0f / f));
+}
+
+static PyObject* Vec3_neg(PY_VEC3 *self)
+{
+	return pyVec3(VecScale(self->v, -1.0f));
+}
+
+static PyObject* Vec3_richcompare(PyObject *a, PyObject *b, int iOp)
+{
+	Vector va, vb;
+	if ((iOp != Py_EQ && iOp != Py_NE) || !pyToVector(a, va) || !pyToVector(b, vb)) {
+		PyErr_Clear();
+		RETURN_NOTIMPLEMENTED;
+	}
+	bool bEqual = va.x == vb.x && va.y == vb.y && va.z == vb.z;
+	return PyBool_FromLong(iOp == Py_EQ ? bEqual : !bEqual);
+}
+
+static Py_ssize_t Vec3_length(PyObject *self)
+{
+	return 3;
+}
+
+static PyObject* Vec3_item(PY_VEC3 *self, Py_ssize_t i)
+{
+	if (i < 0 || i >= 3) {
+		PyErr_SetString(PyExc_IndexError, "Vec3 index out of range");
+		return NULL;
+	}
+	return PyFloat_FromDouble((&self->v.x)[i]);
+}
+
+static PyObject* Vec3_dot(PY_VEC3 *self, PyObject *pOther)
+{
+	Vector v;
+	if (!pyToVector(pOther, v))
+		return NULL;
+	return PyFloat_FromDouble(VecDot(self->v, v));
+}
+
+static PyObject* Vec3_cross(PY_VEC3 *self, PyObject *pOther)
+{
+	Vector v;
+	if (!pyToVector(pOther, v))
+		return NULL;
+	return pyVec3(VecCross(self->v, v));
+}
+
+static PyObject* Vec3_len(PY_VEC3 *self, PyObject *pArgs)
+{
+	return PyFloat_FromDouble(sqrtf(VecDot(self->v, self->v)));
+}
+
+static PyObject* Vec3_len_sq(PY_VEC3 *self, PyObject *pArgs)
+{
+	return PyFloat_FromDouble(VecDot(self->v, self->v));
+}
+
+static PyObject* Vec3_normalized(PY_VEC3 *self, PyObject *pArgs)
+{
+	float fLen = sqrtf(VecDot(self->v, self->v));
+	return pyVec3(fLen > 0 ? VecScale(self->v, 1.0f / fLen) : self->v);
+}
+
+static PyObject* Vec3_distance(PY_VEC3 *self, PyObject *pOther)
+{
+	Vector v;
+	if (!pyToVector(pOther, v))
+		return NULL;
+	Vector d = VecMake(self->v.x - v.x, self->v.y - v.y, self->v.z - v.z);
+	return PyFloat_FromDouble(sqrtf(VecDot(d, d)));
+}
+
+static PyMethodDef Vec3Methods[] = {
+	{ "dot", (PyCFunction)Vec3_dot, METH_O, "float dot(Vec3 other)" },
+	{ "cross", (PyCFunction)Vec3_cross, METH_O, "Vec3 cross(Vec3 other)" },
+	{ "length", (PyCFunction)Vec3_len, METH_NOARGS, "float length()" },
+	{ "length_sq", (PyCFunction)Vec3_len_sq, METH_NOARGS, "float length_sq()" },
+	{ "normalized", (PyCFunction)Vec3_normalized, METH_NOARGS, "Vec3 normalized()" },
+	{ "distance", (PyCFunction)Vec3_distance, METH_O, "float distance(Vec3 other)" },
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyGetSetDef Vec3GetSet[] = {
+	{ "x", (getter)Vec3_getattr, (setter)Vec3_setattr, NULL, (void*)0 },
+	{ "y", (getter)Vec3_getattr, (setter)Vec3_setattr, NULL, (void*)1 },
+	{ "z", (getter)Vec3_getattr, (setter)Vec3_setattr, NULL, (void*)2 },
+	{ NULL, NULL, NULL, NULL, NULL }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Quat
+
+static PyObject* Quat_new(PyTypeObject *pType, PyObject *pArgs, PyObject *pKwds)
+{
+	Quaternion q = QuatMake(1, 0, 0, 0);
+	if (PyTuple_GET_SIZE(pArgs) == 1) {
+		if (!pyToQuat(PyTuple_GET_ITEM(pArgs, 0), q))
+			return NULL;
+	}
+	else if (!PyArg_ParseTuple(pArgs, "|ffff", &q.w, &q.x, &q.y, &q.z)) {
+		return NULL;
+	}
+	return pyQuat(q);
+}
+
+static PyObject* Quat_getattr(PY_QUAT *self, void *pClosure)
+{
+	return PyFloat_FromDouble((&self->q.w)[(size_t)pClosure]);
+}
+
+static int Quat_setattr(PY_QUAT *self, PyObject *pValue, void *pClosure)
+{
+	if (!pValue) {
+		PyErr_SetString(PyExc_TypeError, "can not delete quaternion components");
+		return -1;
+	}
+	float f = (float)PyFloat_AsDouble(pValue);
+	if (PyErr_Occurred())
+		return -1;
+	(&self->q.w)[(size_t)pClosure] = f;
+	return 0;
+}
+
+static PyObject* Quat_repr(PY_QUAT *self)
+{
+	return pyFloatsRepr("Quat", &self->q.w, 4);
+}
+
+static PyObject* Quat_mul(PyObject *a, PyObject *b)
+{
+	if (!PyObject_TypeCheck(a, &QuatType))
+		RETURN_NOTIMPLEMENTED;
+	if (PyObject_TypeCheck(b, &Vec3Type))
+		return pyVec3(QuatRotate(((PY_QUAT*)a)->q, ((PY_VEC3*)b)->v));
+	Quaternion q;
+	if (!pyToQuat(b, q)) {
+		PyErr_Clear();
+		RETURN_NOTIMPLEMENTED;
+	}
+	return pyQuat(QuatMul(((PY_QUAT*)a)->q, q));
+}
+
+static Py_ssize_t Quat_length(PyObject *self)
+{
+	return 4;
+}
+
+static PyObject* Quat_item(PY_QUAT *self, Py_ssize_t i)
+{
+	if (i < 0 || i >= 4) {
+		PyErr_SetString(PyExc_IndexError, "Quat index out of range");
+		return NULL;
+	}
+	return PyFloat_FromDouble((&self->q.w)[i]);
+}
+
+static PyObject* Quat_rotate(PY_QUAT *self, PyObject *pVec)
+{
+	Vector v;
+	if (!pyToVector(pVec, v))
+		return NULL;
+	return pyVec3(QuatRotate(self->q, v));
+}
+
+static PyObject* Quat_conjugate(PY_QUAT *self, PyObject *pArgs)
+{
+	return pyQuat(QuatMake(self->q.w, -self->q.x, -self->q.y, -self->q.z));
+}
+
+static PyObject* Quat_normalized(PY_QUAT *self, PyObject *pArgs)
+{
+	const Quaternion &q = self->q;
+	float fLen = sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+	if (fLen <= 0)
+		return pyQuat(QuatMake(1, 0, 0, 0));
+	return pyQuat(QuatMake(q.w / fLen, q.x / fLen, q.y / fLen, q.z / fLen));
+}
+
+static PyObject* Quat_to_matrix(PY_QUAT *self, PyObject *pArgs)
+{
+	return pyMat3(QuatToMatrix(self->q));
+}
+
+static PyObject* Quat_from_axis_angle(PyObject *pClass, PyObject *pArgs)
+{
+	PyObject *pAxis;
+	float fAngle;
+	if (!PyArg_ParseTuple(pArgs, "Of", &pAxis, &fAngle))
+		return NULL;
+	Vector v;
+	if (!pyToVector(pAxis, v))
+		return NULL;
+	float fLen = sqrtf(VecDot(v, v));
+	if (fLen <= 0) {
+		PyErr_SetString(PyExc_ValueError, "axis has no length");
+		return NULL;
+	}
+	float s = sinf(fAngle / 2) / fLen;
+	return pyQuat(QuatMake(cosf(fAngle / 2), v.x * s, v.y * s, v.z * s));
+}
+
+static PyMethodDef QuatMethods[] = {
+	{ "rotate", (PyCFunction)Quat_rotate, METH_O, "Vec3 rotate(Vec3 v)" },
+	{ "conjugate", (PyCFunction)Quat_conjugate, METH_NOARGS, "Quat conjugate()" },
+	{ "normalized", (PyCFunction)Quat_normalized, METH_NOARGS, "Quat normalized()" },
+	{ "to_matrix", (PyCFunction)Quat_to_matrix, METH_NOARGS, "Mat3 to_matrix()" },
+	{ "from_axis_angle", (PyCFunction)Quat_from_axis_angle, METH_VARARGS | METH_CLASS, "Quat from_axis_angle(Vec3 axis, float radians)" },
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyGetSetDef QuatGetSet[] = {
+	{ "w", (getter)Quat_getattr, (setter)Quat_setattr, NULL, (void*)0 },
+	{ "x", (getter)Quat_getattr, (setter)Quat_setattr, NULL, (void*)1 },
+	{ "y", (getter)Quat_getattr, (setter)Quat_setattr, NULL, (void*)2 },
+	{ "z", (getter)Quat_getattr, (setter)Quat_setattr, NULL, (void*)3 },
+	{ NULL, NULL, NULL, NULL, NULL }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Mat3
+
+static PyObject* Mat3_new(PyTypeObject *pType, PyObject *pArgs, PyObject *pKwds)
+{
+	Matrix m;
+	PyObject *pRows = NULL;
+	if (!PyArg_ParseTuple(pArgs, "|O", &pRows))
+		return NULL;
+	if (pRows)
+		return pyToMatrix(pRows, m) ? pyMat3(m) : NULL;
+	for (uint i = 0; i < 3; i++) {
+		for (uint j = 0; j < 3; j++)
+			m.data[i][j] = i == j ? 1.0f : 0.0f;
+	}
+	return pyMat3(m);
+}
+
+static PyObject* Mat3_repr(PY_MAT3 *self)
+{
+	return pyFloatsRepr("Mat3", &self->m.data[0][0], 9);
+}
+
+static PyObject* Mat3_mul(PyObject *a, PyObject *b)
+{
+	if (!PyObject_TypeCheck(a, &Mat3Type))
+		RETURN_NOTIMPLEMENTED;
+	if (PyObject_TypeCheck(b, &Vec3Type))
+		return pyVec3(MatrixTransform(((PY_MAT3*)a)->m, ((PY_VEC3*)b)->v));
+	Matrix m;
+	if (!pyToMatrix(b, m)) {
+		PyErr_Clear();
+		RETURN_NOTIMPLEMENTED;
+	}
+	return pyMat3(MatrixMul(((PY_MAT3*)a)->m, m));
+}
+
+static PyObject* Mat3_transform(PY_MAT3 *self, PyObject *pVec)
+{
+	Vector v;
+	if (!pyToVector(pVec, v))
+		return NULL;
+	return pyVec3(MatrixTransform(self->m, v));
+}
+
+static PyObject* Mat3_transposed(PY_MAT3 *self, PyObject *pArgs)
+{
+	Matrix m;
+	for (uint i = 0; i < 3; i++) {
+		for (uint j = 0; j < 3; j++)
+			m.data[i][j] = self->m.data[j][i];
+	}
+	return pyMat3(m);
+}
+
+static PyObject* Mat3_to_quat(PY_MAT3 *self, PyObject *pArgs)
+{
+	return pyQuat(MatrixToQuat(self->m));
+}
+
+static PyObject* Mat3_rows(PY_MAT3 *self, void *pClosure)
+{
+	const Matrix &m = self->m;
+	return Py_BuildValue("((fff)(fff)(fff))", m.data[0][0], m.data[0][1], m.data[0][2],
+		m.data[1][0], m.data[1][1], m.data[1][2], m.data[2][0], m.data[2][1], m.data[2][2]);
+}
+
+static PyMethodDef Mat3Methods[] = {
+	{ "transform", (PyCFunction)Mat3_transform, METH_O, "Vec3 transform(Vec3 v)" },
+	{ "transposed", (PyCFunction)Mat3_transposed, METH_NOARGS, "Mat3 transposed()" },
+	{ "to_quat", (PyCFunction)Mat3_to_quat, METH_NOARGS, "Quat to_quat()" },
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyGetSetDef Mat3GetSet[] = {
+	{ "rows", (getter)Mat3_rows, NULL, "tuple of the 3 rows", NULL },
+	{ NULL, NULL, NULL, NULL, NULL }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// batch kernels, pPoints is iCount packed x,y,z float triples
+
+/*
+4 points are loaded as 4 overlapping rows of 4 floats (the 4th being the next points x) and transposed to
+xxxx yyyy zzzz. The last row reads one float past the 4 points, so the SSE loops stop while at least one
+more point follows and the rest is done one by one.
+*/
+#define LOAD_POINTS4(p, x, y, z) \
+	__m128 x = _mm_loadu_ps(p), y = _mm_loadu_ps(p + 3), z = _mm_loadu_ps(p + 6), w = _mm_loadu_ps(p + 9); \
+	_MM_TRANSPOSE4_PS(x, y, z, w)
+
+void MathDistances(const Vector &vFrom, const float *pPoints, uint iCount, float *pOut)
+{
+	__m128 fx = _mm_set1_ps(vFrom.x), fy = _mm_set1_ps(vFrom.y), fz = _mm_set1_ps(vFrom.z);
+	uint i = 0;
+	for (; i + 4 < iCount; i += 4) {
+		LOAD_POINTS4(pPoints + i * 3, x, y, z);
+		x = _mm_sub_ps(x, fx);
+		y = _mm_sub_ps(y, fy);
+		z = _mm_sub_ps(z, fz);
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		_mm_storeu_ps(pOut + i, _mm_sqrt_ps(d));
+	}
+	for (; i < iCount; i++) {
+		const float *p = pPoints + i * 3;
+		Vector d = VecMake(p[0] - vFrom.x, p[1] - vFrom.y, p[2] - vFrom.z);
+		pOut[i] = sqrtf(VecDot(d, d));
+	}
+}
+
+uint MathWithinRange(const Vector &vFrom, float fRange, const float *pPoints, uint iCount, vector<uint> &vIndices)
+{
+	__m128 fx = _mm_set1_ps(vFrom.x), fy = _mm_set1_ps(vFrom.y), fz = _mm_set1_ps(vFrom.z);
+	__m128 r2 = _mm_set1_ps(fRange * fRange);
+	uint i = 0;
+	for (; i + 4 < iCount; i += 4) {
+		LOAD_POINTS4(pPoints + i * 3, x, y, z);
+		x = _mm_sub_ps(x, fx);
+		y = _mm_sub_ps(y, fy);
+		z = _mm_sub_ps(z, fz);
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		int iMask = _mm_movemask_ps(_mm_cmple_ps(d, r2));
+		for (uint j = 0; iMask; j++, iMask >>= 1) {
+			if (iMask & 1)
+				vIndices.push_back(i + j);
+		}
+	}
+	for (; i < iCount; i++) {
+		const float *p = pPoints + i * 3;
+		Vector d = VecMake(p[0] - vFrom.x, p[1] - vFrom.y, p[2] - vFrom.z);
+		if (VecDot(d, d) <= fRange * fRange)
+			vIndices.push_back(i);
+	}
+	return vIndices.size();
+}
+
+// pOut may not be pPoints, the stores overlap into the next point
+void MathNormalize(const float *pPoints, uint iCount, float *pOut)
+{
+	__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	uint i = 0;
+	for (; i + 4 < iCount; i += 4) {
+		LOAD_POINTS4(pPoints + i * 3, x, y, z);
+		__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		__m128 nonzero = _mm_cmpgt_ps(len, zero);
+		__m128 inv = _mm_or_ps(_mm_and_ps(nonzero, _mm_div_ps(one, len)), _mm_andnot_ps(nonzero, one)); // 0 length stays 0
+		x = _mm_mul_ps(x, inv);
+		y = _mm_mul_ps(y, inv);
+		z = _mm_mul_ps(z, inv);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		float *o = pOut + i * 3;
+		_mm_storeu_ps(o, x);
+		_mm_storeu_ps(o + 3, y);
+		_mm_storeu_ps(o + 6, z);
+		_mm_storeu_ps(o + 9, w); // 4th float is the next points x, written again below
+	}
+	for (; i < iCount; i++) {
+		const float *p = pPoints + i * 3;
+		Vector v = VecMake(p[0], p[1], p[2]);
+		float fLen = sqrtf(VecDot(v, v));
+		float fInv = fLen > 0 ? 1.0f / fLen : 1.0f;
+		pOut[i * 3] = v.x * fInv;
+		pOut[i * 3 + 1] = v.y * fInv;
+		pOut[i * 3 + 2] = v.z * fInv;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool InitType(PyObject *pHook, PyTypeObject &type, const char *szName, const char *szDoc, newfunc fnNew,
+	reprfunc fnRepr, PyMethodDef *pMethods, PyGetSetDef *pGetSet, PyNumberMethods *pNumber, PySequenceMethods *pSequence)
+{
+	type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_CHECKTYPES;
+	type.tp_doc = szDoc;
+	type.tp_new = fnNew;
+	type.tp_repr = fnRepr;
+	type.tp_methods = pMethods;
+	type.tp_getset = pGetSet;
+	type.tp_as_number = pNumber;
+	type.tp_as_sequence = pSequence;
+	type.tp_hash = PyObject_HashNotImplemented; // mutable
+	if (PyType_Ready(&type) < 0)
+		return false;
+	Py_INCREF(&type);
+	PyModule_AddObject(pHook, szName, (PyObject*)&type); // reference stealer
+	return true;
+}
+
+void InitMathTypes(PyObject *pHook)
+{
+	Vec3Number.nb_add = Vec3_add;
+	Vec3Number.nb_subtract = Vec3_sub;
+	Vec3Number.nb_multiply = Vec3_mul;
+	Vec3Number.nb_divide = Vec3_div;
+	Vec3Number.nb_true_divide = Vec3_div;
+	Vec3Number.nb_negative = (unaryfunc)Vec3_neg;
+	Vec3Sequence.sq_length = Vec3_length;
+	Vec3Sequence.sq_item = (ssizeargfunc)Vec3_item;
+	Vec3Type.tp_richcompare = Vec3_richcompare;
+	InitType(pHook, Vec3Type, "Vec3", "Vec3(x=0, y=0, z=0) or Vec3(sequence)", Vec3_new,
+		(reprfunc)Vec3_repr, Vec3Methods, Vec3GetSet, &Vec3Number, &Vec3Sequence);
+
+	QuatNumber.nb_multiply = Quat_mul;
+	QuatSequence.sq_length = Quat_length;
+	QuatSequence.sq_item = (ssizeargfunc)Quat_item;
+	InitType(pHook, QuatType, "Quat", "Quat(w=1, x=0, y=0, z=0) or Quat(sequence)", Quat_new,
+		(reprfunc)Quat_repr, QuatMethods, QuatGetSet, &QuatNumber, &QuatSequence);
+
+	Mat3Number.nb_multiply = Mat3_mul;
+	InitType(pHook, Mat3Type, "Mat3", "Mat3() for the identity or Mat3(rows)", Mat3_new,
+		(reprfunc)Mat3_repr, Mat3Methods, Mat3GetSet, &Mat3Number, NULL);
+}
@@ -0,0 +1,127 @@
+#include "headers.h"
+#include <map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Message templates - HkFMsg style xml registered once with FLHook.RegisterMessageTemplate() and named
+placeholders ({name}) in it. The template is split into the literal xml between placeholders when it's
+registered (and checked to encode), so sending only has to escape the parameters and join them into a buffer
+reserved at the right size. The result is encoded once and sent with HkFMsgSendChat to every recipient,
+rather then HkFMsg encoding it again per player.
+*/
+struct MSG_TEMPLATE
+{
+	vector<wstring> vLiterals; // one more then vSlots, the xml before, between and after the placeholders
+	vector<string> vSlots; // placeholder names
+	size_t iLiteralLength;
+};
+
+static map<string, MSG_TEMPLATE> mapTemplates;
+
+static bool IsSlotChar(wchar_t wc)
+{
+	return (wc >= L'a' && wc <= L'z') || (wc >= L'A' && wc <= L'Z') || (wc >= L'0' && wc <= L'9') || wc == L'_';
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool MessageTemplateRegister(const string &scName, const wstring &wscXML)
+{
+	MSG_TEMPLATE tmpl;
+	tmpl.iLiteralLength = 0;
+	wstring wscLiteral;
+	for (size_t i = 0; i < wscXML.length(); i++) {
+		if (wscXML[i] == L'{') {
+			size_t iEnd = i + 1;
+			while (iEnd < wscXML.length() && IsSlotChar(wscXML[iEnd]))
+				iEnd++;
+			if (iEnd < wscXML.length() && iEnd > i + 1 && wscXML[iEnd] == L'}') {
+				tmpl.vLiterals.push_back(wscLiteral);
+				tmpl.iLiteralLength += wscLiteral.length();
+				tmpl.vSlots.push_back(wstos(wscXML.substr(i + 1, iEnd - i - 1)));
+				wscLiteral.clear();
+				i = iEnd;
+				continue;
+			}
+		}
+		wscLiteral += wscXML[i]; // braces that arent a placeholder stay as they are
+	}
+	tmpl.vLiterals.push_back(wscLiteral);
+	tmpl.iLiteralLength += wscLiteral.length();
+
+	// the xml has to encode with empty parameters, so sending can only fail on the parameters
+	wstring wscEmpty;
+	for (uint i = 0; i < tmpl.vLiterals.size(); i++)
+		wscEmpty += tmpl.vLiterals[i];
+	char szBuf[0xFFFF];
+	uint iRet;
+	if (HkFMsgEncodeXML(wscEmpty, szBuf, sizeof(szBuf), iRet) != HKE_OK)
+		return false;
+
+	mapTemplates[scName] = tmpl;
+	return true;
+}
+
+bool MessageTemplateRemove(const string &scName)
+{
+	return mapTemplates.erase(scName) > 0;
+}
+
+// pParams is a dict of placeholder name to value, missing ones are left empty
+bool MessageTemplateRender(const string &scName, PyObject *pParams, wstring &wscXML)
+{
+	map<string, MSG_TEMPLATE>::iterator it = mapTemplates.find(scName);
+	if (it == mapTemplates.end())
+		return false;
+	MSG_TEMPLATE &tmpl = it->second;
+
+	vector<wstring> vValues(tmpl.vSlots.size());
+	size_t iLength = tmpl.iLiteralLength;
+	for (uint i = 0; i < tmpl.vSlots.size(); i++) {
+		PyObject *pValue = pParams ? PyDict_GetItemString(pParams, tmpl.vSlots[i].c_str()) : NULL; // borrowed
+		if (!pValue)
+			continue;
+		vValues[i] = XMLText(pyunitows(pValue));
+		iLength += vValues[i].length();
+	}
+
+	wscXML.clear();
+	wscXML.reserve(iLength);
+	for (uint i = 0; i < tmpl.vSlots.size(); i++) {
+		wscXML += tmpl.vLiterals[i];
+		wscXML += vValues[i];
+	}
+	wscXML += tmpl.vLiterals.back();
+	return true;
+}
+
+// lstClients empty for everyone in game, returns the number of players sent to or -1 if it didnt encode
+int MessageTemplateSend(const wstring &wscXML, const list<uint> &lstClients)
+{
+	if (bOutbox && lstClients.size() == 1)
+		return OutboxQueue(lstClients.front(), wscXML) == HKE_OK ? 1 : -1;
+
+	char szBuf[0xFFFF];
+	uint iRet;
+	if (HkFMsgEncodeXML(wscXML, szBuf, sizeof(szBuf), iRet) != HKE_OK)
+		return -1;
+
+	int iSent = 0;
+	if (lstClients.empty()) {
+		for (uint iClientID = 1; iClientID <= MAX_CLIENT_ID; iClientID++) {
+			if (!HkIsValidClientID(iClientID) || HkIsInCharSelectMenu(iClientID))
+				continue;
+			HkFMsgSendChat(iClientID, szBuf, iRet);
+			iSent++;
+		}
+		return iSent;
+	}
+	for (list<uint>::const_iterator it = lstClients.begin(); it != lstClients.end(); ++it) {
+		if (!HkIsValidClientID(*it))
+			continue;
+		HkFMsgSendChat(*it, szBuf, iRet);
+		iSent++;
+	}
+	return iSent;
+}
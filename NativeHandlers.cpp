@@ -0,0 +1,106 @@
+#include "headers.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Native handlers - for the hottest events (SPObjUpdate, FireWeapon, AddDmgEntry) even a cheap python call
+costs too much. A compiled extension can export a FLHOOK_NATIVE_HANDLER_INFO capsule (see FLHookNative.h)
+that scripts register with FLHook.SetNativeHandler(). The hook then calls the C function with the raw hook
+data and only calls python as well when the handler returns FNR_PYTHON. The handlers returncode is set first,
+python only overrides it by returning 1-3 (pyCallback leaves returncode alone for any other result).
+
+A handler that faults (an access violation or any other structured exception, a C++ exception included) is
+unregistered and the event goes back to python. That only protects the hook call, a handler that corrupted
+memory before faulting can still bring the server down later.
+*/
+NATIVE_HANDLER NativeHandlers[FNE_COUNT];
+
+static const char *NativeEventNames[FNE_COUNT] = {
+	"HkCbIServerImpl_SPObjUpdate",
+	"HkCbIServerImpl_SPObjUpdate_AFTER",
+	"HkCbIServerImpl_FireWeapon",
+	"HkCbIServerImpl_FireWeapon_AFTER",
+	"HkCb_AddDmgEntry",
+	"HkCb_AddDmgEntry_AFTER"
+};
+
+int GetNativeEvent(const string &scEvent)
+{
+	for (int i = 0; i < FNE_COUNT; i++) {
+		if (scEvent == NativeEventNames[i])
+			return i;
+	}
+	return -1;
+}
+
+const char* GetNativeEventName(int iEvent)
+{
+	return NativeEventNames[iEvent];
+}
+
+void SetNativeHandler(int iEvent, PyObject *pCapsule)
+{
+	NATIVE_HANDLER &native = NativeHandlers[iEvent];
+	Py_XDECREF(native.pCapsule); // the capsule keeps the extension (and so pInfo) alive
+	native.pCapsule = NULL;
+	native.pInfo = NULL;
+	native.iCalls = 0;
+	native.iPython = 0;
+	if (pCapsule == NULL)
+		return;
+
+	Py_INCREF(pCapsule);
+	native.pCapsule = pCapsule;
+	native.pInfo = (FLHOOK_NATIVE_HANDLER_INFO*)PyCapsule_GetPointer(pCapsule, FLHOOK_NATIVE_CAPSULE);
+}
+
+void ClearNativeHandlers()
+{
+	for (int i = 0; i < FNE_COUNT; i++)
+		SetNativeHandler(i, NULL);
+}
+
+// catch (...) doesn't see access violations with /EHsc, so the call is wrapped in SEH. It needs a function of
+// its own, __try can't be used in one with objects to unwind
+static bool CallNativeGuarded(FLHOOK_NATIVE_HANDLER pHandler, const FLHOOK_NATIVE_CONTEXT *pCtx, void *pData, int &iResult, DWORD &dwCode)
+{
+	__try {
+		iResult = pHandler(pCtx, pData);
+		return true;
+	}
+	__except (dwCode = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {
+		return false;
+	}
+}
+
+bool CallNative(FLHOOK_NATIVE_EVENT iEvent, uint iClientID, void *pData)
+{
+	NATIVE_HANDLER &native = NativeHandlers[iEvent];
+	FLHOOK_NATIVE_CONTEXT ctx = { FLHOOK_NATIVE_ABI_VERSION, sizeof(FLHOOK_NATIVE_CONTEXT), (uint)iEvent, iClientID, native.pInfo->pUserData };
+	int iResult = 0;
+	DWORD dwCode = 0;
+	if (!CallNativeGuarded(native.pInfo->pHandler, &ctx, pData, iResult, dwCode)) {
+		wchar_t wszCode[16];
+		swprintf(wszCode, 16, L"0x%08X", dwCode);
+		ERRMSG(L"ERROR Exception " + wstring(wszCode) + L" in native handler (" + stows(NativeEventNames[iEvent]) + L"), handler removed");
+		SetNativeHandler(iEvent, NULL);
+		return true;
+	}
+	native.iCalls++;
+
+	switch (iResult & ~FNR_PYTHON) {
+	case FNR_SKIPPLUGINS:
+		returncode = SKIPPLUGINS;
+		break;
+	case FNR_SKIPPLUGINS_NOFUNCTIONCALL:
+		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+		break;
+	case FNR_NOFUNCTIONCALL:
+		returncode = NOFUNCTIONCALL;
+		break;
+	}
+	if (iResult & FNR_PYTHON) {
+		native.iPython++;
+		return true;
+	}
+	return false;
+}
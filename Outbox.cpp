@@ -0,0 +1,95 @@
+#include "headers.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Outbox - with FLHook.SetOutbox(True) the messages scripts send to single clients (PrintUserCmdText, HkMsg and
+HkFMsg) are not sent right away but queued per client as xml, and everything queued for a client during the
+tick goes out as one message (the parts joined with <PARA/>) at the end of it. A help text of 20 lines is
+then 1 encoded chat packet instead of 20.
+
+A client's queue is sent early when it would grow past OUTBOX_MAX_XML, and scripts can send it themselves
+with FLHook.FlushOutbox(). Messages to a client are always delivered in the order they were queued.
+
+Every message is encoded once when it's queued, so bad xml raises in the script that sent it (like HkFMsg
+does without the outbox) instead of taking down the whole joined message of that client at the end of the tick.
+*/
+bool bOutbox = false;
+OUTBOX_STATS OutboxStats;
+
+#define OUTBOX_MAX_XML 0x800 // characters of xml per message
+#define OUTBOX_MSG_STYLE L"0x19BD3A00" // what HkMsg uses
+
+static wstring OutboxXML[MAX_CLIENT_ID + 1];
+static list<uint> lstOutboxPending; // clients with something queued, in queue order
+
+static void OutboxSend(uint iClientID)
+{
+	wstring &wscXML = OutboxXML[iClientID];
+	if (wscXML.empty())
+		return;
+	HK_ERROR hkErr = HkFMsg(iClientID, wscXML);
+	if (hkErr != HKE_OK) {
+		ERRMSG(L"ERROR outbox message to client " + to_wstring(iClientID) + L" not sent: " + HkErrGetText(hkErr));
+	}
+	else {
+		OutboxStats.iSent++;
+	}
+	wscXML.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// HKE_OK if queued, the error of encoding wscXML otherwise (nothing is queued then)
+HK_ERROR OutboxQueue(uint iClientID, const wstring &wscXML)
+{
+	if (!iClientID || iClientID > MAX_CLIENT_ID)
+		return HkFMsg(iClientID, wscXML);
+	char szBuf[0xFFFF];
+	uint iRet;
+	HK_ERROR hkErr = HkFMsgEncodeXML(wscXML, szBuf, sizeof(szBuf), iRet);
+	if (hkErr != HKE_OK)
+		return hkErr;
+	wstring &wscQueued = OutboxXML[iClientID];
+	if (!wscQueued.empty() && wscQueued.length() + wscXML.length() + 7 > OUTBOX_MAX_XML)
+		OutboxSend(iClientID); // still on lstOutboxPending, which is fine for an empty queue
+
+	if (wscQueued.empty())
+		lstOutboxPending.push_back(iClientID);
+	else
+		wscQueued += L"<PARA/>";
+	wscQueued += wscXML;
+	OutboxStats.iQueued++;
+	return HKE_OK;
+}
+
+HK_ERROR OutboxQueueText(uint iClientID, const wstring &wscText, bool bUserCmd)
+{
+	return OutboxQueue(iClientID, L"<TRA data=\"" + (bUserCmd ? set_wscUserCmdStyle : wstring(OUTBOX_MSG_STYLE)) +
+		L"\" mask=\"-1\"/><TEXT>" + XMLText(wscText) + L"</TEXT>");
+}
+
+void OutboxFlush(uint iClientID)
+{
+	if (iClientID) {
+		if (iClientID <= MAX_CLIENT_ID)
+			OutboxSend(iClientID);
+		return;
+	}
+	while (!lstOutboxPending.empty()) {
+		OutboxSend(lstOutboxPending.front());
+		lstOutboxPending.pop_front();
+	}
+}
+
+void OutboxClearClient(uint iClientID)
+{
+	if (iClientID <= MAX_CLIENT_ID)
+		OutboxXML[iClientID].clear(); // the entry on lstOutboxPending sends nothing now
+}
+
+void SetOutbox(bool bEnabled)
+{
+	if (!bEnabled)
+		OutboxFlush(0);
+	bOutbox = bEnabled;
+}
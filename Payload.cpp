@@ -0,0 +1,191 @@
+#include "headers.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Payload views - some hooks get a raw binary blob (the visited state, weapon groups, trade responses). Rather
+then copying it into a str (and cutting it at the first NUL like the old Py_BuildValue("s#") did), the
+callback gets a FLHook.Payload: a read only view of the hooks own memory, supporting len(), indexing,
+slicing and the buffer protocol (memoryview(), struct.unpack_from(), ...).
+
+The memory belongs to the server and is only valid during the callback; pyPayloadRelease() detaches the view
+afterwards. Use payload.copy() to keep the data around. A memoryview can outlive the callback, so a new style
+buffer is exported from a private copy the payload makes on the first export and frees with itself (new
+exports still fail after the callback, like everything else). Indexing, slicing and old style buffers, which
+check the payload on every access, stay zero copy.
+*/
+struct PY_PAYLOAD
+{
+	PyObject_HEAD
+	const unsigned char *pData; // NULL once released
+	Py_ssize_t iSize;
+	unsigned char *pCopy; // what new style buffers point at, made on the first export
+};
+
+static bool PayloadValid(PY_PAYLOAD *self)
+{
+	if (self->pData != NULL)
+		return true;
+	PyErr_SetString(PyExc_ValueError, "payload used outside of its callback, use payload.copy()");
+	return false;
+}
+
+static PyObject* Payload_copy(PY_PAYLOAD *self, PyObject *pArgs)
+{
+	if (!PayloadValid(self))
+		return NULL;
+	return PyString_FromStringAndSize((const char*)self->pData, self->iSize);
+}
+
+static PyObject* Payload_valid(PY_PAYLOAD *self, void *pClosure)
+{
+	return PyBool_FromLong(self->pData != NULL);
+}
+
+static Py_ssize_t Payload_length(PY_PAYLOAD *self)
+{
+	return self->iSize;
+}
+
+static PyObject* Payload_subscript(PY_PAYLOAD *self, PyObject *pKey)
+{
+	if (!PayloadValid(self))
+		return NULL;
+	if (PyIndex_Check(pKey)) {
+		Py_ssize_t i = PyNumber_AsSsize_t(pKey, PyExc_IndexError);
+		if (i == -1 && PyErr_Occurred())
+			return NULL;
+		if (i < 0)
+			i += self->iSize;
+		if (i < 0 || i >= self->iSize) {
+			PyErr_SetString(PyExc_IndexError, "payload index out of range");
+			return NULL;
+		}
+		return PyInt_FromLong(self->pData[i]);
+	}
+	if (PySlice_Check(pKey)) {
+		Py_ssize_t iStart, iStop, iStep, iLength;
+		if (PySlice_GetIndicesEx((PySliceObject*)pKey, self->iSize, &iStart, &iStop, &iStep, &iLength) < 0)
+			return NULL;
+		if (iStep == 1)
+			return PyString_FromStringAndSize((const char*)self->pData + iStart, iLength);
+		PyObject *pResult = PyString_FromStringAndSize(NULL, iLength);
+		if (pResult == NULL)
+			return NULL;
+		char *szResult = PyString_AS_STRING(pResult);
+		for (Py_ssize_t i = 0; i < iLength; i++, iStart += iStep)
+			szResult[i] = self->pData[iStart];
+		return pResult;
+	}
+	PyErr_SetString(PyExc_TypeError, "payload indices must be integers or slices");
+	return NULL;
+}
+
+static int Payload_getbuffer(PY_PAYLOAD *self, Py_buffer *view, int iFlags)
+{
+	if (!PayloadValid(self))
+		return -1;
+	if (!self->pCopy) {
+		self->pCopy = (unsigned char*)PyMem_Malloc(self->iSize ? self->iSize : 1);
+		if (!self->pCopy) {
+			PyErr_NoMemory();
+			return -1;
+		}
+		memcpy(self->pCopy, self->pData, self->iSize);
+	}
+	return PyBuffer_FillInfo(view, (PyObject*)self, self->pCopy, self->iSize, 1, iFlags);
+}
+
+static void Payload_dealloc(PY_PAYLOAD *self)
+{
+	PyMem_Free(self->pCopy);
+	PyObject_Del(self);
+}
+
+// old style buffers for the 2.x modules that still use them
+static Py_ssize_t Payload_getreadbuf(PY_PAYLOAD *self, Py_ssize_t iSegment, void **pPtr)
+{
+	if (iSegment != 0) {
+		PyErr_SetString(PyExc_SystemError, "accessing non-existent payload segment");
+		return -1;
+	}
+	if (!PayloadValid(self))
+		return -1;
+	*pPtr = (void*)self->pData;
+	return self->iSize;
+}
+
+static Py_ssize_t Payload_getsegcount(PY_PAYLOAD *self, Py_ssize_t *pLen)
+{
+	if (pLen)
+		*pLen = self->iSize;
+	return 1;
+}
+
+static PyMethodDef PayloadMethods[] = {
+	{ "copy", (PyCFunction)Payload_copy, METH_NOARGS, "str data = copy()" },
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyGetSetDef PayloadGetSet[] = {
+	{ "valid", (getter)Payload_valid, NULL, "False once the callback returned", NULL },
+	{ NULL, NULL, NULL, NULL, NULL }
+};
+
+static PyMappingMethods PayloadMapping = {
+	(lenfunc)Payload_length,
+	(binaryfunc)Payload_subscript,
+	NULL
+};
+
+static PyBufferProcs PayloadBuffer = {
+	(readbufferproc)Payload_getreadbuf,
+	NULL, // not writeable
+	(segcountproc)Payload_getsegcount,
+	(charbufferproc)Payload_getreadbuf,
+	(getbufferproc)Payload_getbuffer,
+	NULL
+};
+
+static PyTypeObject PayloadType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	"FLHook.Payload", // tp_name
+	sizeof(PY_PAYLOAD), // tp_basicsize
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void InitPayloadType(PyObject *pHook)
+{
+	PayloadType.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER;
+	PayloadType.tp_dealloc = (destructor)Payload_dealloc;
+	PayloadType.tp_doc = "read only view of a hooks binary data, only valid during the callback";
+	PayloadType.tp_as_mapping = &PayloadMapping;
+	PayloadType.tp_as_buffer = &PayloadBuffer;
+	PayloadType.tp_methods = PayloadMethods;
+	PayloadType.tp_getset = PayloadGetSet;
+	if (PyType_Ready(&PayloadType) < 0)
+		return;
+	Py_INCREF(&PayloadType);
+	PyModule_AddObject(pHook, "Payload", (PyObject*)&PayloadType); // reference stealer
+}
+
+PyObject* pyPayload(const void *pData, uint iSize)
+{
+	PY_PAYLOAD *pPayload = PyObject_New(PY_PAYLOAD, &PayloadType);
+	if (pPayload == NULL)
+		return NULL;
+	pPayload->pData = pData ? (const unsigned char*)pData : (const unsigned char*)"";
+	pPayload->iSize = pData ? iSize : 0;
+	pPayload->pCopy = NULL;
+	return (PyObject*)pPayload;
+}
+
+void pyPayloadRelease(PyObject *pPayload)
+{
+	if (pPayload == NULL)
+		return;
+	PY_PAYLOAD *self = (PY_PAYLOAD*)pPayload;
+	self->pData = NULL;
+	self->iSize = 0;
+	Py_DECREF(pPayload);
+}
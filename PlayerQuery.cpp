@@ -0,0 +1,100 @@
+#include "headers.h"
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Player query - FLHook.GetAllPlayers() walks FL's active player list once and returns only the fields asked
+for, as columns: a dict of field name to a tuple with one value per player, all in the same order. With
+packed=True the numeric columns are bytearrays of packed uint32s instead of tuples of ints, scripts that want
+numbers back use array.array('I', str(column)).
+
+A scoreboard or status export makes one call for everyone instead of several Hk calls per client id, and
+fields that cost something to get (the ip address goes through the network layer) are only looked up when
+they're asked for.
+*/
+static const char *PlayerFieldNames[PQF_COUNT] = {
+	"client_id",
+	"charname",
+	"system",
+	"base",
+	"ship",
+	"ship_arch",
+	"ip",
+	"hostname",
+};
+
+#define PQF_NUMERIC(f) (f != PQF_CHARNAME && f != PQF_IP && f != PQF_HOSTNAME)
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int PlayerFieldByName(const char *szName)
+{
+	for (int i = 0; i < PQF_COUNT; i++) {
+		if (!strcmp(PlayerFieldNames[i], szName))
+			return i;
+	}
+	return -1;
+}
+
+PyObject* PlayerQuery(const list<int> &lstFields, bool bPacked)
+{
+	// one pass over the player list, numbers and strings collected per field
+	vector<uint> vNumbers[PQF_COUNT];
+	vector<wstring> vStrings[PQF_COUNT];
+	bool bWanted[PQF_COUNT] = { false };
+	for (list<int>::const_iterator it = lstFields.begin(); it != lstFields.end(); ++it)
+		bWanted[*it] = true;
+
+	struct PlayerData *pPD = 0;
+	while ((pPD = Players.traverse_active(pPD))) {
+		uint iClientID = pPD->iOnlineID;
+		if (HkIsInCharSelectMenu(iClientID))
+			continue;
+		if (bWanted[PQF_CLIENT_ID])
+			vNumbers[PQF_CLIENT_ID].push_back(iClientID);
+		if (bWanted[PQF_CHARNAME]) {
+			const wchar_t *wszCharname = Players.GetActiveCharacterName(iClientID);
+			vStrings[PQF_CHARNAME].push_back(wszCharname ? wszCharname : L"");
+		}
+		if (bWanted[PQF_SYSTEM])
+			vNumbers[PQF_SYSTEM].push_back(pPD->iSystemID);
+		if (bWanted[PQF_BASE])
+			vNumbers[PQF_BASE].push_back(pPD->iBaseID);
+		if (bWanted[PQF_SHIP])
+			vNumbers[PQF_SHIP].push_back(pPD->iShipID);
+		if (bWanted[PQF_SHIP_ARCH])
+			vNumbers[PQF_SHIP_ARCH].push_back(pPD->iShipArchetype);
+		if (bWanted[PQF_IP]) {
+			wstring wscIP;
+			HkGetPlayerIP(iClientID, wscIP);
+			vStrings[PQF_IP].push_back(wscIP);
+		}
+		if (bWanted[PQF_HOSTNAME])
+			vStrings[PQF_HOSTNAME].push_back(ClientInfo[iClientID].wscHostname);
+	}
+
+	PyObject *pResult = PyDict_New();
+	for (int i = 0; i < PQF_COUNT; i++) {
+		if (!bWanted[i])
+			continue;
+		PyObject *pColumn;
+		if (!PQF_NUMERIC(i)) {
+			pColumn = PyTuple_New(vStrings[i].size());
+			for (uint j = 0; j < vStrings[i].size(); j++)
+				PyTuple_SET_ITEM(pColumn, j, PyString_FromString(wstos(vStrings[i][j]).c_str()));
+		}
+		else if (bPacked) {
+			pColumn = PyByteArray_FromStringAndSize(NULL, vNumbers[i].size() * sizeof(uint));
+			if (pColumn && !vNumbers[i].empty())
+				memcpy(PyByteArray_AS_STRING(pColumn), &vNumbers[i][0], vNumbers[i].size() * sizeof(uint));
+		}
+		else {
+			pColumn = PyTuple_New(vNumbers[i].size());
+			for (uint j = 0; j < vNumbers[i].size(); j++)
+				PyTuple_SET_ITEM(pColumn, j, PyInt_FromSize_t(vNumbers[i][j]));
+		}
+		PyDict_SetItemString(pResult, PlayerFieldNames[i], pColumn);
+		Py_XDECREF(pColumn);
+	}
+	return pResult;
+}
@@ -0,0 +1,198 @@
+#include "headers.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Rate limiter - spam protection without a python call per chat line or command. FLHook.SetRateLimit() puts a
+token bucket per client on one of the RATE_EVENTs (refilled at fRate tokens per second, holding at most
+fBurst). The hook checks it before dispatching (RATE_CHECK); once a client runs out of tokens the event is:
+
+	RLA_DROP - not sent to python (BEFORE and AFTER), the server call still happens
+	RLA_VETO - not sent to python and the server call is blocked (NOFUNCTIONCALL)
+	RLA_FLAG - sent to python as usual, FLHook.IsRateLimited() returns True in its BEFORE and AFTER callbacks
+
+The flag is kept per event and client and cleared at the end of the AFTER hook (RATE_CLEAR).
+
+Scripts get custom buckets and cooldowns keyed by (key, client) through FLHook.RateLimit() and
+FLHook.Cooldown(), both kept in a small flat array of slots per client (RATE_SLOTS). When all slots of a
+client are in use the one that expires first is reused.
+*/
+RATE_LIMIT RateLimits[RLE_COUNT];
+
+static const char *RateEventNames[RLE_COUNT] = {
+	"HkCbIServerImpl_SubmitChat",
+	"UserCmd_Process",
+	"HkCbIServerImpl_RequestEvent",
+	"HkCbIServerImpl_InitiateTrade"
+};
+
+struct RATE_BUCKET
+{
+	float fTokens;
+	mstime tmLast;
+};
+
+struct RATE_SLOT
+{
+	uint iKey; // 0 for a free slot
+	RATE_BUCKET bucket; // for RateLimit(), tmLast is the cooldown end for Cooldown()
+};
+
+static RATE_BUCKET EventBuckets[RLE_COUNT][MAX_CLIENT_ID + 1];
+static RATE_SLOT ClientSlots[MAX_CLIENT_ID + 1][RATE_SLOTS];
+
+// FNV-1a, the low bit tells cooldowns and buckets apart so the same key can be used for both
+static uint RateKey(const char *szKey, bool bCooldown)
+{
+	uint iHash = 2166136261u;
+	for (; *szKey; szKey++)
+		iHash = (iHash ^ (unsigned char)*szKey) * 16777619u;
+	iHash = (iHash & ~1u) | (bCooldown ? 1 : 0);
+	return iHash ? iHash : 2;
+}
+
+static bool RateTake(RATE_BUCKET &bucket, float fRate, float fBurst, mstime tmNow)
+{
+	if (bucket.tmLast == 0) { // first use, start full
+		bucket.fTokens = fBurst;
+	}
+	else {
+		bucket.fTokens += (float)(tmNow - bucket.tmLast) * fRate / 1000.0f;
+		if (bucket.fTokens > fBurst)
+			bucket.fTokens = fBurst;
+	}
+	bucket.tmLast = tmNow;
+	if (bucket.fTokens < 1.0f)
+		return false;
+	bucket.fTokens -= 1.0f;
+	return true;
+}
+
+static RATE_SLOT& RateSlot(uint iClientID, uint iKey, bool &bNew)
+{
+	RATE_SLOT *slots = ClientSlots[iClientID];
+	RATE_SLOT *pReuse = NULL;
+	for (uint i = 0; i < RATE_SLOTS; i++) {
+		if (slots[i].iKey == iKey) {
+			bNew = false;
+			return slots[i];
+		}
+		if (slots[i].iKey == 0) {
+			if (pReuse == NULL || pReuse->iKey != 0)
+				pReuse = &slots[i];
+		}
+		else if (pReuse == NULL || (pReuse->iKey != 0 && slots[i].bucket.tmLast < pReuse->bucket.tmLast)) {
+			pReuse = &slots[i];
+		}
+	}
+	bNew = true;
+	pReuse->iKey = iKey;
+	pReuse->bucket.fTokens = 0;
+	pReuse->bucket.tmLast = 0;
+	return *pReuse;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int GetRateEvent(const string &scEvent)
+{
+	for (int i = 0; i < RLE_COUNT; i++) {
+		if (scEvent == RateEventNames[i])
+			return i;
+	}
+	return -1;
+}
+
+const char* GetRateEventName(int iEvent)
+{
+	return RateEventNames[iEvent];
+}
+
+void SetRateLimit(RATE_EVENT event, float fRate, float fBurst, RATE_ACTION action)
+{
+	RATE_LIMIT &limit = RateLimits[event];
+	limit.bEnabled = fRate > 0;
+	limit.fRate = fRate;
+	limit.fBurst = fBurst < 1.0f ? 1.0f : fBurst;
+	limit.action = action;
+	limit.iLimited = 0;
+	memset(EventBuckets[event], 0, sizeof(EventBuckets[event]));
+	memset(limit.bDropped, 0, sizeof(limit.bDropped));
+	memset(limit.bFlagged, 0, sizeof(limit.bFlagged));
+}
+
+bool RateLimitCheck(RATE_EVENT event, uint iClientID)
+{
+	RATE_LIMIT &limit = RateLimits[event];
+	if (iClientID > MAX_CLIENT_ID)
+		return true;
+	limit.bDropped[iClientID] = false;
+	limit.bFlagged[iClientID] = false;
+	limit.iClientID = iClientID;
+	if (RateTake(EventBuckets[event][iClientID], limit.fRate, limit.fBurst, timeInMS()))
+		return true;
+
+	limit.iLimited++;
+	switch (limit.action) {
+	case RLA_FLAG:
+		limit.bFlagged[iClientID] = true;
+		return true;
+	case RLA_VETO:
+		returncode = NOFUNCTIONCALL;
+		break;
+	case RLA_DROP:
+		break;
+	}
+	limit.bDropped[iClientID] = true;
+	return false;
+}
+
+// is szEvent (a BEFORE, _AFTER or _FUSED callback of a RATE_EVENT) over its RLA_FLAG limit for the client checked
+bool RateLimitFlagged(const char *szEvent)
+{
+	if (szEvent == NULL)
+		return false;
+	string scEvent = szEvent;
+	if (scEvent.length() > 6 && (scEvent.substr(scEvent.length() - 6) == "_AFTER" || scEvent.substr(scEvent.length() - 6) == "_FUSED"))
+		scEvent.erase(scEvent.length() - 6);
+	int iEvent = GetRateEvent(scEvent);
+	if (iEvent < 0)
+		return false;
+	RATE_LIMIT &limit = RateLimits[iEvent];
+	return limit.bEnabled && limit.iClientID <= MAX_CLIENT_ID && limit.bFlagged[limit.iClientID];
+}
+
+bool RateLimitCustom(uint iClientID, const char *szKey, float fRate, float fBurst)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return true;
+	mstime tmNow = timeInMS();
+	bool bNew;
+	RATE_SLOT &slot = RateSlot(iClientID, RateKey(szKey, false), bNew);
+	return RateTake(slot.bucket, fRate, fBurst < 1.0f ? 1.0f : fBurst, tmNow);
+}
+
+uint RateCooldown(uint iClientID, const char *szKey, uint iMS)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return 0;
+	mstime tmNow = timeInMS();
+	bool bNew;
+	RATE_SLOT &slot = RateSlot(iClientID, RateKey(szKey, true), bNew);
+	if (!bNew && slot.bucket.tmLast > tmNow)
+		return (uint)(slot.bucket.tmLast - tmNow);
+	slot.bucket.tmLast = tmNow + iMS;
+	return 0;
+}
+
+void RateLimitClearClient(uint iClientID)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return;
+	for (uint i = 0; i < RLE_COUNT; i++) {
+		EventBuckets[i][iClientID].fTokens = 0;
+		EventBuckets[i][iClientID].tmLast = 0;
+		RateLimits[i].bDropped[iClientID] = false;
+		RateLimits[i].bFlagged[iClientID] = false;
+	}
+	memset(ClientSlots[iClientID], 0, sizeof(ClientSlots[iClientID]));
+}
@@ -0,0 +1,244 @@
+#include "headers.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Sequence tracking - a player to player trade runs through InitiateTrade, Add/DelTradeEquip, SetTradeMoney,
+AcceptTrade and TerminateTrade, and a launch through LocationExit, BaseExit, PlayerLaunch and LaunchComplete,
+all of them with BEFORE/AFTER callbacks. With FLHook.SetSequenceTracking(True) we follow these per client
+(from the AFTER hooks, so only calls that went through count) and send one event for the outcome:
+
+	TradeCompleted - (client_id1, client_id2, manifest1, money1, manifest2, money2, duration_ms)
+		manifests are tuples of (arch_id, count) offered by that client
+	LaunchSequenceCompleted - (client_id, base_id, ship_id, timings)
+		timings is a dict of ms since the first step for the steps seen ('location_exit', 'base_exit',
+		'player_launch', 'launch_complete')
+
+With outcomes_only the calls that belong to a sequence we're tracking aren't sent to python: Add/DelTradeEquip,
+SetTradeMoney, AcceptTrade and TerminateTrade of a client in a trade, and PlayerLaunch and LaunchComplete of a
+client that left a base. The calls starting a sequence (RequestTrade, InitiateTrade, LocationExit, BaseExit...)
+and every call outside of one still are; the hook pairs themselves are never muted. The BEFORE hook decides for
+the pair, so a call is either sent with its _AFTER or not at all.
+*/
+bool bSequenceTracking = false;
+static bool bSequenceOutcomesOnly = false;
+
+struct TRADE_ITEM
+{
+	ushort sID;
+	uint iArchID;
+	int iCount;
+};
+
+struct TRADE_STATE
+{
+	bool bActive;
+	uint iPartner;
+	mstime tmStart;
+	list<TRADE_ITEM> lstItems;
+	unsigned long iMoney;
+};
+
+enum LAUNCH_STEP
+{
+	LS_LocationExit,
+	LS_BaseExit,
+	LS_PlayerLaunch,
+	LS_LaunchComplete,
+	LS_COUNT
+};
+
+#define LAUNCH_MAX_MS 60000 // steps older then this dont belong to the launch
+
+static const char *LaunchStepNames[LS_COUNT] = { "location_exit", "base_exit", "player_launch", "launch_complete" };
+
+struct LAUNCH_STATE
+{
+	uint iBaseID;
+	uint iShip;
+	mstime tmSteps[LS_COUNT]; // 0 if not seen
+};
+
+static TRADE_STATE TradeStates[MAX_CLIENT_ID + 1];
+static LAUNCH_STATE LaunchStates[MAX_CLIENT_ID + 1];
+
+static void LaunchStep(uint iClientID, LAUNCH_STEP step)
+{
+	LaunchStates[iClientID].tmSteps[step] = timeInMS();
+}
+
+// the client launching iShip, 0 if we didnt see the launch start
+static uint LaunchClient(uint iShip)
+{
+	if (!iShip)
+		return 0;
+	for (uint iClientID = 1; iClientID <= MAX_CLIENT_ID; iClientID++) {
+		if (LaunchStates[iClientID].iShip == iShip)
+			return iClientID;
+	}
+	return 0;
+}
+
+static PyObject* TradeManifest(TRADE_STATE &trade)
+{
+	PyObject *pManifest = PyTuple_New(trade.lstItems.size());
+	uint i = 0;
+	for (list<TRADE_ITEM>::iterator it = trade.lstItems.begin(); it != trade.lstItems.end(); ++it, ++i)
+		PyTuple_SET_ITEM(pManifest, i, Py_BuildValue("(Ii)", it->iArchID, it->iCount));
+	return pManifest;
+}
+
+static void TradeClear(uint iClientID)
+{
+	TradeStates[iClientID].bActive = false;
+	TradeStates[iClientID].lstItems.clear();
+	TradeStates[iClientID].iMoney = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SetSequenceTracking(bool bEnabled, bool bOutcomesOnly)
+{
+	bSequenceTracking = bEnabled;
+	bSequenceOutcomesOnly = bEnabled && bOutcomesOnly;
+	if (!bEnabled)
+		SequenceClearClient(0);
+}
+
+void SequenceClearClient(uint iClientID)
+{
+	if (iClientID == 0) { // everyone
+		for (uint i = 1; i <= MAX_CLIENT_ID; i++)
+			SequenceClearClient(i);
+		return;
+	}
+	if (iClientID > MAX_CLIENT_ID)
+		return;
+	TradeClear(iClientID);
+	memset(&LaunchStates[iClientID], 0, sizeof(LAUNCH_STATE));
+}
+
+void SequenceInitiateTrade(uint iClientID1, uint iClientID2)
+{
+	if (iClientID1 > MAX_CLIENT_ID || iClientID2 > MAX_CLIENT_ID)
+		return;
+	mstime tmNow = timeInMS();
+	TradeClear(iClientID1);
+	TradeClear(iClientID2);
+	TradeStates[iClientID1].bActive = TradeStates[iClientID2].bActive = true;
+	TradeStates[iClientID1].iPartner = iClientID2;
+	TradeStates[iClientID2].iPartner = iClientID1;
+	TradeStates[iClientID1].tmStart = TradeStates[iClientID2].tmStart = tmNow;
+}
+
+void SequenceTradeEquip(uint iClientID, const EquipDesc &ed, bool bAdd)
+{
+	if (iClientID > MAX_CLIENT_ID || !TradeStates[iClientID].bActive)
+		return;
+	list<TRADE_ITEM> &lstItems = TradeStates[iClientID].lstItems;
+	for (list<TRADE_ITEM>::iterator it = lstItems.begin(); it != lstItems.end(); ++it) {
+		if (it->sID != ed.sID || it->iArchID != ed.iArchID)
+			continue;
+		it->iCount += bAdd ? ed.iCount : -(int)ed.iCount;
+		if (it->iCount <= 0)
+			lstItems.erase(it);
+		return;
+	}
+	if (bAdd) {
+		TRADE_ITEM item = { ed.sID, ed.iArchID, (int)ed.iCount };
+		lstItems.push_back(item);
+	}
+}
+
+void SequenceTradeMoney(uint iClientID, unsigned long iMoney)
+{
+	if (iClientID <= MAX_CLIENT_ID && TradeStates[iClientID].bActive)
+		TradeStates[iClientID].iMoney = iMoney;
+}
+
+void SequenceTerminateTrade(uint iClientID, int iAccepted)
+{
+	if (iClientID > MAX_CLIENT_ID || !TradeStates[iClientID].bActive)
+		return;
+	uint iPartner = TradeStates[iClientID].iPartner;
+	if (iAccepted && iPartner <= MAX_CLIENT_ID && TradeStates[iPartner].bActive) {
+		TRADE_STATE &trade1 = TradeStates[iClientID];
+		TRADE_STATE &trade2 = TradeStates[iPartner];
+		pyCallback("TradeCompleted", Py_BuildValue("IINkNkK", iClientID, iPartner,
+			TradeManifest(trade1), trade1.iMoney, TradeManifest(trade2), trade2.iMoney, timeInMS() - trade1.tmStart));
+	}
+	TradeClear(iClientID);
+	if (iPartner <= MAX_CLIENT_ID)
+		TradeClear(iPartner);
+}
+
+void SequenceLocationExit(uint iClientID)
+{
+	if (iClientID <= MAX_CLIENT_ID)
+		LaunchStep(iClientID, LS_LocationExit);
+}
+
+void SequenceBaseExit(uint iBaseID, uint iClientID)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return;
+	LaunchStates[iClientID].iBaseID = iBaseID;
+	LaunchStep(iClientID, LS_BaseExit);
+}
+
+void SequencePlayerLaunch(uint iShip, uint iClientID)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return;
+	LaunchStates[iClientID].iShip = iShip;
+	LaunchStep(iClientID, LS_PlayerLaunch);
+}
+
+void SequenceLaunchComplete(uint iBaseID, uint iShip)
+{
+	uint iClientID = LaunchClient(iShip);
+	if (!iClientID)
+		return; // npc or a launch we didnt see start
+
+	LAUNCH_STATE &launch = LaunchStates[iClientID];
+	LaunchStep(iClientID, LS_LaunchComplete);
+	mstime tmComplete = launch.tmSteps[LS_LaunchComplete];
+	for (uint i = 0; i < LS_COUNT; i++) {
+		if (launch.tmSteps[i] && (launch.tmSteps[i] > tmComplete || tmComplete - launch.tmSteps[i] > LAUNCH_MAX_MS))
+			launch.tmSteps[i] = 0; // left over from an earlier visit
+	}
+	mstime tmFirst = tmComplete; // only after the old steps are gone, mstime is unsigned
+	for (uint i = 0; i < LS_COUNT; i++) {
+		if (launch.tmSteps[i] && launch.tmSteps[i] < tmFirst)
+			tmFirst = launch.tmSteps[i];
+	}
+
+	PyObject *pTimings = PyDict_New();
+	for (uint i = 0; i < LS_COUNT; i++) {
+		if (!launch.tmSteps[i])
+			continue;
+		PyObject *pTime = PyLong_FromUnsignedLongLong(launch.tmSteps[i] - tmFirst);
+		PyDict_SetItemString(pTimings, LaunchStepNames[i], pTime);
+		Py_XDECREF(pTime);
+	}
+	pyCallback("LaunchSequenceCompleted", Py_BuildValue("IIIN", iClientID, launch.iBaseID ? launch.iBaseID : iBaseID, iShip, pTimings));
+	memset(&launch, 0, sizeof(LAUNCH_STATE));
+}
+
+// outcomes_only: is this call part of a tracked trade
+bool SequenceMutedTrade(uint iClientID)
+{
+	return bSequenceOutcomesOnly && iClientID <= MAX_CLIENT_ID && TradeStates[iClientID].bActive;
+}
+
+// outcomes_only: is this call part of a tracked launch, iClientID 0 looks the client up by iShip
+bool SequenceMutedLaunch(uint iClientID, uint iShip)
+{
+	if (!bSequenceOutcomesOnly)
+		return false;
+	if (!iClientID)
+		iClientID = LaunchClient(iShip);
+	if (!iClientID || iClientID > MAX_CLIENT_ID)
+		return false;
+	mstime tmBaseExit = LaunchStates[iClientID].tmSteps[LS_BaseExit];
+	return tmBaseExit && timeInMS() - tmBaseExit <= LAUNCH_MAX_MS;
+}
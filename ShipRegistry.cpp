@@ -0,0 +1,182 @@
+#include "headers.h"
+#include <map>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Ship registry - every CShip in the game (npcs included) from HkIEngine_CShip_init until HkIEngine_CShip_destroy,
+by ship id: archetype, owner client (0 for npcs), system and spawn time. PlayerLaunch fills in the owner when
+the ship was created before FL assigned it, BaseEnter and ShipDestroyed remove ships whose destroy we might
+not see. The entries are kept in an open addressing hash table (linear probing, tombstones for removed ships,
+rebuilt at 70% use) so lookups are O(1), and the npc/player count per system is kept up to date as ships
+come and go.
+
+With FLHook.SetShipEvents(True) python gets HkIEngine_CShip_init/HkIEngine_CShip_destroy events as well.
+*/
+bool bShipEvents = false;
+
+#define SHIP_TABLE_MIN 1024 // slots, always a power of 2
+#define SHIP_TOMBSTONE 0xFFFFFFFF
+
+struct SHIP_COUNTS
+{
+	uint iNPCs;
+	uint iPlayers;
+};
+
+static SHIP_ENTRY *ShipTable;
+static uint iShipSlots; // table size
+static uint iShipUsed; // entries plus tombstones
+static uint iShipCount;
+static map<uint, SHIP_COUNTS> mapSystemCounts;
+
+static inline uint ShipHash(uint iShip)
+{
+	return (iShip * 2654435761u) & (iShipSlots - 1);
+}
+
+static void CountShip(const SHIP_ENTRY &entry, int iDelta)
+{
+	SHIP_COUNTS &counts = mapSystemCounts[entry.iSystem];
+	if (entry.iClientID)
+		counts.iPlayers += iDelta;
+	else
+		counts.iNPCs += iDelta;
+}
+
+static void ShipTableResize(uint iSlots)
+{
+	SHIP_ENTRY *OldTable = ShipTable;
+	uint iOldSlots = iShipSlots;
+	ShipTable = new SHIP_ENTRY[iSlots];
+	memset(ShipTable, 0, sizeof(SHIP_ENTRY) * iSlots);
+	iShipSlots = iSlots;
+	iShipUsed = iShipCount;
+	for (uint i = 0; i < iOldSlots; i++) {
+		if (!OldTable[i].iShip || OldTable[i].iShip == SHIP_TOMBSTONE)
+			continue;
+		uint iSlot = ShipHash(OldTable[i].iShip);
+		while (ShipTable[iSlot].iShip)
+			iSlot = (iSlot + 1) & (iShipSlots - 1);
+		ShipTable[iSlot] = OldTable[i];
+	}
+	delete[] OldTable;
+}
+
+static SHIP_ENTRY* ShipFind(uint iShip)
+{
+	if (!iShip || iShip == SHIP_TOMBSTONE || !ShipTable)
+		return NULL;
+	for (uint iSlot = ShipHash(iShip); ShipTable[iSlot].iShip; iSlot = (iSlot + 1) & (iShipSlots - 1)) {
+		if (ShipTable[iSlot].iShip == iShip)
+			return &ShipTable[iSlot];
+	}
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const SHIP_ENTRY* ShipRegistryFind(uint iShip)
+{
+	return ShipFind(iShip);
+}
+
+void ShipRegistryAdd(uint iShip, uint iArchID, uint iClientID, uint iSystem)
+{
+	if (!iShip || iShip == SHIP_TOMBSTONE)
+		return;
+	SHIP_ENTRY *pEntry = ShipFind(iShip);
+	if (pEntry) { // reused id we missed the destroy of
+		CountShip(*pEntry, -1);
+	}
+	else {
+		if (!ShipTable)
+			ShipTableResize(SHIP_TABLE_MIN);
+		else if ((iShipUsed + 1) * 10 > iShipSlots * 7)
+			ShipTableResize((iShipCount + 1) * 10 > iShipSlots * 5 ? iShipSlots * 2 : iShipSlots); // same size just drops the tombstones
+
+		uint iSlot = ShipHash(iShip);
+		while (ShipTable[iSlot].iShip && ShipTable[iSlot].iShip != SHIP_TOMBSTONE)
+			iSlot = (iSlot + 1) & (iShipSlots - 1);
+		if (!ShipTable[iSlot].iShip)
+			iShipUsed++;
+		iShipCount++;
+		pEntry = &ShipTable[iSlot];
+	}
+	pEntry->iShip = iShip;
+	pEntry->iArchID = iArchID;
+	pEntry->iClientID = iClientID;
+	pEntry->iSystem = iSystem;
+	pEntry->tmSpawn = timeInMS();
+	CountShip(*pEntry, 1);
+}
+
+void ShipRegistryRemove(uint iShip)
+{
+	SHIP_ENTRY *pEntry = ShipFind(iShip);
+	if (!pEntry)
+		return;
+	CountShip(*pEntry, -1);
+	pEntry->iShip = SHIP_TOMBSTONE;
+	iShipCount--;
+}
+
+void ShipRegistrySetOwner(uint iShip, uint iClientID)
+{
+	SHIP_ENTRY *pEntry = ShipFind(iShip);
+	if (!pEntry || pEntry->iClientID == iClientID)
+		return;
+	CountShip(*pEntry, -1);
+	pEntry->iClientID = iClientID;
+	CountShip(*pEntry, 1);
+}
+
+void ShipRegistryClearClient(uint iClientID)
+{
+	if (!iClientID)
+		return;
+	for (uint i = 0; i < iShipSlots; i++) {
+		if (ShipTable[i].iShip && ShipTable[i].iShip != SHIP_TOMBSTONE && ShipTable[i].iClientID == iClientID)
+			ShipRegistryRemove(ShipTable[i].iShip);
+	}
+}
+
+uint ShipRegistryCount()
+{
+	return iShipCount;
+}
+
+bool ShipRegistrySystemCounts(uint iSystem, uint &iNPCs, uint &iPlayers)
+{
+	map<uint, SHIP_COUNTS>::iterator it = mapSystemCounts.find(iSystem);
+	if (it == mapSystemCounts.end())
+		return false;
+	iNPCs = it->second.iNPCs;
+	iPlayers = it->second.iPlayers;
+	return true;
+}
+
+PyObject* ShipRegistryAllCounts()
+{
+	PyObject *pCounts = PyDict_New();
+	for (map<uint, SHIP_COUNTS>::iterator it = mapSystemCounts.begin(); it != mapSystemCounts.end(); ++it) {
+		if (!it->second.iNPCs && !it->second.iPlayers)
+			continue;
+		PyObject *pKey = PyInt_FromSize_t(it->first);
+		PyObject *pValue = Py_BuildValue("(II)", it->second.iNPCs, it->second.iPlayers);
+		PyDict_SetItem(pCounts, pKey, pValue);
+		Py_XDECREF(pKey);
+		Py_XDECREF(pValue);
+	}
+	return pCounts;
+}
+
+void ShipRegistryInSystem(uint iSystem, int iPlayers, list<uint> &lstShips)
+{
+	for (uint i = 0; i < iShipSlots; i++) {
+		const SHIP_ENTRY &entry = ShipTable[i];
+		if (!entry.iShip || entry.iShip == SHIP_TOMBSTONE || entry.iSystem != iSystem)
+			continue;
+		if (iPlayers < 0 || (iPlayers > 0) == (entry.iClientID != 0))
+			lstShips.push_back(entry.iShip);
+	}
+}
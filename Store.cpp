@@ -0,0 +1,682 @@
+#include "headers.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Key-value store - FLHook.Store(name) opens (or creates) flhook_plugins/python/store/<name>.kv and returns a
+FLHook.KVStore, a dict like object of str keys to str values that persists: store[key] = value, del
+store[key], store.get(key), key in store, len(store), store.keys().
+
+The file is an append only log of records (checksum, key length, value length, flags, key, value) that's
+memory mapped, so a write is a copy into the mapping and never waits for the disk. An in memory hash index
+of key to record offset is rebuilt by replaying the log when the store is opened. A background thread
+flushes the mapping of stores written to about once a second, through its own duplicates of the handles
+taken under the locks, so the disk I/O happens with no lock held. If the server crashes the records written
+are still in the mapping (the OS writes it out), a record cut short by a power loss fails its checksum and
+the log is read up to the last good one; the header after the last record is kept zeroed so nothing past
+the log replays.
+
+Every write appends a new record (a delete appends a tombstone), so the file grows with dead records: when
+they're more then half of a file over KV_COMPACT_MIN, StoreTick() rewrites it with only the live ones. The
+rewritten file is only written to its mapping there, flushing it is left to the flush thread like any write.
+
+Reads copy the value straight out of the mapping into the returned str, there's no file access.
+FLHook.CheckStore() writes a scratch store, reopens it and checks the replay gives back what was written.
+*/
+#define KV_MAGIC "FLKVST1" // 8 bytes with the NUL
+#define KV_HEADER_SIZE 8
+#define KV_MIN_CAPACITY 0x10000
+#define KV_COMPACT_MIN 0x100000 // bytes of log before it's worth compacting
+#define KV_COMPACT_INTERVAL 60000 // ms between checks
+#define KV_FLUSH_INTERVAL 1000 // ms
+#define KV_TOMBSTONE 1
+
+struct KV_RECORD
+{
+	uint iCRC; // of the rest of the header, the key and the value
+	uint iKeyLen;
+	uint iValueLen;
+	uint iFlags;
+};
+
+struct KV_ENTRY
+{
+	uint iOffset; // of the KV_RECORD
+	uint iValueLen;
+};
+
+struct KV_STORE
+{
+	string scName;
+	string scPath;
+	HANDLE hFile;
+	HANDLE hMapping;
+	unsigned char *pView;
+	uint iCapacity; // size mapped
+	uint iEnd; // end of the last good record
+	uint iLive; // bytes of records still in the index
+	volatile LONG bDirty;
+	CRITICAL_SECTION cs; // the mapping, between the game thread remapping it and the flush thread
+	unordered_map<string, KV_ENTRY> mapIndex;
+};
+
+struct PY_KVSTORE
+{
+	PyObject_HEAD
+	KV_STORE *pStore; // NULL once closed
+};
+
+static map<string, PyObject*> mapStores; // name to PY_KVSTORE, one per store
+static list<KV_STORE*> lstFlushStores; // the stores the flush thread looks at
+static CRITICAL_SECTION csStores; // lstFlushStores
+static HANDLE hFlushThread = NULL;
+static HANDLE hFlushEvent = NULL;
+static volatile LONG bFlushStop = 0;
+static mstime tmLastCompactCheck;
+
+static uint CRCTable[256];
+
+static void InitCRC()
+{
+	for (uint i = 0; i < 256; i++) {
+		uint c = i;
+		for (int k = 0; k < 8; k++)
+			c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		CRCTable[i] = c;
+	}
+}
+
+static uint CRC32(uint iCRC, const unsigned char *pData, uint iSize)
+{
+	iCRC = ~iCRC;
+	for (uint i = 0; i < iSize; i++)
+		iCRC = CRCTable[(iCRC ^ pData[i]) & 0xFF] ^ (iCRC >> 8);
+	return ~iCRC;
+}
+
+static uint RecordCRC(const unsigned char *pRecord)
+{
+	const KV_RECORD *pHeader = (const KV_RECORD*)pRecord;
+	return CRC32(0, pRecord + sizeof(uint), sizeof(KV_RECORD) - sizeof(uint) + pHeader->iKeyLen + pHeader->iValueLen);
+}
+
+static inline uint RecordSize(uint iKeyLen, uint iValueLen)
+{
+	return sizeof(KV_RECORD) + iKeyLen + iValueLen;
+}
+
+struct KV_FLUSH
+{
+	HANDLE hFile; // duplicates, they stay valid when the store remaps, compacts or closes meanwhile
+	HANDLE hMapping;
+	uint iSize;
+};
+
+static DWORD WINAPI StoreFlushThread(LPVOID lpParam)
+{
+	HANDLE hProcess = GetCurrentProcess();
+	vector<KV_FLUSH> vFlush;
+	while (!InterlockedCompareExchange(&bFlushStop, 0, 0)) {
+		WaitForSingleObject(hFlushEvent, KV_FLUSH_INTERVAL);
+		EnterCriticalSection(&csStores);
+		for (list<KV_STORE*>::iterator it = lstFlushStores.begin(); it != lstFlushStores.end(); ++it) {
+			KV_STORE *pStore = *it;
+			if (!InterlockedExchange(&pStore->bDirty, 0))
+				continue;
+			KV_FLUSH flush = { NULL, NULL, 0 };
+			EnterCriticalSection(&pStore->cs);
+			if (pStore->hMapping && DuplicateHandle(hProcess, pStore->hMapping, hProcess, &flush.hMapping, 0, FALSE, DUPLICATE_SAME_ACCESS)) {
+				if (DuplicateHandle(hProcess, pStore->hFile, hProcess, &flush.hFile, 0, FALSE, DUPLICATE_SAME_ACCESS)) {
+					flush.iSize = min(pStore->iEnd, pStore->iCapacity); // iEnd can be ahead of a compacted mapping
+					vFlush.push_back(flush);
+				}
+				else {
+					CloseHandle(flush.hMapping);
+				}
+			}
+			LeaveCriticalSection(&pStore->cs);
+		}
+		LeaveCriticalSection(&csStores);
+
+		// a view of the same mapping shares its pages, flushing it writes the stores changes
+		for (uint i = 0; i < vFlush.size(); i++) {
+			void *pView = MapViewOfFile(vFlush[i].hMapping, FILE_MAP_WRITE, 0, 0, vFlush[i].iSize);
+			if (pView) {
+				FlushViewOfFile(pView, vFlush[i].iSize);
+				UnmapViewOfFile(pView);
+			}
+			FlushFileBuffers(vFlush[i].hFile);
+			CloseHandle(vFlush[i].hMapping);
+			CloseHandle(vFlush[i].hFile);
+		}
+		vFlush.clear();
+	}
+	return 0;
+}
+
+// maps iCapacity bytes of the file (growing it if needed), the caller holds pStore->cs if others could see it
+static bool StoreMap(KV_STORE *pStore, uint iCapacity)
+{
+	if (pStore->pView)
+		UnmapViewOfFile(pStore->pView);
+	if (pStore->hMapping)
+		CloseHandle(pStore->hMapping);
+	pStore->pView = NULL;
+	pStore->hMapping = CreateFileMapping(pStore->hFile, NULL, PAGE_READWRITE, 0, iCapacity, NULL);
+	if (!pStore->hMapping)
+		return false;
+	pStore->pView = (unsigned char*)MapViewOfFile(pStore->hMapping, FILE_MAP_WRITE, 0, 0, iCapacity);
+	if (!pStore->pView) {
+		CloseHandle(pStore->hMapping);
+		pStore->hMapping = NULL;
+		return false;
+	}
+	pStore->iCapacity = iCapacity;
+	return true;
+}
+
+static void StoreReplay(KV_STORE *pStore)
+{
+	pStore->mapIndex.clear();
+	pStore->iLive = 0;
+	uint iOffset = KV_HEADER_SIZE;
+	while (iOffset + sizeof(KV_RECORD) <= pStore->iCapacity) {
+		const KV_RECORD *pHeader = (const KV_RECORD*)(pStore->pView + iOffset);
+		if (!pHeader->iKeyLen || pHeader->iKeyLen > pStore->iCapacity || pHeader->iValueLen > pStore->iCapacity)
+			break;
+		uint iSize = RecordSize(pHeader->iKeyLen, pHeader->iValueLen);
+		if (iOffset + iSize > pStore->iCapacity || RecordCRC(pStore->pView + iOffset) != pHeader->iCRC)
+			break; // the end, or a record cut short
+		string scKey((const char*)pHeader + sizeof(KV_RECORD), pHeader->iKeyLen);
+		unordered_map<string, KV_ENTRY>::iterator it = pStore->mapIndex.find(scKey);
+		if (it != pStore->mapIndex.end()) {
+			pStore->iLive -= RecordSize(pHeader->iKeyLen, it->second.iValueLen);
+			if (pHeader->iFlags & KV_TOMBSTONE)
+				pStore->mapIndex.erase(it);
+		}
+		if (!(pHeader->iFlags & KV_TOMBSTONE)) {
+			KV_ENTRY &entry = pStore->mapIndex[scKey];
+			entry.iOffset = iOffset;
+			entry.iValueLen = pHeader->iValueLen;
+			pStore->iLive += iSize;
+		}
+		iOffset += iSize;
+	}
+	pStore->iEnd = iOffset;
+}
+
+static bool StoreAppend(KV_STORE *pStore, const string &scKey, const char *pValue, uint iValueLen, uint iFlags)
+{
+	uint iSize = RecordSize(scKey.length(), iValueLen);
+	if (pStore->iEnd + iSize > pStore->iCapacity) {
+		uint iCapacity = pStore->iCapacity;
+		while (pStore->iEnd + iSize > iCapacity)
+			iCapacity *= 2;
+		EnterCriticalSection(&pStore->cs);
+		bool bMapped = StoreMap(pStore, iCapacity);
+		LeaveCriticalSection(&pStore->cs);
+		if (!bMapped)
+			return false;
+	}
+	unsigned char *pRecord = pStore->pView + pStore->iEnd;
+	// the header after the record first: whatever the file held there mustn't replay once this record is complete
+	if (pStore->iEnd + iSize + sizeof(KV_RECORD) <= pStore->iCapacity)
+		memset(pRecord + iSize, 0, sizeof(KV_RECORD));
+	KV_RECORD *pHeader = (KV_RECORD*)pRecord;
+	pHeader->iKeyLen = scKey.length();
+	pHeader->iValueLen = iValueLen;
+	pHeader->iFlags = iFlags;
+	memcpy(pRecord + sizeof(KV_RECORD), scKey.data(), scKey.length());
+	if (iValueLen)
+		memcpy(pRecord + sizeof(KV_RECORD) + scKey.length(), pValue, iValueLen);
+	pHeader->iCRC = RecordCRC(pRecord);
+	pStore->iEnd += iSize;
+	InterlockedExchange(&pStore->bDirty, 1);
+	return true;
+}
+
+static KV_STORE* StoreOpen(const string &scName)
+{
+	CreateDirectory("./flhook_plugins/python/store", NULL);
+	KV_STORE *pStore = new KV_STORE;
+	pStore->scName = scName;
+	pStore->scPath = "./flhook_plugins/python/store/" + scName + ".kv";
+	pStore->hMapping = NULL;
+	pStore->pView = NULL;
+	pStore->bDirty = 0;
+	pStore->hFile = CreateFile(pStore->scPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (pStore->hFile == INVALID_HANDLE_VALUE) {
+		delete pStore;
+		return NULL;
+	}
+	uint iSize = GetFileSize(pStore->hFile, NULL);
+	uint iCapacity = KV_MIN_CAPACITY;
+	while (iCapacity < iSize)
+		iCapacity *= 2;
+	if (!StoreMap(pStore, iCapacity)) {
+		CloseHandle(pStore->hFile);
+		delete pStore;
+		return NULL;
+	}
+	if (iSize < KV_HEADER_SIZE || memcmp(pStore->pView, KV_MAGIC, KV_HEADER_SIZE)) {
+		if (iSize >= KV_HEADER_SIZE)
+			ERRMSG(L"WARNING store " + stows(scName) + L" is not a store file, starting it empty");
+		memset(pStore->pView, 0, KV_HEADER_SIZE + sizeof(KV_RECORD));
+		memcpy(pStore->pView, KV_MAGIC, KV_HEADER_SIZE);
+	}
+	StoreReplay(pStore);
+	InitializeCriticalSection(&pStore->cs);
+
+	if (!hFlushThread) {
+		InitializeCriticalSection(&csStores);
+		hFlushEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		InterlockedExchange(&bFlushStop, 0);
+		hFlushThread = CreateThread(NULL, 0, StoreFlushThread, NULL, 0, NULL);
+	}
+	EnterCriticalSection(&csStores);
+	lstFlushStores.push_back(pStore);
+	LeaveCriticalSection(&csStores);
+	return pStore;
+}
+
+static void StoreClose(KV_STORE *pStore)
+{
+	EnterCriticalSection(&csStores);
+	lstFlushStores.remove(pStore);
+	LeaveCriticalSection(&csStores);
+	FlushViewOfFile(pStore->pView, pStore->iEnd);
+	UnmapViewOfFile(pStore->pView);
+	CloseHandle(pStore->hMapping);
+	CloseHandle(pStore->hFile);
+	DeleteCriticalSection(&pStore->cs);
+	delete pStore;
+}
+
+// rewrites the log with only the live records, false (and the store unchanged) if that failed
+static bool StoreCompact(KV_STORE *pStore)
+{
+	string scTemp = pStore->scPath + ".tmp";
+	HANDLE hFile = CreateFile(scTemp.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	uint iCapacity = KV_MIN_CAPACITY;
+	while (iCapacity < KV_HEADER_SIZE + pStore->iLive + sizeof(KV_RECORD))
+		iCapacity *= 2;
+	SetFilePointer(hFile, 0, NULL, FILE_BEGIN);
+	SetEndOfFile(hFile); // a left over .tmp could be larger
+	HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_READWRITE, 0, iCapacity, NULL);
+	unsigned char *pView = hMapping ? (unsigned char*)MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, iCapacity) : NULL;
+	if (!pView) {
+		if (hMapping)
+			CloseHandle(hMapping);
+		CloseHandle(hFile);
+		DeleteFile(scTemp.c_str());
+		return false;
+	}
+
+	memcpy(pView, KV_MAGIC, KV_HEADER_SIZE);
+	uint iOffset = KV_HEADER_SIZE;
+	for (unordered_map<string, KV_ENTRY>::iterator it = pStore->mapIndex.begin(); it != pStore->mapIndex.end(); ++it) {
+		uint iSize = RecordSize(it->first.length(), it->second.iValueLen);
+		memcpy(pView + iOffset, pStore->pView + it->second.iOffset, iSize); // checksums don't depend on the offset
+		it->second.iOffset = iOffset;
+		iOffset += iSize;
+	}
+	memset(pView + iOffset, 0, min(iCapacity - iOffset, (uint)sizeof(KV_RECORD)));
+	UnmapViewOfFile(pView); // not flushed here, StoreTick runs in the frame: the flush thread does it below
+	CloseHandle(hMapping);
+	CloseHandle(hFile);
+
+	EnterCriticalSection(&pStore->cs);
+	UnmapViewOfFile(pStore->pView);
+	CloseHandle(pStore->hMapping);
+	CloseHandle(pStore->hFile);
+	pStore->pView = NULL;
+	pStore->hMapping = NULL;
+	bool bMoved = MoveFileEx(scTemp.c_str(), pStore->scPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+	pStore->hFile = CreateFile(pStore->scPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	bool bMapped = pStore->hFile != INVALID_HANDLE_VALUE && StoreMap(pStore, bMoved ? iCapacity : pStore->iCapacity);
+	LeaveCriticalSection(&pStore->cs);
+	if (!bMapped) {
+		ERRMSG(L"ERROR store " + stows(pStore->scName) + L" could not be reopened after compacting");
+		return false;
+	}
+	if (!bMoved)
+		StoreReplay(pStore); // still the old file, the offsets have to come from it again
+	else
+		pStore->iEnd = iOffset;
+	InterlockedExchange(&pStore->bDirty, 1);
+	SetEvent(hFlushEvent);
+	return bMoved;
+}
+
+static bool StoreValid(PY_KVSTORE *self)
+{
+	if (self->pStore && self->pStore->pView)
+		return true;
+	PyErr_SetString(PyExc_ValueError, "store is closed");
+	return false;
+}
+
+static PyObject* StoreValue(KV_STORE *pStore, const KV_ENTRY &entry, uint iKeyLen)
+{
+	return PyString_FromStringAndSize((const char*)pStore->pView + entry.iOffset + sizeof(KV_RECORD) + iKeyLen, entry.iValueLen);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static Py_ssize_t KVStore_length(PY_KVSTORE *self)
+{
+	if (!StoreValid(self))
+		return -1;
+	return self->pStore->mapIndex.size();
+}
+
+static PyObject* KVStore_subscript(PY_KVSTORE *self, PyObject *pKey)
+{
+	if (!StoreValid(self))
+		return NULL;
+	if (!PyString_Check(pKey)) {
+		PyErr_SetString(PyExc_TypeError, "store keys must be str");
+		return NULL;
+	}
+	string scKey(PyString_AS_STRING(pKey), PyString_GET_SIZE(pKey));
+	unordered_map<string, KV_ENTRY>::iterator it = self->pStore->mapIndex.find(scKey);
+	if (it == self->pStore->mapIndex.end()) {
+		PyErr_SetObject(PyExc_KeyError, pKey);
+		return NULL;
+	}
+	return StoreValue(self->pStore, it->second, scKey.length());
+}
+
+static int KVStore_ass_subscript(PY_KVSTORE *self, PyObject *pKey, PyObject *pValue)
+{
+	if (!StoreValid(self))
+		return -1;
+	if (!PyString_Check(pKey) || !PyString_GET_SIZE(pKey)) {
+		PyErr_SetString(PyExc_TypeError, "store keys must be non empty str");
+		return -1;
+	}
+	KV_STORE *pStore = self->pStore;
+	string scKey(PyString_AS_STRING(pKey), PyString_GET_SIZE(pKey));
+	unordered_map<string, KV_ENTRY>::iterator it = pStore->mapIndex.find(scKey);
+	if (!pValue) { // del store[key]
+		if (it == pStore->mapIndex.end()) {
+			PyErr_SetObject(PyExc_KeyError, pKey);
+			return -1;
+		}
+		if (!StoreAppend(pStore, scKey, NULL, 0, KV_TOMBSTONE)) {
+			PyErr_SetString(PyExc_IOError, "store could not grow its file");
+			return -1;
+		}
+		pStore->iLive -= RecordSize(scKey.length(), it->second.iValueLen);
+		pStore->mapIndex.erase(it);
+		return 0;
+	}
+
+	const char *pData;
+	Py_ssize_t iLength;
+	if (PyObject_AsReadBuffer(pValue, (const void**)&pData, &iLength) < 0) {
+		PyErr_SetString(PyExc_TypeError, "store values must be str (or another buffer)");
+		return -1;
+	}
+	uint iOffset = pStore->iEnd;
+	if (!StoreAppend(pStore, scKey, pData, iLength, 0)) {
+		PyErr_SetString(PyExc_IOError, "store could not grow its file");
+		return -1;
+	}
+	if (it != pStore->mapIndex.end())
+		pStore->iLive -= RecordSize(scKey.length(), it->second.iValueLen);
+	KV_ENTRY &entry = pStore->mapIndex[scKey];
+	entry.iOffset = iOffset;
+	entry.iValueLen = iLength;
+	pStore->iLive += RecordSize(scKey.length(), iLength);
+	return 0;
+}
+
+static int KVStore_contains(PY_KVSTORE *self, PyObject *pKey)
+{
+	if (!StoreValid(self))
+		return -1;
+	if (!PyString_Check(pKey))
+		return 0;
+	return self->pStore->mapIndex.count(string(PyString_AS_STRING(pKey), PyString_GET_SIZE(pKey))) ? 1 : 0;
+}
+
+static PyObject* KVStore_get(PY_KVSTORE *self, PyObject *pArgs)
+{
+	PyObject *pKey, *pDefault = Py_None;
+	if (!PyArg_ParseTuple(pArgs, "O|O", &pKey, &pDefault))
+		return NULL;
+	if (!StoreValid(self))
+		return NULL;
+	if (PyString_Check(pKey)) {
+		string scKey(PyString_AS_STRING(pKey), PyString_GET_SIZE(pKey));
+		unordered_map<string, KV_ENTRY>::iterator it = self->pStore->mapIndex.find(scKey);
+		if (it != self->pStore->mapIndex.end())
+			return StoreValue(self->pStore, it->second, scKey.length());
+	}
+	Py_INCREF(pDefault);
+	return pDefault;
+}
+
+static PyObject* KVStore_keys(PY_KVSTORE *self, PyObject *pArgs)
+{
+	if (!StoreValid(self))
+		return NULL;
+	PyObject *pKeys = PyList_New(self->pStore->mapIndex.size());
+	uint i = 0;
+	for (unordered_map<string, KV_ENTRY>::iterator it = self->pStore->mapIndex.begin(); it != self->pStore->mapIndex.end(); ++it, ++i)
+		PyList_SET_ITEM(pKeys, i, PyString_FromStringAndSize(it->first.data(), it->first.length()));
+	return pKeys;
+}
+
+static PyObject* KVStore_iter(PY_KVSTORE *self)
+{
+	PyObject *pKeys = KVStore_keys(self, NULL);
+	if (!pKeys)
+		return NULL;
+	PyObject *pIter = PyObject_GetIter(pKeys);
+	Py_DECREF(pKeys);
+	return pIter;
+}
+
+static PyObject* KVStore_flush(PY_KVSTORE *self, PyObject *pArgs)
+{
+	if (!StoreValid(self))
+		return NULL;
+	InterlockedExchange(&self->pStore->bDirty, 1);
+	SetEvent(hFlushEvent);
+	Py_RETURN_NONE;
+}
+
+static PyObject* KVStore_compact(PY_KVSTORE *self, PyObject *pArgs)
+{
+	if (!StoreValid(self))
+		return NULL;
+	return PyBool_FromLong(StoreCompact(self->pStore));
+}
+
+static PyObject* KVStore_stats(PY_KVSTORE *self, void *pClosure)
+{
+	if (!StoreValid(self))
+		return NULL;
+	KV_STORE *pStore = self->pStore;
+	return Py_BuildValue("{s:I,s:I,s:I,s:I}", "keys", (uint)pStore->mapIndex.size(), "live_bytes", pStore->iLive,
+		"log_bytes", pStore->iEnd, "file_bytes", pStore->iCapacity);
+}
+
+static PyMethodDef KVStoreMethods[] = {
+	{ "get", (PyCFunction)KVStore_get, METH_VARARGS, "str value = get(str key, default=None)" },
+	{ "keys", (PyCFunction)KVStore_keys, METH_NOARGS, "list keys = keys()" },
+	{ "flush", (PyCFunction)KVStore_flush, METH_NOARGS, "flush(), have the flush thread write the store out now" },
+	{ "compact", (PyCFunction)KVStore_compact, METH_NOARGS, "bool compacted = compact()" },
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyGetSetDef KVStoreGetSet[] = {
+	{ "stats", (getter)KVStore_stats, NULL, "dict of keys, live_bytes, log_bytes, file_bytes", NULL },
+	{ NULL, NULL, NULL, NULL, NULL }
+};
+
+static PyMappingMethods KVStoreMapping = {
+	(lenfunc)KVStore_length,
+	(binaryfunc)KVStore_subscript,
+	(objobjargproc)KVStore_ass_subscript
+};
+
+static PySequenceMethods KVStoreSequence = {
+	0, 0, 0, 0, 0, 0, 0,
+	(objobjproc)KVStore_contains
+};
+
+static PyTypeObject KVStoreType = {
+	PyVarObject_HEAD_INIT(NULL, 0)
+	"FLHook.KVStore", // tp_name
+	sizeof(PY_KVSTORE), // tp_basicsize
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void InitStoreType(PyObject *pHook)
+{
+	InitCRC(); // before any store is opened and replayed
+	KVStoreType.tp_flags = Py_TPFLAGS_DEFAULT;
+	KVStoreType.tp_doc = "persistent str to str store, from FLHook.Store(name)";
+	KVStoreType.tp_as_mapping = &KVStoreMapping;
+	KVStoreType.tp_as_sequence = &KVStoreSequence;
+	KVStoreType.tp_iter = (getiterfunc)KVStore_iter;
+	KVStoreType.tp_methods = KVStoreMethods;
+	KVStoreType.tp_getset = KVStoreGetSet;
+	if (PyType_Ready(&KVStoreType) < 0)
+		return;
+	Py_INCREF(&KVStoreType);
+	PyModule_AddObject(pHook, "KVStore", (PyObject*)&KVStoreType); // reference stealer
+}
+
+// the store named scName, opened the first time it's asked for. NULL with a python exception set on failure
+PyObject* pyStore(const string &scName)
+{
+	if (scName.empty() || scName.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-") != string::npos) {
+		PyErr_SetString(PyExc_ValueError, "store names are letters, digits, _ and -");
+		return NULL;
+	}
+	map<string, PyObject*>::iterator it = mapStores.find(scName);
+	if (it != mapStores.end()) {
+		Py_INCREF(it->second);
+		return it->second;
+	}
+	KV_STORE *pStore = StoreOpen(scName);
+	if (!pStore) {
+		PyErr_SetString(PyExc_IOError, "store file could not be opened");
+		return NULL;
+	}
+	PY_KVSTORE *pObj = PyObject_New(PY_KVSTORE, &KVStoreType);
+	if (!pObj) {
+		StoreClose(pStore);
+		return NULL;
+	}
+	pObj->pStore = pStore;
+	mapStores[scName] = (PyObject*)pObj; // this reference is the plugin's, until StopStores
+	Py_INCREF(pObj);
+	return (PyObject*)pObj;
+}
+
+// compacts stores that are mostly dead records, from HkCb_Update_Time_AFTER
+void StoreTick()
+{
+	if (mapStores.empty())
+		return;
+	mstime tmNow = timeInMS();
+	if (tmNow - tmLastCompactCheck < KV_COMPACT_INTERVAL)
+		return;
+	tmLastCompactCheck = tmNow;
+	for (map<string, PyObject*>::iterator it = mapStores.begin(); it != mapStores.end(); ++it) {
+		KV_STORE *pStore = ((PY_KVSTORE*)it->second)->pStore;
+		if (pStore && pStore->pView && pStore->iEnd > KV_COMPACT_MIN && pStore->iLive * 2 < pStore->iEnd)
+			StoreCompact(pStore);
+	}
+}
+
+// flushes and closes every store, the KVStore objects scripts still have raise ValueError after this
+void StopStores()
+{
+	if (!hFlushThread)
+		return;
+	InterlockedExchange(&bFlushStop, 1);
+	SetEvent(hFlushEvent);
+	if (WaitForSingleObject(hFlushThread, 2000) != WAIT_OBJECT_0) {
+		// still flushing (or stuck under the loader lock), it walks lstFlushStores and uses every store and csStores,
+		// so they're leaked rather then freed under it. The mappings stay, the OS writes them out
+		ERRMSG(L"WARNING store flush thread did not stop, leaving the stores open");
+		return;
+	}
+	CloseHandle(hFlushThread);
+	CloseHandle(hFlushEvent);
+	hFlushThread = NULL;
+	for (map<string, PyObject*>::iterator it = mapStores.begin(); it != mapStores.end(); ++it) {
+		PY_KVSTORE *pObj = (PY_KVSTORE*)it->second;
+		StoreClose(pObj->pStore);
+		pObj->pStore = NULL;
+		Py_DECREF(pObj);
+	}
+	mapStores.clear();
+	DeleteCriticalSection(&csStores);
+}
+
+// writes iRecords records (some overwritten, some deleted) to a scratch store, closes it, opens it again and
+// compares what the replay finds with what was written. The scratch file is deleted again afterwards
+PyObject* StoreCheck(uint iRecords)
+{
+	const string scName = "store.check"; // not a name pyStore accepts, no script has it open
+	DeleteFile(("./flhook_plugins/python/store/" + scName + ".kv").c_str()); // left by a check that didn't finish
+	KV_STORE *pStore = StoreOpen(scName);
+	if (!pStore) {
+		PyErr_SetString(PyExc_IOError, "store file could not be opened");
+		return NULL;
+	}
+	string scPath = pStore->scPath;
+	map<string, string> mapExpected;
+	bool bOK = true;
+	for (uint i = 0; i < iRecords && bOK; i++) {
+		string scKey = "key" + to_string(i);
+		string scValue = "value" + to_string(i) + string(i % 97, 'x');
+		bOK = StoreAppend(pStore, scKey, scValue.data(), scValue.length(), 0);
+		mapExpected[scKey] = scValue;
+	}
+	for (uint i = 0; i < iRecords && bOK; i += 5) {
+		string scKey = "key" + to_string(i);
+		bOK = StoreAppend(pStore, scKey, NULL, 0, KV_TOMBSTONE);
+		mapExpected.erase(scKey);
+	}
+	for (uint i = 0; i < iRecords && bOK; i += 3) { // deleted ones come back too
+		string scKey = "key" + to_string(i);
+		string scValue = "again" + to_string(i);
+		bOK = StoreAppend(pStore, scKey, scValue.data(), scValue.length(), 0);
+		mapExpected[scKey] = scValue;
+	}
+	uint iWritten = pStore->iEnd;
+	StoreClose(pStore);
+
+	pStore = bOK ? StoreOpen(scName) : NULL;
+	uint iReplayed = 0, iMatched = 0;
+	if (pStore) {
+		iReplayed = pStore->iEnd;
+		for (map<string, string>::iterator it = mapExpected.begin(); it != mapExpected.end(); ++it) {
+			unordered_map<string, KV_ENTRY>::iterator itEntry = pStore->mapIndex.find(it->first);
+			if (itEntry != pStore->mapIndex.end() && itEntry->second.iValueLen == it->second.length()
+				&& !memcmp(pStore->pView + itEntry->second.iOffset + sizeof(KV_RECORD) + it->first.length(), it->second.data(), it->second.length()))
+				iMatched++;
+		}
+		bOK = iReplayed == iWritten && iMatched == mapExpected.size() && pStore->mapIndex.size() == mapExpected.size();
+		StoreClose(pStore);
+	}
+	else {
+		bOK = false;
+	}
+	DeleteFile(scPath.c_str());
+	return Py_BuildValue("{s:I,s:I,s:I,s:I,s:I,s:O}", "records", iRecords, "keys", (uint)mapExpected.size(), "matched", iMatched,
+		"log_bytes", iWritten, "replayed_bytes", iReplayed, "ok", PY_BOOL(bOK));
+}
@@ -0,0 +1,230 @@
+#include "headers.h"
+#include <map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Tracebacks - CheckPyException hands every python error here with its traceback. Errors are grouped by
+fingerprint (the event being handled plus "type: value"), and the raw exception objects of the first
+iTracebackSamples of each are kept. Nothing is formatted then: at the end of a tick up to
+TB_FORMAT_PER_TICK kept samples go through traceback.format_exception, get logged (through Logging.cpp, so
+the log thread does the writing) and the objects are released. Every later occurrence of the error only
+bumps its count, so a handler failing on every SPObjUpdate costs a map lookup per error, not a formatted
+traceback.
+
+The admin command "pyerrors" lists the errors with their counts, "pyerrors <n>" prints the tracebacks
+kept for error n, and "pyerrors clear" forgets everything. FLHook.GetErrors() returns the same to python.
+*/
+#define TB_MAX_ERRORS 256 // distinct fingerprints, after that errors are only counted in iTracebackOther
+#define TB_FORMAT_PER_TICK 2
+
+struct TB_SAMPLE
+{
+	PyObject *pType, *pValue, *pTraceback; // NULL once formatted
+	wstring wscFormatted;
+};
+
+struct TB_ERROR
+{
+	string scEvent;
+	wstring wscError; // "type: value"
+	uint iCount;
+	mstime tmFirst;
+	mstime tmLast;
+	vector<TB_SAMPLE> vSamples;
+};
+
+static vector<TB_ERROR> vTracebackErrors; // in the order first seen, the index is the error number
+static map<uint, uint> mapTracebackIndex; // fingerprint to index
+static list<pair<uint, uint> > lstUnformatted; // (error, sample)
+static uint iTracebackSamples = 3;
+static uint iTracebackOther = 0;
+static PyObject *pFormatException = NULL;
+
+static uint TracebackFingerprint(const char *szEvent, const wstring &wscError)
+{
+	uint iHash = 2166136261u;
+	for (const char *sz = szEvent; sz && *sz; sz++)
+		iHash = (iHash ^ (unsigned char)*sz) * 16777619u;
+	for (uint i = 0; i < wscError.length(); i++)
+		iHash = (iHash ^ wscError[i]) * 16777619u;
+	return iHash;
+}
+
+static void ReleaseSample(TB_SAMPLE &sample)
+{
+	Py_XDECREF(sample.pType);
+	Py_XDECREF(sample.pValue);
+	Py_XDECREF(sample.pTraceback);
+	sample.pType = sample.pValue = sample.pTraceback = NULL;
+}
+
+// formats a kept sample and releases its objects, errors formatting it are swallowed (not recorded again)
+static void FormatSample(TB_SAMPLE &sample)
+{
+	if (!sample.pType)
+		return;
+	if (!pFormatException) {
+		PyObject *pTracebackModule = PyImport_ImportModule("traceback");
+		if (pTracebackModule) {
+			pFormatException = PyObject_GetAttrString(pTracebackModule, "format_exception");
+			Py_DECREF(pTracebackModule);
+		}
+	}
+	PyObject *pLines = NULL;
+	if (pFormatException) {
+		PyErr_NormalizeException(&sample.pType, &sample.pValue, &sample.pTraceback);
+		pLines = PyObject_CallFunctionObjArgs(pFormatException, sample.pType,
+			sample.pValue ? sample.pValue : Py_None, sample.pTraceback ? sample.pTraceback : Py_None, NULL);
+	}
+	if (pLines && PyList_Check(pLines)) {
+		for (Py_ssize_t i = 0; i < PyList_GET_SIZE(pLines); i++)
+			sample.wscFormatted += pyunitows(PyList_GET_ITEM(pLines, i));
+	}
+	else {
+		PyErr_Clear();
+		sample.wscFormatted = L"(traceback could not be formatted)\n";
+	}
+	Py_XDECREF(pLines);
+	ReleaseSample(sample);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// takes the references to pType, pValue and pTraceback (from PyErr_Fetch)
+void TracebackRecord(const char *szEvent, const wstring &wscError, PyObject *pType, PyObject *pValue, PyObject *pTraceback)
+{
+	uint iFingerprint = TracebackFingerprint(szEvent, wscError);
+	map<uint, uint>::iterator it = mapTracebackIndex.find(iFingerprint);
+	uint iIndex;
+	if (it != mapTracebackIndex.end()) {
+		iIndex = it->second;
+	}
+	else if (vTracebackErrors.size() < TB_MAX_ERRORS) {
+		iIndex = vTracebackErrors.size();
+		mapTracebackIndex[iFingerprint] = iIndex;
+		vTracebackErrors.push_back(TB_ERROR());
+		TB_ERROR &error = vTracebackErrors.back();
+		error.scEvent = szEvent ? szEvent : "";
+		error.wscError = wscError;
+		error.iCount = 0;
+		error.tmFirst = timeInMS();
+	}
+	else {
+		iTracebackOther++;
+		Py_XDECREF(pType);
+		Py_XDECREF(pValue);
+		Py_XDECREF(pTraceback);
+		return;
+	}
+
+	TB_ERROR &error = vTracebackErrors[iIndex];
+	error.iCount++;
+	error.tmLast = timeInMS();
+	if (error.vSamples.size() >= iTracebackSamples || !pType) {
+		Py_XDECREF(pType);
+		Py_XDECREF(pValue);
+		Py_XDECREF(pTraceback);
+		return;
+	}
+	TB_SAMPLE sample;
+	sample.pType = pType;
+	sample.pValue = pValue;
+	sample.pTraceback = pTraceback;
+	error.vSamples.push_back(sample);
+	lstUnformatted.push_back(make_pair(iIndex, error.vSamples.size() - 1));
+}
+
+// formats (and logs) a few kept samples, from HkCb_Update_Time_AFTER
+void TracebackTick()
+{
+	for (uint i = 0; i < TB_FORMAT_PER_TICK && !lstUnformatted.empty(); i++) {
+		uint iIndex = lstUnformatted.front().first;
+		TB_ERROR &error = vTracebackErrors[iIndex];
+		TB_SAMPLE &sample = error.vSamples[lstUnformatted.front().second];
+		lstUnformatted.pop_front();
+		FormatSample(sample);
+		wchar_t wszHeader[32];
+		swprintf(wszHeader, 32, L"python error #%u (", iIndex);
+		LogWriteLines(LOG_ERROR, wszHeader + stows(error.scEvent) + L")\n" + sample.wscFormatted);
+	}
+}
+
+void TracebackClear()
+{
+	for (uint i = 0; i < vTracebackErrors.size(); i++) {
+		for (uint j = 0; j < vTracebackErrors[i].vSamples.size(); j++)
+			ReleaseSample(vTracebackErrors[i].vSamples[j]);
+	}
+	vTracebackErrors.clear();
+	mapTracebackIndex.clear();
+	lstUnformatted.clear();
+	iTracebackOther = 0;
+	Py_XDECREF(pFormatException);
+	pFormatException = NULL;
+}
+
+void SetTracebackSamples(uint iSamples)
+{
+	iTracebackSamples = iSamples;
+}
+
+// the "pyerrors" admin command, returns false if wscCmd isn't it
+bool TracebackAdminCmd(CCmds *classptr, const wstring &wscCmd)
+{
+	if (wscCmd.compare(0, 8, L"pyerrors") || (wscCmd.length() > 8 && wscCmd[8] != L' '))
+		return false;
+	if (!(classptr->rights & RIGHT_SUPERADMIN)) {
+		classptr->Print(L"ERR No permission\n");
+		return true;
+	}
+	wstring wscArg = wscCmd.length() > 9 ? wscCmd.substr(9) : L"";
+	if (wscArg == L"clear") {
+		TracebackClear();
+		classptr->Print(L"OK\n");
+		return true;
+	}
+	if (!wscArg.empty()) {
+		uint iIndex = wcstoul(wscArg.c_str(), NULL, 10);
+		if (iIndex >= vTracebackErrors.size()) {
+			classptr->Print(L"ERR No such error\n");
+			return true;
+		}
+		TB_ERROR &error = vTracebackErrors[iIndex];
+		classptr->Print(L"#%u %ux (%s) %s\n", iIndex, error.iCount, stows(error.scEvent).c_str(), error.wscError.c_str());
+		for (uint i = 0; i < error.vSamples.size(); i++) {
+			FormatSample(error.vSamples[i]); // if the tick hasn't got to it yet
+			classptr->Print(L"%s", error.vSamples[i].wscFormatted.c_str());
+		}
+		classptr->Print(L"OK\n");
+		return true;
+	}
+	mstime tmNow = timeInMS();
+	for (uint i = 0; i < vTracebackErrors.size(); i++) {
+		TB_ERROR &error = vTracebackErrors[i];
+		classptr->Print(L"#%u %ux last %us ago (%s) %s\n", i, error.iCount, (uint)((tmNow - error.tmLast) / 1000),
+			stows(error.scEvent).c_str(), error.wscError.c_str());
+	}
+	if (iTracebackOther)
+		classptr->Print(L"%u more not tracked\n", iTracebackOther);
+	classptr->Print(L"OK\n");
+	return true;
+}
+
+// tuple of (event, error, count, first_ms_ago, last_ms_ago, tracebacks)
+PyObject* TracebackErrors()
+{
+	mstime tmNow = timeInMS();
+	PyObject *pErrors = PyTuple_New(vTracebackErrors.size());
+	for (uint i = 0; i < vTracebackErrors.size(); i++) {
+		TB_ERROR &error = vTracebackErrors[i];
+		PyObject *pTracebacks = PyTuple_New(error.vSamples.size());
+		for (uint j = 0; j < error.vSamples.size(); j++) {
+			FormatSample(error.vSamples[j]);
+			PyTuple_SET_ITEM(pTracebacks, j, PyString_FromString(wstos(error.vSamples[j].wscFormatted).c_str()));
+		}
+		PyTuple_SET_ITEM(pErrors, i, Py_BuildValue("(ssIKKN)", error.scEvent.c_str(), wstos(error.wscError).c_str(), error.iCount,
+			tmNow - error.tmFirst, tmNow - error.tmLast, pTracebacks));
+	}
+	return pErrors;
+}
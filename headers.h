@@ -7,15 +7,18 @@
 #include <time.h>
 //#include <math.h>
 #include <list>
+#include <vector>
 //#include <map>
 //#include <algorithm>
 #include <FLHook.h>
 #include <plugin.h>
 #include <Python.h>
+#include "FLHookNative.h"
 
 using namespace std;
 
 extern bool g_bEnabled;
+extern PLUGIN_RETURNCODE returncode;
 
 extern PyObject *pModule; // freelancer.embedded python module
 extern PyObject *pCallback; // Our python callback function
@@ -44,10 +47,8 @@ extern PyObject *pClassConverter; // struct/class to namedtuple function
 	pointer_type *ptr = (pointer_type*)PyCapsule_GetPointer(pPtr, NULL)
 
 // logging macro print to log and console, so we dont have to dig through logs to find errors while testing....
-#define ERRMSG(text) \
-	wstring wscError = text; \
-	ConPrint(wscError + L"\n"); \
-	AddLog( wstos(wscError).c_str() )
+// (through the log thread, repeats are suppressed, see Logging.cpp)
+#define ERRMSG(text) LogWrite(LOG_ERROR, text)
 
 #define CHECK_AND_DISABLE(text) \
 	if (CheckPyException()) { \
@@ -62,13 +63,162 @@ extern PyObject *pClassConverter; // struct/class to namedtuple function
 		g_bEnabled = false; \
 	} \
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+BEFORE/AFTER hook pairs - the argument tuple built for a BEFORE hook is kept and handed to the matching
+AFTER hook, as long as the raw hook arguments (the HOOK_KEY) are byte for byte the same.
+*/
+enum HOOK_PAIR
+{
+	HKP_SubmitChat,
+	HKP_PlayerLaunch,
+	HKP_FireWeapon,
+	HKP_SPMunitionCollision,
+	HKP_SPObjUpdate,
+	HKP_SPObjCollision,
+	HKP_LaunchComplete,
+	HKP_BaseEnter,
+	HKP_BaseExit,
+	HKP_OnConnect,
+	HKP_DisConnect,
+	HKP_TerminateTrade,
+	HKP_InitiateTrade,
+	HKP_ActivateEquip,
+	HKP_ActivateCruise,
+	HKP_ActivateThrusters,
+	HKP_GFGoodSell,
+	HKP_CharacterInfoReq,
+	HKP_JumpInComplete,
+	HKP_SystemSwitchOutComplete,
+	HKP_MineAsteroid,
+	HKP_GoTradelane,
+	HKP_AbortMission,
+	HKP_AcceptTrade,
+	HKP_AddTradeEquip,
+	HKP_BaseInfoRequest,
+	HKP_DelTradeEquip,
+	HKP_GFGoodBuy,
+	HKP_GFObjSelect,
+	HKP_Hail,
+	HKP_InterfaceItemUsed,
+	HKP_JettisonCargo,
+	HKP_LocationEnter,
+	HKP_LocationExit,
+	HKP_LocationInfoRequest,
+	HKP_MissionResponse,
+	HKP_ReqChangeCash,
+	HKP_ReqHullStatus,
+	HKP_ReqRemoveItem,
+	HKP_ReqSetCash,
+	HKP_ReqShipArch,
+	HKP_RequestCancel,
+	HKP_RequestCreateShip,
+	HKP_RequestEvent,
+	HKP_RequestTrade,
+	HKP_SPRequestInvincibility,
+	HKP_SPScanCargo,
+	HKP_SetManeuver,
+	HKP_SetTarget,
+	HKP_SetTradeMoney,
+	HKP_StopTradeRequest,
+	HKP_AddDmgEntry,
+	HKP_COUNT
+};
+
+// raw copy of a hooks arguments. if they dont fit the key is invalid and never matches (AFTER always rebuilds).
+// only pass values: for a pointer argument pass HookKeyHash() of the data it points to, or the fields converted
+#define HOOK_KEY_SIZE 64
+#define HOOK_KEY_INVALID 0xFFFFFFFF
+struct HOOK_KEY
+{
+	uint iSize;
+	unsigned char data[HOOK_KEY_SIZE];
+	HOOK_KEY() : iSize(0) {}
+};
+
+inline void HookKeyAdd(HOOK_KEY &key) {}
+template <class T, class... Rest> void HookKeyAdd(HOOK_KEY &key, const T &value, const Rest&... rest)
+{
+	if (key.iSize == HOOK_KEY_INVALID)
+		return;
+	if (key.iSize + sizeof(T) > HOOK_KEY_SIZE) {
+		key.iSize = HOOK_KEY_INVALID;
+		return;
+	}
+	memcpy(key.data + key.iSize, &value, sizeof(T));
+	key.iSize += sizeof(T);
+	HookKeyAdd(key, rest...);
+}
+template <class... Args> HOOK_KEY HookKey(const Args&... args)
+{
+	HOOK_KEY key;
+	HookKeyAdd(key, args...);
+	return key;
+}
+// 64 bit FNV-1a of iSize bytes at pData, for hook arguments that point to a buffer
+inline unsigned __int64 HookKeyHash(const void *pData, uint iSize)
+{
+	unsigned __int64 iHash = 14695981039346656037ULL;
+	for (uint i = 0; i < iSize; i++)
+		iHash = (iHash ^ ((const unsigned char*)pData)[i]) * 1099511628211ULL;
+	return iHash;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*
 Converters.cpp
 */
-PyObject* pyConstConverter(string scStructName, PyObject *pData);
-PyObject* pyClassConverter(string scClassName, void *ptr);
+PyObject* pyConstConverter(const char *szStructName, PyObject *pData);
+PyObject* pyClassConverter(const char *szClassName, void *ptr);
+
+// reusable argument tuples - see pyTupleAcquire
+struct PY_ARGS
+{
+	PyObject *pTuple;
+};
+struct MARSHAL_STATS
+{
+	uint iTuplesReused;
+	uint iTuplesAllocated;
+	uint iIDHits;
+	uint iIDMisses;
+	uint iStringHits;
+	uint iStringMisses;
+};
+extern MARSHAL_STATS MarshalStats;
+
+PyObject* pyTupleAcquire(PY_ARGS &args, Py_ssize_t iSize);
+void pyTupleRelease(PY_ARGS &args);
+PyObject* TupleReuseCheck(uint iEvents);
+PyObject* pyString(const char *szString);
+PyObject* pyID(uint iID);
+void ClearMarshalCache();
+inline PyObject* pyInt(long iValue) { return PyInt_FromLong(iValue); }
+inline PyObject* pyFloat(double fValue) { return PyFloat_FromDouble(fValue); }
+inline PyObject* pyBool(bool bValue) { PyObject *pBool = PY_BOOL(bValue); Py_INCREF(pBool); return pBool; }
+
+// builds a tuple from new references (stolen like N in Py_BuildValue), reusing args.pTuple when we can
+template <class... Items> PyObject* pyTuple(PY_ARGS &args, Items... items)
+{
+	PyObject *pItems[] = { items... };
+	const Py_ssize_t iSize = sizeof...(items);
+	bool bFailed = false;
+	for (Py_ssize_t i = 0; i < iSize; i++) {
+		if (pItems[i] == NULL)
+			bFailed = true;
+	}
+	PyObject *pTuple = bFailed ? NULL : pyTupleAcquire(args, iSize);
+	if (pTuple == NULL) {
+		for (Py_ssize_t i = 0; i < iSize; i++)
+			Py_XDECREF(pItems[i]);
+		return NULL;
+	}
+	for (Py_ssize_t i = 0; i < iSize; i++)
+		PyTuple_SET_ITEM(pTuple, i, pItems[i]);
+	return pTuple;
+}
 wstring pytows(PyObject *pObj);
+wstring pyunitows(PyObject *pObj);
 string pytos(PyObject *pObj);
 PyObject* ToPython(wstring wscString);
 PyObject* ToPython(Vector* hkInfo);
@@ -113,13 +263,528 @@ EmbeddedMethods.cpp
 */
 void BuildEmbedded();
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+GCSchedule.cpp
+*/
+#define GC_HISTOGRAM_SIZE 10
+
+struct GC_POLICY
+{
+	bool bManaged; // automatic collection disabled, collections run at tick boundaries
+	int iThreshold0; // gen 0 count before a gen 0 collection is wanted
+	int iThreshold1; // gen 0 collections before a gen 1 collection is wanted
+	float fFullInterval; // seconds between full (gen 2) collections, 0 to never force them
+};
+
+struct GC_STATS
+{
+	uint iCollections[3];
+	uint iHistogram[3][GC_HISTOGRAM_SIZE]; // pause times per generation, see GC_BUCKETS_MS
+	double dMaxPause[3]; // ms
+	uint iForced; // collections run without slack
+	uint iDeferred; // ticks a wanted collection was postponed
+};
+
+extern GC_POLICY GCPolicy;
+extern GC_STATS GCStats;
+extern const double GC_BUCKETS_MS[GC_HISTOGRAM_SIZE - 1];
+
+void StartGC();
+void StopGC();
+void SetGCPolicy(const GC_POLICY &policy);
+void GCTickStart();
+void GCTickEnd();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+KillLedger.cpp
+*/
+struct KILL_LEDGER_POLICY
+{
+	bool bEnabled;
+	float fHalfLife; // seconds, damage booked on a victim halves every fHalfLife, 0 for no decay
+	float fExpiry; // seconds after the last hit an inflictor no longer counts
+};
+
+extern KILL_LEDGER_POLICY KillLedgerPolicy;
+
+void KillLedgerMunition(uint iClientID, const SSPMunitionCollisionInfo &ci);
+void KillLedgerDamage(DamageList *dmg, unsigned short iSubObj, float fHealth);
+void KillLedgerDestroyed(DamageList *dmg, uint iVictim, uint iVictimClientID, bool bKill);
+void KillLedgerPrune();
+void SetKillLedgerPolicy(const KILL_LEDGER_POLICY &policy);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+LeakSentinel.cpp
+*/
+#define LEAK_MAX_WINDOW 16
+#define LEAK_MAX_REPORTS 32
+
+struct LEAK_SENTINEL
+{
+	bool bEnabled;
+	uint iInterval; // seconds between samples
+	uint iWindow; // samples a type has to keep growing before its reported
+	Py_ssize_t iRefGrowth; // total refcount growth over the last sample, debug builds only
+};
+
+struct LEAK_SUSPECT
+{
+	string scEvent;
+	double dCorrelation;
+	double dPerCall; // objects gained per call
+};
+
+struct LEAK_REPORT
+{
+	string scType;
+	int iGrowth; // over the window
+	list<LEAK_SUSPECT> lstSuspects; // best correlation first
+};
+
+extern LEAK_SENTINEL LeakSentinel;
+
+bool SetLeakSentinel(bool bEnabled, uint iInterval, uint iWindow);
+void StopLeakSentinel();
+void LeakCountEvent(const char *szEvent);
+void LeakTick();
+list<LEAK_REPORT>& GetLeakReports();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+NativeHandlers.cpp
+*/
+struct NATIVE_HANDLER
+{
+	PyObject *pCapsule;
+	FLHOOK_NATIVE_HANDLER_INFO *pInfo; // NULL if no handler is registered
+	uint iCalls;
+	uint iPython; // calls that fell back to python
+};
+
+extern NATIVE_HANDLER NativeHandlers[FNE_COUNT];
+
+// For Hook callbacks with a native handler - returns if the handler doesnt want python called
+#define NATIVE_CHECK(event, client_id, data) \
+	if (NativeHandlers[event].pInfo && !CallNative(event, client_id, (void*)(data))) return
+
+int GetNativeEvent(const string &scEvent);
+const char* GetNativeEventName(int iEvent);
+void SetNativeHandler(int iEvent, PyObject *pCapsule);
+void ClearNativeHandlers();
+bool CallNative(FLHOOK_NATIVE_EVENT iEvent, uint iClientID, void *pData);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Payload.cpp
+*/
+void InitPayloadType(PyObject *pHook);
+PyObject* pyPayload(const void *pData, uint iSize);
+void pyPayloadRelease(PyObject *pPayload);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+MathTypes.cpp
+*/
+void InitMathTypes(PyObject *pHook);
+PyObject* pyVec3(const Vector &v);
+bool pyToVector(PyObject *pObj, Vector &v);
+bool pyToPoints(PyObject *pObj, vector<float> &vStorage, const float *&pPoints, uint &iCount);
+void MathDistances(const Vector &vFrom, const float *pPoints, uint iCount, float *pOut);
+uint MathWithinRange(const Vector &vFrom, float fRange, const float *pPoints, uint iCount, vector<uint> &vIndices);
+void MathNormalize(const float *pPoints, uint iCount, float *pOut);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+DamageBatch.cpp
+*/
+extern bool bDamageBatching;
+
+void DamageBatchAdd(DamageList *dmg, unsigned short iSubObj, float fHealth, DamageEntry::SubObjFate fate);
+void DamageBatchFlush();
+void SetDamageObserver(bool bEnabled);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+RateLimiter.cpp
+*/
+#define RATE_SLOTS 16 // custom buckets and cooldowns per client
+
+enum RATE_EVENT
+{
+	RLE_SubmitChat,
+	RLE_UserCmd,
+	RLE_RequestEvent,
+	RLE_InitiateTrade,
+	RLE_COUNT
+};
+
+enum RATE_ACTION
+{
+	RLA_DROP,
+	RLA_VETO,
+	RLA_FLAG
+};
+
+struct RATE_LIMIT
+{
+	bool bEnabled;
+	float fRate; // tokens per second
+	float fBurst;
+	RATE_ACTION action;
+	uint iLimited; // events over the limit
+	bool bDropped[MAX_CLIENT_ID + 1]; // the BEFORE hook was dropped, so drop the AFTER too
+	bool bFlagged[MAX_CLIENT_ID + 1]; // RLA_FLAG went over the limit, until the AFTER hook is done
+	uint iClientID; // of the last check, IsRateLimited() answers for it
+};
+
+extern RATE_LIMIT RateLimits[RLE_COUNT];
+
+// For Hook callbacks - returns if the client is over the limit (and the action isnt RLA_FLAG)
+#define RATE_CHECK(event, client_id) \
+	if (RateLimits[event].bEnabled && !RateLimitCheck(event, client_id)) return
+
+#define RATE_CHECK_AFTER(event, client_id) \
+	if (RateLimits[event].bEnabled && (client_id) <= MAX_CLIENT_ID && RateLimits[event].bDropped[client_id]) return
+
+// at the end of the AFTER hook, the call is done
+#define RATE_CLEAR(event, client_id) \
+	if ((client_id) <= MAX_CLIENT_ID) RateLimits[event].bFlagged[client_id] = false
+
+int GetRateEvent(const string &scEvent);
+const char* GetRateEventName(int iEvent);
+void SetRateLimit(RATE_EVENT event, float fRate, float fBurst, RATE_ACTION action);
+bool RateLimitCheck(RATE_EVENT event, uint iClientID);
+bool RateLimitFlagged(const char *szEvent);
+bool RateLimitCustom(uint iClientID, const char *szKey, float fRate, float fBurst);
+uint RateCooldown(uint iClientID, const char *szKey, uint iMS);
+void RateLimitClearClient(uint iClientID);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Admission.cpp
+*/
+#define ADM_BLOOM_K 4 // probes per account in the bloom filter
+
+enum ADM_VERDICT
+{
+	ADM_NONE, // no rule
+	ADM_ALLOW,
+	ADM_REJECT,
+	ADM_FLAG // let in, but report to python (rate action only)
+};
+
+struct ADMISSION_STATS
+{
+	uint iAdmitted;
+	uint iRejectedIP;
+	uint iRejectedAccount;
+	uint iRejectedRate;
+	uint iFlagged;
+	uint iBloomHits; // logins that had to check the account set
+	uint iBloomFalsePositives;
+	uint iIPRules;
+	uint iAccounts;
+};
+
+extern ADMISSION_STATS AdmissionStats;
+
+bool AdmissionAddIP(const wstring &wscCIDR, ADM_VERDICT verdict);
+void AdmissionBanAccount(const wstring &wscAccount, bool bBanned);
+void AdmissionSetRate(uint iMax, uint iWindow, ADM_VERDICT action);
+void AdmissionClear();
+int AdmissionLoad(const string &scPath);
+bool AdmissionConnect(uint iClientID);
+bool AdmissionLogin(const wstring &wscAccount, uint iClientID);
+bool AdmissionRejected(uint iClientID);
+void AdmissionDisconnect(uint iClientID);
+
+// per client hooks, dont tell python about a client rejected at admission
+#define ADMISSION_CHECK(client_id) \
+	if (AdmissionRejected(client_id)) return
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ChatFilter.cpp
+*/
+enum CF_ACTION // most severe first
+{
+	CFA_BLOCK,
+	CFA_MASK,
+	CFA_FLAG
+};
+
+struct CHAT_FILTER_STATS
+{
+	uint iPatterns;
+	uint iNodes;
+	uint iChecked;
+	uint iBlocked;
+	uint iMasked;
+	uint iFlagged;
+};
+
+extern CHAT_FILTER_STATS ChatFilterStats;
+
+void ChatFilterAdd(const wstring &wscPattern, CF_ACTION action, bool bWholeWord);
+void ChatFilterClear();
+bool ChatFilterApply(uint iClientID, wchar_t *wszText, const void *rdlReader, ulong lSize);
+bool ChatFilterBlocked(uint iClientID);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Channels.cpp
+*/
+enum CH_FILTER
+{
+	CHF_MEMBERS,
+	CHF_ALL,
+	CHF_SYSTEM,
+	CHF_AFFILIATION
+};
+
+void ChannelCreate(const string &scName, CH_FILTER filter, uint iFilterValue);
+bool ChannelDelete(const string &scName);
+bool ChannelJoin(const string &scName, uint iClientID, bool bJoin);
+bool ChannelRecipients(const string &scName, list<uint> &lstRecipients);
+int ChannelSend(const string &scName, uint iSenderID, const wstring &wscText, bool bXML);
+void ChannelClearClient(uint iClientID);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Outbox.cpp
+*/
+struct OUTBOX_STATS
+{
+	uint iQueued; // messages
+	uint iSent; // merged messages sent
+};
+
+extern bool bOutbox;
+extern OUTBOX_STATS OutboxStats;
+
+HK_ERROR OutboxQueue(uint iClientID, const wstring &wscXML);
+HK_ERROR OutboxQueueText(uint iClientID, const wstring &wscText, bool bUserCmd);
+void OutboxFlush(uint iClientID);
+void OutboxClearClient(uint iClientID);
+void SetOutbox(bool bEnabled);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+MessageTemplates.cpp
+*/
+bool MessageTemplateRegister(const string &scName, const wstring &wscXML);
+bool MessageTemplateRemove(const string &scName);
+bool MessageTemplateRender(const string &scName, PyObject *pParams, wstring &wscXML);
+int MessageTemplateSend(const wstring &wscXML, const list<uint> &lstClients);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+PlayerQuery.cpp
+*/
+enum PLAYER_QUERY_FIELD
+{
+	PQF_CLIENT_ID,
+	PQF_CHARNAME,
+	PQF_SYSTEM,
+	PQF_BASE,
+	PQF_SHIP,
+	PQF_SHIP_ARCH,
+	PQF_IP,
+	PQF_HOSTNAME,
+	PQF_COUNT
+};
+
+int PlayerFieldByName(const char *szName);
+PyObject* PlayerQuery(const list<int> &lstFields, bool bPacked);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Logging.cpp
+*/
+enum LOG_LEVEL
+{
+	LOG_DEBUG,
+	LOG_INFO,
+	LOG_WARN,
+	LOG_ERROR
+};
+
+struct LOG_STATS
+{
+	uint iLines; // LogWrite calls at or above the level
+	uint iSuppressed; // repeats
+	uint iDropped; // ring buffer full
+};
+
+extern LOG_STATS LogStats;
+
+void StartLogging();
+void StopLogging();
+void LogWrite(LOG_LEVEL level, const wstring &wscText);
+void LogWriteLines(LOG_LEVEL level, const wstring &wscText);
+void LogTick();
+void SetLogLevel(LOG_LEVEL level);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Tracebacks.cpp
+*/
+void TracebackRecord(const char *szEvent, const wstring &wscError, PyObject *pType, PyObject *pValue, PyObject *pTraceback);
+void TracebackTick();
+void TracebackClear();
+void SetTracebackSamples(uint iSamples);
+bool TracebackAdminCmd(CCmds *classptr, const wstring &wscCmd);
+PyObject* TracebackErrors();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Store.cpp
+*/
+void InitStoreType(PyObject *pHook);
+PyObject* pyStore(const string &scName);
+void StoreTick();
+void StopStores();
+PyObject* StoreCheck(uint iRecords);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+IniCache.cpp
+*/
+struct INI_CACHE_STATS
+{
+	uint iHits; // files served from the cache
+	uint iMisses; // files read and parsed
+	uint iInvalidated; // dropped because FL wrote the character file
+};
+
+extern INI_CACHE_STATS IniCacheStats;
+
+PyObject* IniRead(const string &scPath);
+PyObject* IniValues(const string &scPath, const string &scSection, const string &scKey);
+PyObject* IniReadChar(const wstring &wscCharname);
+void IniCacheInvalidateChar(const wstring &wscCharname);
+void IniCacheInvalidateClient(uint iClientID);
+void IniCacheClear();
+uint IniCacheSize();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+AsyncIO.cpp
+*/
+struct ASYNC_STATS
+{
+	uint iSavesQueued; // SaveCharAsync calls
+	uint iSaves; // saves done
+	uint iWritesQueued; // WriteFileAsync calls
+	uint iWrites; // files written
+	uint iMerged; // requests collapsed into another
+	uint iFailed; // saves and writes
+};
+
+extern ASYNC_STATS AsyncStats;
+
+void SaveCharAsync(const wstring &wscCharname, uint iWindow);
+void SaveCharAsyncFlushClient(uint iClientID);
+void WriteFileAsync(const string &scPath, const string &scData, bool bAppend);
+void AsyncTick();
+void AsyncShutdown();
+uint AsyncPending();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Batch.cpp
+*/
+PyObject* BatchAddCash(PyObject *pItems);
+PyObject* BatchSetRep(PyObject *pItems);
+PyObject* BatchAddCargo(PyObject *pItems);
+PyObject* BatchMsg(PyObject *pItems);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ChangeFeed.cpp
+*/
+enum CHANGE_FIELD
+{
+	CHG_CONNECTED,
+	CHG_SYSTEM,
+	CHG_BASE,
+	CHG_SHIP,
+	CHG_POSITION,
+	CHG_CASH,
+	CHG_COUNT
+};
+
+extern bool bChangeFeed;
+
+void SetChangeFeed(bool bEnabled, float fBucket);
+void ChangeFeedSet(uint iClientID, CHANGE_FIELD field, uint iValue);
+void ChangeFeedDirty(uint iClientID, CHANGE_FIELD field);
+void ChangeFeedPosition(uint iClientID, const Vector &vPos);
+void ChangeFeedDisconnect(uint iClientID);
+void ChangeFeedFlush();
+PyObject* ChangeFeedRead(unsigned __int64 iCursor, uint iMax);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ShipRegistry.cpp
+*/
+struct SHIP_ENTRY
+{
+	uint iShip; // 0 for a free slot
+	uint iArchID;
+	uint iClientID; // 0 for npcs
+	uint iSystem;
+	mstime tmSpawn;
+};
+
+extern bool bShipEvents;
+
+const SHIP_ENTRY* ShipRegistryFind(uint iShip);
+void ShipRegistryAdd(uint iShip, uint iArchID, uint iClientID, uint iSystem);
+void ShipRegistryRemove(uint iShip);
+void ShipRegistrySetOwner(uint iShip, uint iClientID);
+void ShipRegistryClearClient(uint iClientID);
+uint ShipRegistryCount();
+bool ShipRegistrySystemCounts(uint iSystem, uint &iNPCs, uint &iPlayers);
+PyObject* ShipRegistryAllCounts();
+void ShipRegistryInSystem(uint iSystem, int iPlayers, list<uint> &lstShips);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+Sequences.cpp
+*/
+extern bool bSequenceTracking;
+
+void SetSequenceTracking(bool bEnabled, bool bOutcomesOnly);
+void SequenceClearClient(uint iClientID);
+void SequenceInitiateTrade(uint iClientID1, uint iClientID2);
+void SequenceTradeEquip(uint iClientID, const EquipDesc &ed, bool bAdd);
+void SequenceTradeMoney(uint iClientID, unsigned long iMoney);
+void SequenceTerminateTrade(uint iClientID, int iAccepted);
+void SequenceLocationExit(uint iClientID);
+void SequenceBaseExit(uint iBaseID, uint iClientID);
+void SequencePlayerLaunch(uint iShip, uint iClientID);
+void SequenceLaunchComplete(uint iBaseID, uint iShip);
+bool SequenceMutedTrade(uint iClientID);
+bool SequenceMutedLaunch(uint iClientID, uint iShip);
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*
 Main.cpp
 */
 bool RaisePyException(HK_ERROR hkErr);
 bool CheckPyException();
-void pyCallback(string scEvent, PyObject *pData);
+void pyCallback(const char *szEvent, PyObject *pData);
+const char* pyCurrentEvent();
+void pyCallbackBefore(HOOK_PAIR hkPair, const char *szEvent, const HOOK_KEY &key, PyObject *pData, bool bMuted = false);
+PyObject* pyPairArgs(HOOK_PAIR hkPair, const HOOK_KEY &key);
+void pyPairDrop(HOOK_PAIR hkPair);
+void pyCallbackAfter(HOOK_PAIR hkPair, const char *szEvent, PyObject *pData);
+bool SetFusedHook(const string &scEvent, bool bFused);
+void ClearHookPairs();
 void StartPython();
 void StopPython();
 
@@ -49,6 +49,54 @@ SKIPPLUGINS_NOFUNCTIONCALL = 2
 NOFUNCTIONCALL = 3
 
 
+#==============================================================================
+# RATE_ACTION (FLHook.SetRateLimit)
+RLA_DROP = 0
+RLA_VETO = 1
+RLA_FLAG = 2
+
+
+#==============================================================================
+# ADM_VERDICT (FLHook.AdmissionAddIP, FLHook.AdmissionSetRate)
+ADM_NONE = 0
+ADM_ALLOW = 1
+ADM_REJECT = 2
+ADM_FLAG = 3
+
+
+#==============================================================================
+# CF_ACTION (FLHook.ChatFilterAdd)
+CFA_BLOCK = 0
+CFA_MASK = 1
+CFA_FLAG = 2
+
+
+#==============================================================================
+# CH_FILTER (FLHook.ChannelCreate)
+CHF_MEMBERS = 0
+CHF_ALL = 1
+CHF_SYSTEM = 2
+CHF_AFFILIATION = 3
+
+
+#==============================================================================
+# CHANGE_FIELD (FLHook.ReadChanges)
+CHG_CONNECTED = 0
+CHG_SYSTEM = 1
+CHG_BASE = 2
+CHG_SHIP = 3
+CHG_POSITION = 4
+CHG_CASH = 5
+
+
+#==============================================================================
+# LOG_LEVEL (FLHook.Log, FLHook.SetLogLevel)
+LOG_DEBUG = 0
+LOG_INFO = 1
+LOG_WARN = 2
+LOG_ERROR = 3
+
+
 #==============================================================================
 # ENGINE_STATE
 ES_CRUISE = 0